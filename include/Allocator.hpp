@@ -0,0 +1,94 @@
+#ifndef __HARUPP_ALLOCATOR_HPP__
+#define __HARUPP_ALLOCATOR_HPP__
+#include "cstddef"
+
+namespace pdf {
+
+    /**
+     * \class   Allocator
+     * @brief   Represents a memory allocator used by a Document for all of its internal allocations.
+     * @details Pass an allocator to Document::open to route every allocation made by LibHaru for this document through it.
+     *          An allocator must not be used by two open documents at the same time.
+     * @file    Allocator.hpp
+    */
+    class Allocator {
+    public:
+        virtual ~Allocator() noexcept = 0;
+
+        /**
+         * @brief  Allocates a block of memory.
+         * @param  size Size of the block, in bytes.
+         * @return Pointer to the block, suitably aligned for any object type.
+         * @throw  std::bad_alloc if the block could not be allocated. Returning `nullptr` is also allowed.
+        */
+        virtual void* allocate(std::size_t size) = 0;
+
+        /**
+         * @brief Releases a block of memory previously returned by ::allocate.
+         * @param pointer Pointer to the block.
+        */
+        virtual void deallocate(void* pointer) noexcept = 0;
+
+        /**
+         * @brief   Releases everything allocated so far at once.
+         * @details This is called by Document::close once the document has been freed. Does nothing by default.
+        */
+        virtual void reset() noexcept;
+    };
+
+    /**
+     * \class   MemoryArena
+     * @brief   Represents a bump allocator that frees all of its memory at once.
+     * @details Allocations are carved out of large blocks and ::deallocate does nothing, so that allocating is cheap and
+     *          does not touch the global heap lock. All the memory is released by ::reset, which is called when the
+     *          owning Document is closed. The first block is kept to be reused by the next document.
+     * @note    Use one arena per thread (or per document) as this class is not thread safe.
+     * @file    Allocator.hpp
+    */
+    class MemoryArena final: public Allocator {
+        struct Block;
+        Block* blocks = nullptr;
+        std::size_t blockSize;
+        std::size_t usedSize = 0U;
+        std::size_t reservedSize = 0U;
+
+    public:
+
+        /**
+         * @brief Creates a new MemoryArena.
+         * @param blockSize Size of the blocks requested from the system. Larger allocations get a block of their own.
+        */
+        explicit MemoryArena(std::size_t blockSize = 65536U) noexcept;
+
+        /**
+         * @brief Frees all the blocks.
+        */
+        ~MemoryArena() noexcept;
+
+        MemoryArena(const MemoryArena&) = delete;
+        MemoryArena& operator=(const MemoryArena&) = delete;
+
+        void* allocate(std::size_t size) override;
+
+        /**
+         * @brief Does nothing, memory is only released by ::reset.
+        */
+        void deallocate(void* pointer) noexcept override;
+
+        void reset() noexcept override;
+
+        /**
+         * @brief  Gets the number of bytes handed out since the last reset.
+         * @return Number of bytes used, alignment padding included.
+        */
+        std::size_t getUsedSize() const noexcept;
+
+        /**
+         * @brief  Gets the number of bytes currently requested from the system.
+         * @return Number of bytes reserved.
+        */
+        std::size_t getReservedSize() const noexcept;
+    };
+}
+
+#endif // __HARUPP_ALLOCATOR_HPP__
@@ -13,7 +13,7 @@ namespace pdf {
      * @date   2023-05-16
     */
     class Annotation: public ContentStream {
-        explicit Annotation(_HPDF_Dict_Rec* content) noexcept;
+        explicit Annotation(_HPDF_Dict_Rec* content, const std::atomic<unsigned int>* generation = nullptr) noexcept;
         friend class LinkAnnotation;
         friend class TextAnnotation;
 
@@ -0,0 +1,162 @@
+#ifndef __HARUPP_BATCHRENDERER_HPP__
+#define __HARUPP_BATCHRENDERER_HPP__
+#include "Document.hpp"
+#include "ThreadPool.hpp"
+#include "atomic"
+#include "chrono"
+#include "functional"
+#include "future"
+#include "optional"
+#include "string"
+#include "vector"
+
+namespace pdf {
+
+    /**
+     * \class  RenderResult
+     * @brief  Represents the outcome of a job run by a BatchRenderer.
+     * @note   Note that this class cannot be instantiated manually. Rather, it is created by BatchRenderer::submit.
+     * @file   BatchRenderer.hpp
+    */
+    class RenderResult final: public Object {
+        std::size_t jobId = 0U;
+        bool successful = false;
+        unsigned long errorCode = 0U;
+        unsigned long detailCode = 0U;
+        std::string errorMessage;
+        std::vector<unsigned char> output;
+        std::chrono::nanoseconds waitTime{0};
+        std::chrono::nanoseconds renderTime{0};
+        friend class BatchRenderer;
+
+    public:
+
+        /**
+         * @brief Creates a new empty RenderResult.
+        */
+        RenderResult() noexcept;
+
+        /**
+         * @brief  Gets the job identifier, in submission order.
+         * @return Job identifier.
+        */
+        std::size_t getJobId() const noexcept;
+
+        /**
+         * @brief  Checks whether the job ran without throwing.
+         * @return `true` if the job succeeded, `false` otherwise.
+        */
+        bool isSuccessful() const noexcept;
+
+        /**
+         * @brief  Gets the error code of the exception thrown by the job.
+         * @return excepts::Exception error code, or `0` if the job succeeded or threw another kind of exception.
+        */
+        unsigned long getErrorCode() const noexcept;
+
+        /**
+         * @brief  Gets the detail code of the exception thrown by the job.
+         * @return excepts::Exception detail code, or `0` if the job succeeded or threw another kind of exception.
+        */
+        unsigned long getDetailCode() const noexcept;
+
+        /**
+         * @brief  Gets the message of the exception thrown by the job.
+         * @return Error message, or an empty string if the job succeeded.
+        */
+        const std::string& getErrorMessage() const noexcept;
+
+        /**
+         * @brief  Gets the saved document.
+         * @return Bytes of the pdf document. Empty if the job failed, if output collection is disabled, or if the job
+         *         revoked the document itself (e.g. with Document::endStreaming).
+        */
+        const std::vector<unsigned char>& getOutput() const noexcept;
+
+        /**
+         * @brief  Moves the saved document out of the result.
+         * @return Bytes of the pdf document. The result output is empty afterwards.
+        */
+        std::vector<unsigned char> takeOutput() noexcept;
+
+        /**
+         * @brief  Gets the time the job spent in the queue.
+         * @return Time between the submission and the start of the job.
+        */
+        std::chrono::nanoseconds getWaitTime() const noexcept;
+
+        /**
+         * @brief  Gets the time the job took to run.
+         * @return Time spent rendering and saving the document.
+        */
+        std::chrono::nanoseconds getRenderTime() const noexcept;
+
+        /**
+         * @brief  Checks whether the result is empty.
+         * @return `true` if the job has not produced any output, `false` otherwise.
+        */
+        bool isEmpty() const noexcept override;
+    };
+
+    /**
+     * \class   BatchRenderer
+     * @brief   Represents a renderer running many independent document jobs in parallel.
+     * @details Jobs run on a work-stealing ThreadPool. Each job gets its own freshly opened Document, allocated from a
+     *          MemoryArena owned by the worker thread, so that jobs neither share LibHaru state nor contend on the global
+     *          heap. Exceptions thrown by a job are caught and reported in its RenderResult.
+     * @note    A Document must not be shared between jobs. Objects such as Page or Font are only valid during their job.
+     * @file    BatchRenderer.hpp
+    */
+    class BatchRenderer final {
+    public:
+        /// Function rendering a job into its document.
+        typedef std::function<void(Document&)> RenderFunction;
+
+    private:
+        ThreadPool pool;
+        std::atomic<std::size_t> nextJobId{0U};
+        bool collectOutput;
+
+        ThreadPool::Task __makeTask(RenderFunction&& render, std::shared_ptr<std::promise<RenderResult>> promise);
+
+    public:
+
+        /**
+         * @brief Creates a new BatchRenderer.
+         * @param threadCount Number of worker threads. `0` uses the number of hardware threads.
+         * @param queueCapacity Maximum number of jobs waiting to be run before ::submit blocks. `0` means unbounded.
+         * @param collectOutput Whether to save each document into its RenderResult once the job returns.
+        */
+        explicit BatchRenderer(unsigned int threadCount = 0U, std::size_t queueCapacity = 256U, bool collectOutput = true);
+
+        BatchRenderer(const BatchRenderer&) = delete;
+        BatchRenderer& operator=(const BatchRenderer&) = delete;
+
+        /**
+         * @brief  Submits a job, waiting for room in the queue if it is full.
+         * @param  render Function rendering the job. The document is open when it is called.
+         * @return Future receiving the job result.
+        */
+        std::future<RenderResult> submit(RenderFunction render);
+
+        /**
+         * @brief  Submits a job if the queue is not full.
+         * @param  render Function rendering the job. The document is open when it is called.
+         * @return Future receiving the job result, or `std::nullopt` if the queue is full.
+        */
+        std::optional<std::future<RenderResult>> trySubmit(RenderFunction render);
+
+        /**
+         * @brief Waits until every submitted job has been run.
+        */
+        void wait();
+
+        /**
+         * @brief  Gets the number of worker threads.
+         * @return Number of worker threads.
+        */
+        unsigned int getThreadCount() const noexcept;
+    };
+}
+
+#endif // __HARUPP_BATCHRENDERER_HPP__
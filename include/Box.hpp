@@ -3,6 +3,7 @@
 #include "Object.hpp"
 
 namespace pdf {
+    class TransposeMatrix;
 
     /**
      * \class  Box
@@ -62,6 +63,14 @@ namespace pdf {
          * @return Top component.
         */
         float getTop() const noexcept;
+
+        /**
+         * @brief  Transforms the box by a matrix.
+         * @note   The result is the smallest box holding the four transformed corners.
+         * @param  matrix TransposeMatrix to apply.
+         * @return Transformed box.
+        */
+        Box transform(const TransposeMatrix& matrix) const noexcept;
     };
 }
 
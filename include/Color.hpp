@@ -1,5 +1,6 @@
 #ifndef __HARUPP_COLOR_HPP__
 #define __HARUPP_COLOR_HPP__
+#include "ColorValue.hpp"
 #include "Object.hpp"
 
 namespace pdf {
@@ -81,6 +82,18 @@ namespace pdf {
         */
         CMYKColor(float c, float m, float y, float k) noexcept;
 
+        /**
+         * @brief Creates a new CMYKColor from a CMYKValue.
+         * @param value CMYKValue to use.
+        */
+        CMYKColor(const CMYKValue& value) noexcept;
+
+        /**
+         * @brief  Converts the color to a CMYKValue, which has no virtual function.
+         * @return CMYKValue of the color.
+        */
+        operator CMYKValue() const noexcept;
+
         /**
          * @brief  Gets the cyan component, between `0.0` and `1.0`.
          * @return Cyan component.
@@ -171,6 +184,18 @@ namespace pdf {
         */
         RGBColor(float r, float g, float b) noexcept;
 
+        /**
+         * @brief Creates a new RGBColor from a RGBValue.
+         * @param value RGBValue to use.
+        */
+        RGBColor(const RGBValue& value) noexcept;
+
+        /**
+         * @brief  Converts the color to a RGBValue, which has no virtual function.
+         * @return RGBValue of the color.
+        */
+        operator RGBValue() const noexcept;
+
         /**
          * @brief  Gets the red component, between `0.0` and `1.0`.
          * @return Red component.
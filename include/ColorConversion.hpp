@@ -0,0 +1,101 @@
+#ifndef __HARUPP_COLORCONVERSION_HPP__
+#define __HARUPP_COLORCONVERSION_HPP__
+#include "Color.hpp"
+#include "Enums.hpp"
+#include "cstddef"
+#include "vector"
+
+namespace pdf::utils {
+
+    /**
+     * @brief Converts RGBColor objects to CMYKColor objects.
+     * @param colors Colors to convert.
+     * @param results Converted colors, `count` of them.
+     * @param count Number of colors.
+    */
+    void convertRGBToCMYK(const RGBColor* colors, CMYKColor* results, std::size_t count) noexcept;
+
+    /**
+     * @brief Converts CMYKColor objects to RGBColor objects.
+     * @param colors Colors to convert.
+     * @param results Converted colors, `count` of them.
+     * @param count Number of colors.
+    */
+    void convertCMYKToRGB(const CMYKColor* colors, RGBColor* results, std::size_t count) noexcept;
+
+    /**
+     * @brief Converts RGBValue colors to CMYKValue colors.
+     * @param colors Colors to convert.
+     * @param results Converted colors, `count` of them.
+     * @param count Number of colors.
+    */
+    void convertRGBToCMYK(const RGBValue* colors, CMYKValue* results, std::size_t count) noexcept;
+
+    /**
+     * @brief Converts CMYKValue colors to RGBValue colors.
+     * @param colors Colors to convert.
+     * @param results Converted colors, `count` of them.
+     * @param count Number of colors.
+    */
+    void convertCMYKToRGB(const CMYKValue* colors, RGBValue* results, std::size_t count) noexcept;
+
+    /**
+     * @brief Converts RGB colors to CMYK colors.
+     * @note  The same math as RGBColor::toCMYK is used.
+     * @param rgb Interleaved red, green and blue components, between `0.0` and `1.0`.
+     * @param cmyk Interleaved cyan, magenta, yellow and black components, `4 * count` of them.
+     * @param count Number of colors.
+    */
+    void convertRGBToCMYK(const float* rgb, float* cmyk, std::size_t count) noexcept;
+
+    /**
+     * @brief Converts CMYK colors to RGB colors.
+     * @note  The same math as CMYKColor::toRGB is used.
+     * @param cmyk Interleaved cyan, magenta, yellow and black components, between `0.0` and `1.0`.
+     * @param rgb Interleaved red, green and blue components, `3 * count` of them.
+     * @param count Number of colors.
+    */
+    void convertCMYKToRGB(const float* cmyk, float* rgb, std::size_t count) noexcept;
+
+    /**
+     * @brief Converts RGB colors to gray levels.
+     * @note  Gray levels are the ITU-R BT.601 luma, `0.299 * r + 0.587 * g + 0.114 * b`.
+     * @param rgb Interleaved red, green and blue components, between `0.0` and `1.0`.
+     * @param gray Gray levels, `count` of them.
+     * @param count Number of colors.
+    */
+    void convertRGBToGray(const float* rgb, float* gray, std::size_t count) noexcept;
+
+    /**
+     * @brief   Converts 8 bits pixels from a color space to another.
+     * @details The conversion runs on AVX2 or NEON when the library is built for them. The result can be given to
+     *          Document::loadRawImageFromMemory with `targetColorSpace`.
+     * @param   pixels Interleaved samples of the pixels.
+     * @param   pixelCount Number of pixels.
+     * @param   colorSpace Color space of `pixels`.
+     * @param   targetColorSpace Color space to convert to.
+     *          Only enums::ColorSpace::DEVICE_GRAY, enums::ColorSpace::DEVICE_RGB and
+     *          enums::ColorSpace::DEVICE_CMYK are allowed for both color spaces.
+     * @return  Converted pixels.
+     * @throw   excepts::InvalidColorSpaceException if a color space is not allowed.
+    */
+    std::vector<unsigned char> convertPixels(
+        const unsigned char* pixels, std::size_t pixelCount,
+        enums::ColorSpace colorSpace, enums::ColorSpace targetColorSpace
+    );
+
+    /**
+     * @brief  Converts 8 bits pixels from a color space to another.
+     * @see    convertPixels(const unsigned char*, std::size_t, enums::ColorSpace, enums::ColorSpace)
+     * @param  pixels Interleaved samples of the pixels, trailing samples not making a whole pixel are ignored.
+     * @param  colorSpace Color space of `pixels`.
+     * @param  targetColorSpace Color space to convert to.
+     * @return Converted pixels.
+     * @throw  excepts::InvalidColorSpaceException if a color space is not allowed.
+    */
+    std::vector<unsigned char> convertPixels(
+        const std::vector<unsigned char>& pixels, enums::ColorSpace colorSpace, enums::ColorSpace targetColorSpace
+    );
+}
+
+#endif // __HARUPP_COLORCONVERSION_HPP__
@@ -0,0 +1,267 @@
+#ifndef __HARUPP_COLORVALUE_HPP__
+#define __HARUPP_COLORVALUE_HPP__
+#include "array"
+#include "cstddef"
+
+namespace pdf {
+    class RGBValue;
+
+    /**
+     * \class   CMYKValue
+     * @brief   Represents a CMYK color as a plain value.
+     * @details Unlike CMYKColor, it has no virtual function, so it is trivially copyable and usable in constant
+     *          expressions. CMYKColor converts from and to it.
+     * @file    ColorValue.hpp
+    */
+    class CMYKValue {
+        float c = 0.f;
+        float m = 0.f;
+        float y = 0.f;
+        float k = 0.f;
+
+    public:
+
+        /**
+         * @brief The white CMYKValue.
+        */
+        constexpr CMYKValue() noexcept = default;
+
+        /**
+         * @brief Creates a new CMYKValue with the given attributes.
+         * @param c Cyan value (`0.0 <= c <= 1.0`).
+         * @param m Magenta value (`0.0 <= m <= 1.0`).
+         * @param y Yellow value (`0.0 <= y <= 1.0`).
+         * @param k Black value (`0.0 <= k <= 1.0`).
+        */
+        constexpr CMYKValue(float c, float m, float y, float k) noexcept: c(c), m(m), y(y), k(k) {}
+
+        /**
+         * @brief  Gets the cyan component, between `0.0` and `1.0`.
+         * @return Cyan component.
+        */
+        constexpr float getC() const noexcept { return c; }
+
+        /**
+         * @brief  Gets the magenta component, between `0.0` and `1.0`.
+         * @return Magenta component.
+        */
+        constexpr float getM() const noexcept { return m; }
+
+        /**
+         * @brief  Gets the yellow component, between `0.0` and `1.0`.
+         * @return Yellow component.
+        */
+        constexpr float getY() const noexcept { return y; }
+
+        /**
+         * @brief  Gets the black component, between `0.0` and `1.0`.
+         * @return Black component.
+        */
+        constexpr float getK() const noexcept { return k; }
+
+        /**
+         * @brief  Converts the color to an RGBValue.
+         * @return RGBValue representation of the color.
+        */
+        constexpr RGBValue toRGB() const noexcept;
+
+        /**
+         * @brief  Returns the same CMYKValue.
+         * @return Current value.
+        */
+        constexpr CMYKValue toCMYK() const noexcept { return *this; }
+
+        /**
+         * @brief  Checks whether two colors are equal.
+         * @return `true` if the colors are equal, `false` otherwise.
+        */
+        constexpr bool operator==(const CMYKValue& other) const noexcept {
+            return c == other.c && m == other.m && y == other.y && k == other.k;
+        }
+
+        /**
+         * @brief  Checks whether two colors are not equal.
+         * @return `true` if the colors are not equal, `false` otherwise.
+        */
+        constexpr bool operator!=(const CMYKValue& other) const noexcept { return !operator==(other); }
+
+        /// White color.
+        static const CMYKValue WHITE;
+        /// Black color.
+        static const CMYKValue BLACK;
+        /// Red color.
+        static const CMYKValue RED;
+        /// Green color.
+        static const CMYKValue GREEN;
+        /// Blue color.
+        static const CMYKValue BLUE;
+        /// Cyan color.
+        static const CMYKValue CYAN;
+        /// Magenta color.
+        static const CMYKValue MAGENTA;
+        /// Yellow color.
+        static const CMYKValue YELLOW;
+        /// Gray color.
+        static const CMYKValue GRAY;
+    };
+
+    /**
+     * \class   RGBValue
+     * @brief   Represents a RGB color as a plain value.
+     * @details Unlike RGBColor, it has no virtual function, so it is trivially copyable and usable in constant
+     *          expressions. RGBColor converts from and to it.
+     * @file    ColorValue.hpp
+    */
+    class RGBValue {
+        float r = 0.f;
+        float g = 0.f;
+        float b = 0.f;
+
+    public:
+
+        /**
+         * @brief The black RGBValue.
+        */
+        constexpr RGBValue() noexcept = default;
+
+        /**
+         * @brief Creates a new RGBValue with the given attributes.
+         * @param r Red component (`0.0 <= r <= 1.0`).
+         * @param g Green component (`0.0 <= g <= 1.0`).
+         * @param b Blue component (`0.0 <= b <= 1.0`).
+        */
+        constexpr RGBValue(float r, float g, float b) noexcept: r(r), g(g), b(b) {}
+
+        /**
+         * @brief  Creates a RGBValue from 8 bits components.
+         * @param  r Red component.
+         * @param  g Green component.
+         * @param  b Blue component.
+         * @return RGBValue of the components divided by `255`.
+        */
+        static constexpr RGBValue fromBytes(unsigned char r, unsigned char g, unsigned char b) noexcept {
+            return RGBValue(r / 255.f, g / 255.f, b / 255.f);
+        }
+
+        /**
+         * @brief  Gets the red component, between `0.0` and `1.0`.
+         * @return Red component.
+        */
+        constexpr float getR() const noexcept { return r; }
+
+        /**
+         * @brief  Gets the green component, between `0.0` and `1.0`.
+         * @return Green component.
+        */
+        constexpr float getG() const noexcept { return g; }
+
+        /**
+         * @brief  Gets the blue component, between `0.0` and `1.0`.
+         * @return Blue component.
+        */
+        constexpr float getB() const noexcept { return b; }
+
+        /**
+         * @brief  Returns the same RGBValue.
+         * @return Current value.
+        */
+        constexpr RGBValue toRGB() const noexcept { return *this; }
+
+        /**
+         * @brief  Converts the color to a CMYKValue.
+         * @return CMYKValue representation of the color.
+        */
+        constexpr CMYKValue toCMYK() const noexcept {
+            float maximum = (r > g)? ((r > b)? r: b): ((g > b)? g: b);
+            if (maximum <= 0.f) return CMYKValue(0.f, 0.f, 0.f, 1.f);
+            return CMYKValue((maximum - r) / maximum, (maximum - g) / maximum, (maximum - b) / maximum, 1.f - maximum);
+        }
+
+        /**
+         * @brief  Interpolates linearly between two colors.
+         * @param  other Color reached when `t` is `1.0`.
+         * @param  t Position between the current color (`0.0`) and `other` (`1.0`).
+         * @return Interpolated color.
+        */
+        constexpr RGBValue mix(const RGBValue& other, float t) const noexcept {
+            return RGBValue(r + (other.r - r) * t, g + (other.g - g) * t, b + (other.b - b) * t);
+        }
+
+        /**
+         * @brief  Checks whether two colors are equal.
+         * @return `true` if the colors are equal, `false` otherwise.
+        */
+        constexpr bool operator==(const RGBValue& other) const noexcept {
+            return r == other.r && g == other.g && b == other.b;
+        }
+
+        /**
+         * @brief  Checks whether two colors are not equal.
+         * @return `true` if the colors are not equal, `false` otherwise.
+        */
+        constexpr bool operator!=(const RGBValue& other) const noexcept { return !operator==(other); }
+
+        /// White color.
+        static const RGBValue WHITE;
+        /// Black color.
+        static const RGBValue BLACK;
+        /// Red color.
+        static const RGBValue RED;
+        /// Green color.
+        static const RGBValue GREEN;
+        /// Blue color.
+        static const RGBValue BLUE;
+        /// Cyan color.
+        static const RGBValue CYAN;
+        /// Magenta color.
+        static const RGBValue MAGENTA;
+        /// Yellow color.
+        static const RGBValue YELLOW;
+        /// Gray color.
+        static const RGBValue GRAY;
+    };
+
+    constexpr RGBValue CMYKValue::toRGB() const noexcept {
+        return RGBValue((1.f - c) * (1.f - k), (1.f - m) * (1.f - k), (1.f - y) * (1.f - k));
+    }
+
+    inline constexpr CMYKValue CMYKValue::WHITE(0.f, 0.f, 0.f, 0.f);
+    inline constexpr CMYKValue CMYKValue::BLACK(0.f, 0.f, 0.f, 1.f);
+    inline constexpr CMYKValue CMYKValue::RED(0.f, 1.f, 1.f, 0.f);
+    inline constexpr CMYKValue CMYKValue::GREEN(1.f, 0.f, 1.f, 0.f);
+    inline constexpr CMYKValue CMYKValue::BLUE(1.f, 1.f, 0.f, 0.f);
+    inline constexpr CMYKValue CMYKValue::CYAN(1.f, 0.f, 0.f, 0.f);
+    inline constexpr CMYKValue CMYKValue::MAGENTA(0.f, 1.f, 0.f, 0.f);
+    inline constexpr CMYKValue CMYKValue::YELLOW(0.f, 0.f, 1.f, 0.f);
+    inline constexpr CMYKValue CMYKValue::GRAY(0.f, 0.f, 0.f, 0.5f);
+
+    inline constexpr RGBValue RGBValue::WHITE(1.f, 1.f, 1.f);
+    inline constexpr RGBValue RGBValue::BLACK(0.f, 0.f, 0.f);
+    inline constexpr RGBValue RGBValue::RED(1.f, 0.f, 0.f);
+    inline constexpr RGBValue RGBValue::GREEN(0.f, 1.f, 0.f);
+    inline constexpr RGBValue RGBValue::BLUE(0.f, 0.f, 1.f);
+    inline constexpr RGBValue RGBValue::CYAN(0.f, 1.f, 1.f);
+    inline constexpr RGBValue RGBValue::MAGENTA(1.f, 0.f, 1.f);
+    inline constexpr RGBValue RGBValue::YELLOW(1.f, 1.f, 0.f);
+    inline constexpr RGBValue RGBValue::GRAY(128.f / 255.f, 128.f / 255.f, 128.f / 255.f);
+
+    /// Represents a palette of RGB colors built at compile time.
+    template<std::size_t N>
+    using RGBPalette = std::array<RGBValue, N>;
+
+    /**
+     * @brief  Builds a gradient palette, e.g. `constexpr RGBPalette<5> ramp = makeGradient<5>(RGBValue::BLACK, RGBValue::RED);`.
+     * @tparam N Number of colors.
+     * @param  from First color.
+     * @param  to Last color.
+     * @return Palette of `N` colors evenly spaced from `from` to `to`.
+    */
+    template<std::size_t N>
+    constexpr RGBPalette<N> makeGradient(const RGBValue& from, const RGBValue& to) noexcept {
+        RGBPalette<N> palette{};
+        for (std::size_t i = 0U; i < N; ++i) palette[i] = from.mix(to, (N > 1U)? (float) i / (float) (N - 1U): 0.f);
+        return palette;
+    }
+}
+
+#endif // __HARUPP_COLORVALUE_HPP__
@@ -1,6 +1,7 @@
 #ifndef __HARUPP_CONTENTSTREAM_HPP__
 #define __HARUPP_CONTENTSTREAM_HPP__
 #include "Object.hpp"
+#include "atomic"
 
 struct _HPDF_Dict_Rec;
 
@@ -9,13 +10,19 @@ namespace pdf {
     /**
      * \class  ContentStream
      * @brief  Represents a content stream.
+     * @note   A content stream remembers the generation of the Document that created it. Using it once the document has
+     *         been closed or revoked throws an excepts::ExpiredHandleException instead of touching freed memory.
+     *         Define `__HARUPP_DISABLE_HANDLE_CHECKS` to remove this check.
      * @file   ContentStream.hpp
      * @author Nicolas Almerge
      * @date   2023-05-16
     */
     class ContentStream: public Object {
         mutable _HPDF_Dict_Rec* __innerContent = nullptr;
-        explicit ContentStream(_HPDF_Dict_Rec* content) noexcept;
+        const std::atomic<unsigned int>* __generation = nullptr;
+        unsigned int __expectedGeneration = 0U;
+        explicit ContentStream(_HPDF_Dict_Rec* content, const std::atomic<unsigned int>* generation = nullptr) noexcept;
+        _HPDF_Dict_Rec* __content() const;
         friend class Page;
         friend class Annotation;
         friend class LinkAnnotation;
@@ -23,6 +30,7 @@ namespace pdf {
         friend class Document;
         friend class Image;
         friend class Font;
+        friend class FormXObject;
         friend class Outline;
 
     public:
@@ -3,6 +3,7 @@
 #include "Object.hpp"
 
 namespace pdf {
+    class TransposeMatrix;
 
     /**
      * \class  Coor2D
@@ -47,6 +48,13 @@ namespace pdf {
          * @return X coordinate.
         */
         float getY() const noexcept;
+
+        /**
+         * @brief  Transforms the point by a matrix.
+         * @param  matrix TransposeMatrix to apply.
+         * @return Transformed point.
+        */
+        Coor2D transform(const TransposeMatrix& matrix) const noexcept;
     };
 }
 
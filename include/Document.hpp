@@ -1,18 +1,40 @@
 #ifndef __HARUPP_DOCUMENT_HPP__
 #define __HARUPP_DOCUMENT_HPP__
+#include "Allocator.hpp"
 #include "CompressionMode.hpp"
 #include "DateTime.hpp"
 #include "Enums.hpp"
 #include "Font.hpp"
+#include "FormXObject.hpp"
+#include "ImageDownsampling.hpp"
+#include "MemoryUsage.hpp"
 #include "Outline.hpp"
+#include "OutputSink.hpp"
 #include "Page.hpp"
+#include "PageSpec.hpp"
+#include "PendingImage.hpp"
 #include "Permissions.hpp"
 #include "ViewerPreferences.hpp"
+#include "atomic"
+#include "climits"
+#include "memory"
+#include "optional"
+#include "ostream"
+#include "string"
+#include "unordered_map"
+#include "unordered_set"
+#include "utility"
 #include "vector"
 
 struct _HPDF_Doc_Rec;
+struct __HaruppGraphicsStates;
+struct __HaruppImageJob;
+struct __HaruppMemoryContext;
+struct __HaruppPageState;
+struct __HaruppStreamingOutput;
 
 namespace pdf {
+    class ThreadPool;
 
     /**
      * \class  Document
@@ -24,6 +46,25 @@ namespace pdf {
     class Document: public Object {
         mutable _HPDF_Doc_Rec* pdfDoc = nullptr;
         std::vector<bool> imports;
+        std::unique_ptr<OutputSink> ownedStreamingSink;
+        std::unique_ptr<__HaruppStreamingOutput> streamingOutput;
+        std::unique_ptr<__HaruppMemoryContext> memoryContext;
+        int allocatorSlot = -1;
+        std::atomic<unsigned int>* generation = nullptr;
+        std::vector<_HPDF_Dict_Rec*> pageIndex;
+        std::vector<_HPDF_Dict_Rec*> pageTreeNodes;
+        bool pageTreeConfigured = false;
+        std::unordered_map<std::string, _HPDF_Dict_Rec*> imageRegistry;
+        bool imageDeduplication = true;
+        std::unordered_map<std::string, std::string> fontRegistry;
+        bool fontSubsetting = true;
+        std::unordered_map<_HPDF_Dict_Rec*, std::vector<int>> fontSubsets;
+        std::unordered_set<_HPDF_Dict_Rec*> remappedGlyphMaps;
+        std::vector<std::shared_ptr<__HaruppImageJob>> pendingImages;
+        mutable std::unique_ptr<__HaruppGraphicsStates> graphicsStates;
+        bool contentStreamOptimization = false;
+        std::vector<_HPDF_Dict_Rec*> formCanvases;
+        std::unordered_set<_HPDF_Dict_Rec*> encodedPages;
 
     public:
 
@@ -39,15 +80,49 @@ namespace pdf {
         */
         ~Document();
 
+        /**
+         * @brief   Creates a new Document by taking over another one.
+         * @details Objects created by `other` (Page, Font, Image, Outline...) stay valid and now belong to this document.
+         * @param   other Document to move from. It is empty afterwards.
+        */
+        Document(Document&& other) noexcept;
+
+        /**
+         * @brief   Closes the current document and takes over another one.
+         * @details Objects created by `other` (Page, Font, Image, Outline...) stay valid and now belong to this document.
+         * @param   other Document to move from. It is empty afterwards.
+         * @return  This document.
+        */
+        Document& operator=(Document&& other) noexcept;
+
+        Document(const Document&) = delete;
+        Document& operator=(const Document&) = delete;
+
         /**
          * @brief Opens a new document.
+         * @note  Allocations are accounted (see ::getMemoryUsage) as long as fewer than `__HARUPP_ALLOCATOR_SLOTS` accounted
+         *        documents are open at the same time. Otherwise, the document is opened without accounting.
          * @throw excepts::MemoryAllocationFailedException if the opening failed.
         */
         void open();
 
+        /**
+         * @brief   Opens a new document using a custom allocator.
+         * @details Every allocation LibHaru makes for this document goes through `allocator` instead of the global heap.
+         *          Once the document is closed, Allocator::reset is called so that e.g. a MemoryArena frees everything at once.
+         * @param   allocator Allocator to use. It must outlive the document and must not be used by another open document.
+         * @note    Memory released by ::freeResources and ::freeAllResources is handed back to Allocator::deallocate, which
+         *          a MemoryArena ignores until the document is closed.
+         *          Allocations are always accounted (see ::getMemoryUsage).
+         * @throw   excepts::MemoryAllocationFailedException if the opening failed, or if too many accounted documents are
+         *          open at the same time (see `__HARUPP_ALLOCATOR_SLOTS`).
+        */
+        void open(Allocator& allocator);
+
         /**
          * @brief Closes the document and frees all allocated resources.
          * @note  This is automatically called when ::~Document gets called and should be rarely used.
+         *        Objects created by the document can no longer be used afterwards (see excepts::ExpiredHandleException).
         */
         void close();
 
@@ -79,15 +154,51 @@ namespace pdf {
         /**
          * @brief Save the pdf document to a file.
          * @param fileName Relative or absolute file path to use.
+         * @throw excepts::InvalidStreamingStateException if the document is streaming.
         */
         void saveToFile(const std::string& fileName);
 
         /**
          * @brief Saves the document to the temporary stream.
          * @note  This will overwrite the temporary stream with new data.
+         * @throw excepts::InvalidStreamingStateException if the document is streaming.
         */
         void saveToStream();
 
+        /**
+         * @brief   Saves the document and writes it to an OutputSink.
+         * @details Bytes are handed to `sink` while the document is being written, gathered in chunks of
+         *          `__HARUPP_SINK_BUFFER_SIZE` bytes, so that the whole file is never held in memory. The temporary
+         *          stream is left untouched.
+         * @param   sink OutputSink to write to.
+         * @throw   excepts::InvalidStreamingStateException if the document is streaming.
+         * @throw   Any exception thrown by OutputSink::write, once LibHaru has stopped writing.
+        */
+        void saveToSink(OutputSink& sink);
+
+        /**
+         * @brief  Writes the whole temporary stream to an OutputSink.
+         * @note   This does not depend on, nor change, the read position used by ::readFromStream.
+         *         If ::saveToStream has never been called, nothing is written.
+         * @param  sink OutputSink to write to.
+        */
+        void writeStreamTo(OutputSink& sink) const;
+
+        /**
+         * @brief  Gets the number of chunks the temporary stream is made of.
+         * @note   This returns `0` if data was never written to the stream, or if the document has been closed.
+         * @return Number of chunks, to be used with ::getStreamChunk.
+        */
+        unsigned int getStreamChunkCount() const;
+
+        /**
+         * @brief  Gets a chunk of the temporary stream without copying it.
+         * @param  index Index of the chunk (`0 <= index < getStreamChunkCount()`).
+         * @return Pointer to the chunk data and its size, in this order. The pointer stays valid until the stream is
+         *         written again or the document is revoked. Returns `{nullptr, 0}` if `index` is out of range.
+        */
+        std::pair<const unsigned char*, unsigned int> getStreamChunk(unsigned int index) const;
+
         /**
          * @brief  Gets the temporary stream size.
          * @note   This returns `0` if data was never written to the stream, or if the document has been closed.
@@ -103,6 +214,15 @@ namespace pdf {
         */
         std::vector<unsigned char> readFromStream(unsigned int size);
 
+        /**
+         * @brief  Reads up to a certain number of bytes from the stream into a caller-provided buffer.
+         * @param  buffer Buffer to write to. It must be able to hold at least `size` bytes.
+         * @param  size Size limit.
+         * @return Number of bytes read, smaller or equal to `size`.
+         * @note   If ::saveToStream has never been called, this will return `0`.
+        */
+        unsigned int readFromStream(unsigned char* buffer, unsigned int size);
+
         /**
          * @brief   Reads from the stream.
          * @details This is equivalent to `readFromStream(getStreamSize())`.
@@ -125,6 +245,93 @@ namespace pdf {
         */
         std::vector<unsigned char> getContent(unsigned int size = UINT_MAX) const;
 
+        /**
+         * @brief  Checks whether the allocations of the document are accounted.
+         * @return `true` if a document is open and its allocations are accounted, `false` otherwise.
+        */
+        bool isMemoryAccounted() const noexcept;
+
+        /**
+         * @brief   Gets the memory currently used by the document.
+         * @details Allocations are accounted to a subsystem depending on the function that made them. Allocations made
+         *          while creating or drawing on a Page are accounted to enums::MemoryCategory::PAGES, and the ones not
+         *          tied to a subsystem to enums::MemoryCategory::OTHER.
+         * @return  Snapshot of the memory usage. It is empty if the document is not accounted.
+        */
+        MemoryUsage getMemoryUsage() const noexcept;
+
+        /**
+         * @brief   Sets a hard limit on the memory the document may use.
+         * @details Any allocation that would make ::getMemoryUsage exceed the quota fails, and the LibHaru function that
+         *          requested it raises an excepts::MemoryQuotaExceededException instead of the process running out of memory.
+         * @param   bytes Maximum number of bytes, or `0` to remove the limit.
+         * @throw   excepts::MemoryAccountingUnavailableException if the document is not accounted.
+        */
+        void setMemoryQuota(std::size_t bytes);
+
+        /**
+         * @brief  Gets the memory quota of the document.
+         * @return Maximum number of bytes, or `0` if there is no limit.
+        */
+        std::size_t getMemoryQuota() const noexcept;
+
+        /**
+         * @brief  Gets the number of graphics state operators that were not written because they changed nothing.
+         * @see    Page::getElidedOperatorCount
+         * @return Number of operators elided on every page and form canvas of the document.
+        */
+        unsigned long getElidedOperatorCount() const noexcept;
+
+        /**
+         * @brief   Starts streaming the document to an OutputSink.
+         * @details The file header is written to `sink` right away. Once streaming, the content and the images of each Page
+         *          passed to ::finalizePage are written to `sink` and released, so that memory does not grow with the number
+         *          of finished pages. Page dictionaries, fonts and the other shared objects are written by ::endStreaming,
+         *          since the page tree is balanced and fonts are subset at that point, followed by the xref table and the trailer.
+         *          The document cannot be saved nor encrypted while streaming.
+         * @param   sink OutputSink to write the document to. It must outlive the streaming session.
+         * @throw   excepts::InvalidStreamingStateException if the document is not open, is already streaming or is encrypted.
+         * @throw   Any exception thrown by OutputSink::write.
+        */
+        void beginStreaming(OutputSink& sink);
+
+        /**
+         * @brief   Starts streaming the document to an output stream.
+         * @details This is equivalent to ::beginStreaming(OutputSink&) with an OStreamSink writing to `sink`.
+         * @param   sink Output stream to write the document to. It must outlive the streaming session.
+         * @throw   excepts::InvalidStreamingStateException if the document is not open, is already streaming or is encrypted.
+         * @throw   Any exception thrown by OutputSink::write.
+        */
+        void beginStreaming(std::ostream& sink);
+
+        /**
+         * @brief   Marks a Page as finished while streaming.
+         * @details Any pending path or text object is ended and saved graphics states are restored, then the content
+         *          stream is encoded with the document compression settings. The content stream and the images drawn on
+         *          the page are then written to the streaming output and their data is released. Images still being
+         *          decoded are written by ::endStreaming instead.
+         * @param   page Page to finalize.
+         * @warning The page can no longer be drawn on after this call, and the images it draws can no longer be modified.
+         * @throw   excepts::InvalidStreamingStateException if the document is not streaming.
+         * @throw   Any exception thrown by OutputSink::write.
+        */
+        void finalizePage(const Page& page);
+
+        /**
+         * @brief   Writes the document to the streaming output and ends the streaming session.
+         * @details The objects not written by ::finalizePage, the xref table and the trailer are handed to the sink, then
+         *          the document is revoked like with ::freeResources. Call ::newDocument to start a new document afterwards.
+         * @throw   excepts::InvalidStreamingStateException if the document is not streaming.
+         * @throw   Any exception thrown by OutputSink::write.
+        */
+        void endStreaming();
+
+        /**
+         * @brief  Checks whether the document is currently streaming.
+         * @return `true` if ::beginStreaming has been called and ::endStreaming has not been called yet, `false` otherwise.
+        */
+        bool isStreaming() const noexcept;
+
         /**
          * @brief  Checks whether a document is present.
          * @return `true` if a document is present, `false` otherwise.
@@ -159,6 +366,7 @@ namespace pdf {
 
         /**
          * @brief   Sets the number of page per pages.
+         * @note    By default, the page tree is balanced automatically when saving. Calling this function disables it.
          * @warning This can only be called if the document does not contain any page.
          * @param   pagePerPages Value to use.
          * @throw   excepts::PageAlreadyExistsException if the document already contains pages.
@@ -167,12 +375,19 @@ namespace pdf {
 
         /**
          * @brief  Gets the Page at a specified index.
+         * @note   Pages are kept in a flat index, so that this runs in constant time whatever the number of pages.
          * @param  index Index to use.
          * @return Page at specified index `index`.
          * @throw  excepts::InvalidPageIndexException if `index` is out of range or document is not open.
         */
         Page getPageAtIndex(unsigned int index) const;
 
+        /**
+         * @brief  Gets the number of pages of the document.
+         * @return Number of pages.
+        */
+        unsigned int getPageCount() const noexcept;
+
         /**
          * @brief Sets the page layout.
          * @param layout Layout to set.
@@ -236,6 +451,27 @@ namespace pdf {
         */
         Page insertPageBefore(const Page& page);
 
+        /**
+         * @brief   Appends several pages of the same size at the end of the document.
+         * @details Internal page lists are grown once for the whole batch, and the size is validated on the first page only
+         *          before being copied to the others.
+         * @param   count Number of pages to create.
+         * @param   size enums::PageSize to use.
+         * @param   orientation enums::PageOrientation to use.
+         * @return  Newly created pages, in document order.
+        */
+        std::vector<Page> addPages(unsigned int count, enums::PageSize size, enums::PageOrientation orientation = enums::PageOrientation::PORTRAIT);
+
+        /**
+         * @brief   Appends several pages sharing a layout at the end of the document.
+         * @details Internal page lists are grown once for the whole batch, and the layout is validated on the first page only
+         *          before being copied to the others.
+         * @param   count Number of pages to create.
+         * @param   spec PageSpec to apply to every page.
+         * @return  Newly created pages, in document order.
+        */
+        std::vector<Page> addPages(unsigned int count, const PageSpec& spec);
+
         /**
          * @brief Adds a page label.
          * @param style Style to use.
@@ -280,6 +516,7 @@ namespace pdf {
         /**
          * @brief  Loads a Type1 font from an external file and registers it in the document.
          * @note   Unlike ::loadType1FontFromFile(const std::string&, const std::string&), the glyph data of font file won't be embedded to the PDF file.
+         * @note   Files are read through the FontCache. Loading the same files again returns the name of the font already loaded.
          * @param  AFMFileName Path of the AFM file to use.
          * @return Name of the loaded font.
         */
@@ -288,6 +525,7 @@ namespace pdf {
         /**
          * @brief  Loads a Type1 font from an external file and registers it in the document.
          * @note   Unlike ::loadType1FontFromFile(const std::string&), the glyph data of font file will be embedded to the PDF file.
+         * @note   Files are read through the FontCache. Loading the same files again returns the name of the font already loaded.
          * @param  AFMFileName Path of the AFM file to use.
          * @param  dataFileName Path of a PFA/PFB file.
          * @return Name of the loaded font.
@@ -296,6 +534,8 @@ namespace pdf {
 
         /**
          * @brief  Loads a TrueType font from an external file and registers it in the document.
+         * @note   The file is read through the FontCache. Loading the same file again, or another file holding an already
+         *         registered font, returns the name of the font already loaded instead of raising an error.
          * @param  fileName Path of a TrueType font file (`.ttf`).
          * @param  embedding If set to `true`, the glyph data of the font is embedded, otherwise only the matrix data is included.
          * @return Name of the loaded font.
@@ -304,6 +544,7 @@ namespace pdf {
 
         /**
          * @brief  Loads a TrueType font from an TrueType collection file and registers it in the document.
+         * @note   The file is read through the FontCache. Loading the same font again returns the name of the font already loaded.
          * @param  fileName Path of a TrueType font collection file (`.ttc`).
          * @param  index Index of the font to be loaded.
          * @param  embedding If set to `true`, the glyph data of the font is embedded, otherwise only the matrix data is included.
@@ -311,6 +552,99 @@ namespace pdf {
         */
         std::string loadTrueTypeFontFromFile(const std::string& fileName, unsigned int index, bool embedding);
 
+        /**
+         * @brief  Loads a TrueType font from a memory-mapped file and registers it in the document.
+         * @note   The file stays mapped while a document uses it, and is shared with the other documents mapping it, so
+         *         that its pages are only read when LibHaru needs them. If the file cannot be mapped, it is read through
+         *         the FontCache instead. Loading the same file again returns the name of the font already loaded.
+         * @param  fileName Path of a TrueType font file (`.ttf`).
+         * @param  embedding If set to `true`, the glyph data of the font is embedded, otherwise only the matrix data is included.
+         * @return Name of the loaded font.
+        */
+        std::string loadTrueTypeFontFromMappedFile(const std::string& fileName, bool embedding);
+
+        /**
+         * @brief  Loads a TrueType font from a memory-mapped TrueType collection file and registers it in the document.
+         * @note   See ::loadTrueTypeFontFromMappedFile(const std::string&, bool).
+         * @param  fileName Path of a TrueType font collection file (`.ttc`).
+         * @param  index Index of the font to be loaded.
+         * @param  embedding If set to `true`, the glyph data of the font is embedded, otherwise only the matrix data is included.
+         * @return Name of the loaded font.
+        */
+        std::string loadTrueTypeFontFromMappedFile(const std::string& fileName, unsigned int index, bool embedding);
+
+        /**
+         * @brief   Loads a TrueType font from memory and registers it in the document.
+         * @details The bytes are not copied. Loading the same bytes again returns the name of the font already loaded,
+         *          embedded fonts included.
+         * @warning The bytes are owned by the caller and must stay valid until the document is closed or recycled, as
+         *          LibHaru reads embedded glyph data when saving.
+         * @param   data Bytes of a TrueType font file.
+         * @param   size Number of bytes.
+         * @param   embedding If set to `true`, the glyph data of the font is embedded, otherwise only the matrix data is included.
+         * @return  Name of the loaded font.
+        */
+        std::string loadTrueTypeFontFromMemory(const unsigned char* data, std::size_t size, bool embedding);
+
+        /**
+         * @brief   Loads a TrueType font from a TrueType collection in memory and registers it in the document.
+         * @warning See ::loadTrueTypeFontFromMemory(const unsigned char*, std::size_t, bool).
+         * @param   data Bytes of a TrueType font collection file.
+         * @param   size Number of bytes.
+         * @param   index Index of the font to be loaded.
+         * @param   embedding If set to `true`, the glyph data of the font is embedded, otherwise only the matrix data is included.
+         * @return  Name of the loaded font.
+        */
+        std::string loadTrueTypeFontFromMemory(const unsigned char* data, std::size_t size, unsigned int index, bool embedding);
+
+        /**
+         * @brief  Loads a Type1 font from memory and registers it in the document.
+         * @note   The bytes are only read during the call. Loading a font already registered returns the name of the font
+         *         already loaded.
+         * @param  AFMData Bytes of the font metrics (`.afm`).
+         * @param  AFMSize Number of metrics bytes.
+         * @param  data Bytes of the font data (`.pfa` or `.pfb`) to embed, or `nullptr` to embed no glyph data.
+         * @param  dataSize Number of font data bytes.
+         * @return Name of the loaded font.
+        */
+        std::string loadType1FontFromMemory(const unsigned char* AFMData, std::size_t AFMSize, const unsigned char* data = nullptr, std::size_t dataSize = 0U);
+
+        /**
+         * @brief   Sets whether embedded TrueType fonts are subset when the document is saved.
+         * @details A subset font only holds the glyphs used by the document, renumbered, with rebuilt glyph, metrics and
+         *          character map tables, instead of the whole font file with unused glyphs blanked. This is enabled by
+         *          default and kept across ::newDocument.
+         * @note    A font is subset on the first save using it. Text drawn with it afterwards should only use glyphs
+         *          already used, as with the glyph data LibHaru embeds.
+         * @param   enabled Whether to subset embedded fonts.
+        */
+        void setFontSubsetting(bool enabled) noexcept;
+
+        /**
+         * @brief  Checks whether embedded TrueType fonts are subset when the document is saved.
+         * @return `true` if fonts are subset, `false` otherwise.
+        */
+        bool isFontSubsettingEnabled() const noexcept;
+
+        /**
+         * @brief   Sets whether content streams are optimized when the document is saved.
+         * @details Each page and FormXObject content stream is rewritten into an equivalent smaller one before being
+         *          compressed: save/restore pairs enclosing nothing visible are removed, consecutive text moves are
+         *          merged, text objects showing nothing are unwrapped, and state operators setting the value already in
+         *          effect are skipped. This is disabled by default and kept across ::newDocument.
+         * @note    Only the current content stream of a page is optimized, streams inserted with
+         *          Page::insertSharedContentStream and streams holding inline images are kept as they are. When
+         *          streaming, pages are optimized by ::finalizePage.
+         * @param   enabled Whether to optimize content streams.
+        */
+        void setContentStreamOptimization(bool enabled) noexcept;
+
+        /**
+         * @brief  Checks whether content streams are optimized when the document is saved.
+         * @return `true` if content streams are optimized, `false` otherwise.
+        */
+        bool isContentStreamOptimizationEnabled() const noexcept;
+
         /**
          * @brief Loads Japanese fonts.
          * @throw excepts::MemoryAllocationFailedException if not enough memory is available.
@@ -472,6 +806,16 @@ namespace pdf {
         */
         Image loadPNGImageFromFile(const std::string& fileName);
 
+        /**
+         * @brief   Loads a PNG image from a file, downsampled to a target resolution.
+         * @details The image is decoded by the document instead of LibHaru, resampled if it holds more pixels than
+         *          `downsampling` needs, then compressed. Downsampled indexed images are converted to RGB.
+         * @param   fileName The image filename.
+         * @param   downsampling Resolution and size the image is drawn at. If empty, this is ::loadPNGImageFromFile.
+         * @return  Image from the filename.
+        */
+        Image loadPNGImageFromFile(const std::string& fileName, const ImageDownsampling& downsampling);
+
         /**
          * @brief  Loads a PNG image from memory.
          * @param  bytes Vector of bytes to use.
@@ -479,6 +823,15 @@ namespace pdf {
         */
         Image loadPNGImageFromMemory(const std::vector<unsigned char>& bytes);
 
+        /**
+         * @brief   Loads a PNG image from memory, downsampled to a target resolution.
+         * @details See ::loadPNGImageFromFile.
+         * @param   bytes Vector of bytes to use.
+         * @param   downsampling Resolution and size the image is drawn at. If empty, this is ::loadPNGImageFromMemory.
+         * @return  Image from memory.
+        */
+        Image loadPNGImageFromMemory(const std::vector<unsigned char>& bytes, const ImageDownsampling& downsampling);
+
         /**
          * @brief Loads a PNG image from a file.
          * @note  Unlike ::loadPNGImageFromFile, only the size and color properties are loaded.
@@ -512,15 +865,117 @@ namespace pdf {
          *         Only enums::ColorSpace::DEVICE_GRAY, enums::ColorSpace::DEVICE_RGB and
          *         enums::ColorSpace::DEVICE_CMYK are allowed.
          * @param  bitsPerComponent Number of bits per component (`1`, `2`, `4` or `8`).
+         * @param  downsampling Resolution and size the image is drawn at, 8 bits images holding more pixels than needed
+         *         are resampled before being compressed.
          * @return New Image object.
          * @throw  excepts::InvalidBitsPerComponentException if `bitsPerComponent` is not `1`, `2`, `4` or `8`.
         */
         Image loadRawImageFromMemory(
             const std::vector<unsigned char>& bytes, unsigned int width,
             unsigned int height, enums::ColorSpace colorSpace,
-            unsigned int bitsPerComponent
+            unsigned int bitsPerComponent, const ImageDownsampling& downsampling = ImageDownsampling()
+        );
+
+        /**
+         * @brief   Loads a raw image from memory, taking the bytes over.
+         * @details The image stream reads the bytes from the vector when the document is saved, so they are never copied.
+         * @param   bytes Vector of bytes encoding the image, rows padded to a whole byte.
+         * @param   width The width of the image.
+         * @param   height The height of the image.
+         * @param   colorSpace The color space to use.
+         *          Only enums::ColorSpace::DEVICE_GRAY, enums::ColorSpace::DEVICE_RGB and
+         *          enums::ColorSpace::DEVICE_CMYK are allowed.
+         * @param   bitsPerComponent Number of bits per component (`1`, `2`, `4` or `8`).
+         * @param   downsampling Resolution and size the image is drawn at, 8 bits images holding more pixels than needed
+         *          are resampled before being compressed.
+         * @return  New Image object.
+         * @throw   excepts::InvalidBitsPerComponentException if `bitsPerComponent` is not `1`, `2`, `4` or `8`.
+         * @throw   excepts::InvalidColorSpaceException if `colorSpace` is not allowed.
+         * @throw   excepts::InvalidImageException if the image is empty or `bytes` is too short.
+        */
+        Image loadRawImageFromMemory(
+            std::vector<unsigned char>&& bytes, unsigned int width,
+            unsigned int height, enums::ColorSpace colorSpace,
+            unsigned int bitsPerComponent, const ImageDownsampling& downsampling = ImageDownsampling()
+        );
+
+        /**
+         * @brief   Loads a raw image from a caller-owned buffer.
+         * @details Borrowed and adopted bytes are read in place when the document is saved, so they are never copied.
+         * @warning Borrowed bytes must stay valid until the document is last saved.
+         * @param   data Bytes encoding the image, rows padded to a whole byte.
+         * @param   size Number of bytes.
+         * @param   width The width of the image.
+         * @param   height The height of the image.
+         * @param   colorSpace The color space to use.
+         *          Only enums::ColorSpace::DEVICE_GRAY, enums::ColorSpace::DEVICE_RGB and
+         *          enums::ColorSpace::DEVICE_CMYK are allowed.
+         * @param   bitsPerComponent Number of bits per component (`1`, `2`, `4` or `8`).
+         * @param   ownership Whether the bytes are copied, borrowed or adopted. Adopted bytes are deleted even if an
+         *          exception is thrown.
+         * @param   downsampling Resolution and size the image is drawn at, 8 bits images holding more pixels than needed
+         *          are resampled before being compressed.
+         * @return  New Image object.
+         * @throw   excepts::InvalidBitsPerComponentException if `bitsPerComponent` is not `1`, `2`, `4` or `8`.
+         * @throw   excepts::InvalidColorSpaceException if `colorSpace` is not allowed.
+         * @throw   excepts::InvalidImageException if the image is empty or `size` is too small.
+        */
+        Image loadRawImageFromMemory(
+            const unsigned char* data, std::size_t size, unsigned int width,
+            unsigned int height, enums::ColorSpace colorSpace, unsigned int bitsPerComponent,
+            enums::BufferOwnership ownership = enums::BufferOwnership::COPY,
+            const ImageDownsampling& downsampling = ImageDownsampling()
+        );
+
+        /**
+         * @brief   Loads a raw image from a memory-mapped file.
+         * @details The file stays mapped while the document uses it, and its pages are read when the document is saved
+         *          instead of being loaded up front. If the file cannot be mapped, it is read by ::loadRawImageFromFile.
+         * @param   fileName The image filename.
+         * @param   width The width of the image.
+         * @param   height The height of the image.
+         * @param   colorSpace Color space to use.
+         *          Only enums::ColorSpace::DEVICE_GRAY, enums::ColorSpace::DEVICE_RGB and
+         *          enums::ColorSpace::DEVICE_CMYK are allowed.
+         * @param   downsampling Resolution and size the image is drawn at, 8 bits images holding more pixels than needed
+         *          are resampled before being compressed.
+         * @return  New Image object.
+         * @throw   excepts::InvalidColorSpaceException if `colorSpace` is not allowed.
+         * @throw   excepts::InvalidImageException if the image is empty or the file is too short.
+        */
+        Image loadRawImageFromMappedFile(
+            const std::string& fileName, unsigned int width,
+            unsigned int height, enums::ColorSpace colorSpace,
+            const ImageDownsampling& downsampling = ImageDownsampling()
+        );
+
+        /**
+         * @brief   Loads a PNG image from a file on a ThreadPool.
+         * @details The file is read, decoded and compressed by a worker of `pool` while the calling thread goes on.
+         *          Non-interlaced images without transparency keep their compressed data, which PDF readers unfilter
+         *          themselves. The returned image can be drawn right away, the document fills it in when saved or when
+         *          PendingImage::get is called.
+         * @note    Asynchronous loads are not deduplicated. Reading or decoding errors are raised when the image is filled in.
+         * @param   fileName The image filename.
+         * @param   pool Pool running the decoding, which must outlive the load.
+         * @param   downsampling Resolution and size the image is drawn at, the worker resamples images holding more
+         *          pixels than needed (see ::loadPNGImageFromFile).
+         * @return  Image being loaded.
+        */
+        PendingImage loadPNGImageFromFileAsync(
+            const std::string& fileName, ThreadPool& pool, const ImageDownsampling& downsampling = ImageDownsampling()
         );
 
+        /**
+         * @brief   Loads a JPEG image from a file on a ThreadPool.
+         * @details See ::loadPNGImageFromFileAsync. JPEG data is embedded as is, so the worker only reads the file and
+         *          its header.
+         * @param   fileName The image filename.
+         * @param   pool Pool running the loading, which must outlive the load.
+         * @return  Image being loaded.
+        */
+        PendingImage loadJPEGImageFromFileAsync(const std::string& fileName, ThreadPool& pool);
+
         /**
          * @brief  Loads a JPEG image from memory.
          * @param  bytes Vector of bytes to use.
@@ -535,6 +990,33 @@ namespace pdf {
         */
         Image loadJPEGImageFromFile(const std::string& fileName);
 
+        /**
+         * @brief   Sets whether repeated image loads return the image already loaded.
+         * @details Images loaded from memory are recognized by a SHA-256 digest of their bytes, and images loaded from a
+         *          file by their path, modification time and size, together with the loader and its parameters. A repeated
+         *          load then returns the existing Image without decoding nor compressing it again, and the document holds a
+         *          single image stream. This is enabled by default and kept across ::newDocument.
+         * @note    As loads may return the same Image, functions changing an image (e.g. Image::setColorMask) change it for
+         *          every place it is drawn. Disable deduplication to get distinct images.
+         * @param   enabled Whether to deduplicate images.
+        */
+        void setImageDeduplication(bool enabled) noexcept;
+
+        /**
+         * @brief  Checks whether repeated image loads return the image already loaded.
+         * @return `true` if images are deduplicated, `false` otherwise.
+        */
+        bool isImageDeduplicationEnabled() const noexcept;
+
+        /**
+         * @brief  Creates a form XObject to record reusable artwork.
+         * @param  boundingBox Box clipping the form, in form coordinates.
+         * @param  matrix Matrix mapping form coordinates to the coordinates of the page drawing it.
+         * @return New FormXObject, with an empty canvas.
+         * @throw  excepts::InvalidParameterException if `boundingBox` has no area.
+        */
+        FormXObject createFormXObject(const Box& boundingBox, const TransposeMatrix& matrix = TransposeMatrix(1.f, 0.f, 0.f, 1.f, 0.f, 0.f));
+
         /**
          * @brief Sets a document metadata regular attribute.
          * @param parameter Parameter to set.
@@ -574,6 +1056,7 @@ namespace pdf {
          * @brief Sets the owner password for a pdf document (with no user password).
          * @param ownerPassword Owner password (cannot be empty).
          * @throw excepts::InvalidPasswordException if `ownerPassword` is empty.
+         * @throw excepts::InvalidStreamingStateException if the document is streaming.
         */
         void setPassword(const std::string& ownerPassword);
 
@@ -583,6 +1066,7 @@ namespace pdf {
          * @param ownerPassword Owner password (cannot be empty).
          * @param userPassword  User password (can be empty, but cannot be equal to `ownerPassword`).
          * @throw excepts::InvalidPasswordException if `ownerPassword` is empty or `ownerPassword == userPassword`.
+         * @throw excepts::InvalidStreamingStateException if the document is streaming.
         */
         void setPassword(const std::string& ownerPassword, const std::string& userPassword);
 
@@ -617,21 +1101,43 @@ namespace pdf {
         */
         void setCompressionMode(const CompressionMode& mode);
 
-        /**
-         * @brief Closes the current document, which will now point to a new document.
-         * @param newDoc New pdf document to use.
-        */
-        void operator=(const Document& newDoc);
 
     private:
+        friend class PendingImage;
+
         bool __getImportValue(int index) const;
         void __setImportValue(int index, bool newValue);
         Font __getFont(const char* fontName, const char* encodingName);
         std::string __loadType1FontFromFile(const char* AFMFileName, const char* dataFileName);
+        std::string __loadTrueTypeFontFromFile(const std::string& fileName, int index, bool embedding, bool mapped);
+        std::string __loadTrueTypeFontFromMemory(const unsigned char* data, std::size_t size, int index, bool embedding);
         Encoder __getEncoder(const char* name);
         void __setCurrentEncoder(const char* name);
         Outline __createOutline(const std::string& title, const Outline* parent, const Encoder* encoder) const;
         void __autoImportEncoding(enums::MultiByteEncoding encoding);
+        void __clearDocumentState() noexcept;
+        __HaruppPageState* __getPageState(_HPDF_Dict_Rec* page, bool inherited = false) const;
+        _HPDF_Dict_Rec* __findImage(const std::string& key) const;
+        Image __registerImage(std::string&& key, _HPDF_Dict_Rec* image);
+        Image __loadRawImage(
+            std::shared_ptr<const void> owner, const unsigned char* data, std::size_t size, unsigned int width,
+            unsigned int height, enums::ColorSpace colorSpace, unsigned int bitsPerComponent, std::string&& key
+        );
+        void __prepareSave();
+        void __beginStreaming(OutputSink& sink);
+        void __balancePageTree();
+        void __subsetFonts();
+        void __optimizeContentStreams();
+        Image __loadDownsampledRawImage(
+            const unsigned char* data, unsigned int width, unsigned int height,
+            enums::ColorSpace colorSpace, const ImageDownsampling& downsampling, std::string&& key
+        );
+        Image __loadDownsampledPNGImage(
+            const unsigned char* data, std::size_t size, const ImageDownsampling& downsampling, std::string&& key
+        );
+        PendingImage __loadImageAsync(const std::string& fileName, ThreadPool& pool, bool png, const ImageDownsampling& downsampling);
+        static void __resolveImage(__HaruppImageJob& job);
+        void __resolveImages();
     };
 }
 
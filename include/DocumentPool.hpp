@@ -0,0 +1,170 @@
+#ifndef __HARUPP_DOCUMENTPOOL_HPP__
+#define __HARUPP_DOCUMENTPOOL_HPP__
+#include "Document.hpp"
+#include "Image.hpp"
+#include "functional"
+#include "memory"
+#include "mutex"
+#include "optional"
+#include "string"
+#include "utility"
+#include "vector"
+
+namespace pdf {
+
+    class DocumentPool;
+
+    /**
+     * \class  PooledDocument
+     * @brief  Represents a Document borrowed from a DocumentPool.
+     * @note   Note that this class cannot be instantiated manually. Rather, it is created when calling DocumentPool::acquire.
+     *         The document goes back to its pool when this object is destroyed or when ::release is called.
+     * @file   DocumentPool.hpp
+    */
+    class PooledDocument final: public Object {
+        DocumentPool* pool = nullptr;
+        std::unique_ptr<Document> document;
+        std::vector<std::pair<std::string, Image>> images;
+        explicit PooledDocument(DocumentPool* pool, std::unique_ptr<Document> document, std::vector<std::pair<std::string, Image>> images) noexcept;
+        friend class DocumentPool;
+
+    public:
+
+        /**
+         * @brief Returns the document to its pool.
+        */
+        ~PooledDocument();
+
+        PooledDocument(PooledDocument&& other) noexcept;
+        PooledDocument& operator=(PooledDocument&& other);
+        PooledDocument(const PooledDocument&) = delete;
+        PooledDocument& operator=(const PooledDocument&) = delete;
+
+        /**
+         * @brief  Gets the borrowed document.
+         * @return Reference to the document.
+        */
+        Document& getDocument() const noexcept;
+
+        /**
+         * @brief  Gets the borrowed document.
+         * @return Pointer to the document.
+        */
+        Document* operator->() const noexcept;
+
+        /**
+         * @brief  Gets an image declared with DocumentPool::addPNGImage or DocumentPool::addJPEGImage.
+         * @param  key Key given when declaring the image.
+         * @return The image, already loaded in the borrowed document, or `std::nullopt` if no image was declared with this key.
+        */
+        std::optional<Image> getImage(const std::string& key) const;
+
+        /**
+         * @brief   Gives the document back to its pool right away.
+         * @details The document is reset to a clean state, keeping its fonts and encodings loaded. This object is empty afterwards.
+        */
+        void release();
+
+        /**
+         * @brief  Checks whether the document has been given back to its pool.
+         * @return `true` if the document was released, `false` otherwise.
+        */
+        bool isEmpty() const noexcept override;
+    };
+
+    /**
+     * \class   DocumentPool
+     * @brief   Represents a pool of ready-to-use documents.
+     * @details Creating a document, parsing fonts and registering encodings often costs more than rendering a small pdf.
+     *          A pool runs that setup once per Document and then recycles the documents: a released document is reset with
+     *          Document::newDocument, which keeps the loaded font definitions and encodings, so that a steady-state job
+     *          skips all re-parsing and re-registration.
+     *          Images cannot survive a reset, so declared images are read once and reloaded from memory for every job.
+     * @note    ::acquire and PooledDocument::release may be called from several threads. A PooledDocument must only be used
+     *          by one thread at a time, and the pool must outlive all of them.
+     * @file    DocumentPool.hpp
+    */
+    class DocumentPool final {
+    public:
+        /// Function called on a Document of the pool.
+        typedef std::function<void(Document&)> Initializer;
+
+    private:
+        struct ImageSource {
+            std::string key;
+            std::vector<unsigned char> bytes;
+            bool isPNG;
+        };
+
+        mutable std::mutex mutex;
+        std::vector<std::unique_ptr<Document>> idleDocuments;
+        std::vector<std::pair<std::string, std::string>> fonts;
+        std::vector<std::shared_ptr<const ImageSource>> imageSources;
+        Initializer onCreate;
+        Initializer onAcquire;
+        std::size_t maxIdleDocuments;
+
+        void __recycle(std::unique_ptr<Document> document) noexcept;
+        friend class PooledDocument;
+
+    public:
+
+        /**
+         * @brief Creates a new DocumentPool.
+         * @param onCreate Function called once on every new Document, right after it is opened. Load fonts and encodings here
+         *        (e.g. Document::loadTrueTypeFontFromFile, Document::useUTFEncodings), as they are kept across resets.
+         * @param onAcquire Function called every time a Document is handed out. Apply per-document settings here
+         *        (e.g. Document::setCompressionMode), as they are lost on reset.
+         * @param maxIdleDocuments Maximum number of idle documents kept by the pool. Extra released documents are closed.
+        */
+        explicit DocumentPool(Initializer onCreate = nullptr, Initializer onAcquire = nullptr, std::size_t maxIdleDocuments = 8U);
+
+        DocumentPool(const DocumentPool&) = delete;
+        DocumentPool& operator=(const DocumentPool&) = delete;
+
+        /**
+         * @brief   Declares a font to get on every handed out document.
+         * @details Document::getFont is called with these parameters before the document is handed out, so that the font
+         *          is ready to be used. The font definition must be available, either as a base font or loaded by `onCreate`.
+         * @param   fontName Font name.
+         * @param   encodingName Encoding name.
+        */
+        void addFont(const std::string& fontName, const std::string& encodingName);
+
+        /**
+         * @brief Declares a PNG image to load in every handed out document.
+         * @param key Key used to get the image with PooledDocument::getImage.
+         * @param fileName Relative or absolute file path. The file is read once, right away.
+         * @throw excepts::FileOpeningException if the file could not be read.
+        */
+        void addPNGImage(const std::string& key, const std::string& fileName);
+
+        /**
+         * @brief Declares a JPEG image to load in every handed out document.
+         * @param key Key used to get the image with PooledDocument::getImage.
+         * @param fileName Relative or absolute file path. The file is read once, right away.
+         * @throw excepts::FileOpeningException if the file could not be read.
+        */
+        void addJPEGImage(const std::string& key, const std::string& fileName);
+
+        /**
+         * @brief  Borrows a document from the pool.
+         * @note   An idle document is reused if there is one. Otherwise, a new document is opened and `onCreate` is called.
+         * @return The borrowed document, with its declared fonts and images loaded.
+        */
+        PooledDocument acquire();
+
+        /**
+         * @brief  Gets the number of idle documents in the pool.
+         * @return Number of idle documents.
+        */
+        std::size_t getIdleCount() const;
+
+        /**
+         * @brief Closes all the idle documents.
+        */
+        void clear();
+    };
+}
+
+#endif // __HARUPP_DOCUMENTPOOL_HPP__
@@ -453,6 +453,48 @@ namespace pdf::enums {
         /// Clipping mode.
         CLIPPING
     };
+
+    /// Represents the subsystem a document allocation is accounted to.
+    enum class MemoryCategory {
+        /// Pages and their content streams.
+        PAGES = 0,
+        /// Fonts and font definitions.
+        FONTS,
+        /// Images.
+        IMAGES,
+        /// Anything else (catalog, encoders, outlines, output stream...).
+        OTHER
+    };
+
+    /// Represents the way errors reported by LibHaru are surfaced.
+    enum class ErrorPolicy {
+        /// An excepts::Exception is thrown once the LibHaru function has returned.
+        THROW = 0,
+        /// Nothing is thrown, the error is kept by the document (see Document::getLastErrorCode).
+        RECORD,
+        /// The process is aborted right away.
+        ABORT
+    };
+
+    /// Represents who owns a buffer given to the document.
+    enum class BufferOwnership {
+        /// The document copies the bytes during the call.
+        COPY = 0,
+        /// The document reads the bytes in place, they must stay valid until the document is last saved.
+        BORROW,
+        /// The document takes the buffer over (allocated with `new[]`) and deletes it once unused.
+        ADOPT
+    };
+
+    /// Represents the kernel used to resample images.
+    enum class ResamplingFilter {
+        /// Averages the source pixels covered by each target pixel.
+        BOX = 0,
+        /// Weights the source pixels linearly with their distance (triangle filter).
+        BILINEAR,
+        /// Three-lobed Lanczos windowed sinc, sharpest but slowest.
+        LANCZOS
+    };
 }
 
 #endif // __HARUPP_ENUMS_HPP__
@@ -0,0 +1,37 @@
+#ifndef __HARUPP_ERRORPOLICY_HPP__
+#define __HARUPP_ERRORPOLICY_HPP__
+#include "Enums.hpp"
+
+/**
+ * @file    ErrorPolicy.hpp
+ * @brief   Selects at compile time how errors reported by LibHaru are surfaced.
+ * @details Define `__HARUPP_ERROR_POLICY` to one of the values below for the whole build (library and users alike):
+ *          - `__HARUPP_ERROR_POLICY_THROW` (default): the LibHaru error handler only records the error. The wrapper checks
+ *            it once the LibHaru function has returned and throws the matching excepts::Exception, so that no exception
+ *            ever unwinds through LibHaru frames.
+ *          - `__HARUPP_ERROR_POLICY_RECORD`: nothing is recorded nor checked by the wrapper, which adds no overhead at all.
+ *            Errors are read with Document::getLastErrorCode and cleared with Document::resetErrorCode.
+ *            Exceptions raised by the wrapper itself (e.g. invalid arguments) are still thrown.
+ *          - `__HARUPP_ERROR_POLICY_ABORT`: the process is aborted as soon as LibHaru reports an error.
+*/
+#define __HARUPP_ERROR_POLICY_THROW  0
+#define __HARUPP_ERROR_POLICY_RECORD 1
+#define __HARUPP_ERROR_POLICY_ABORT  2
+
+#ifndef __HARUPP_ERROR_POLICY
+#define __HARUPP_ERROR_POLICY __HARUPP_ERROR_POLICY_THROW
+#endif
+
+#if __HARUPP_ERROR_POLICY != __HARUPP_ERROR_POLICY_THROW && __HARUPP_ERROR_POLICY != __HARUPP_ERROR_POLICY_RECORD && __HARUPP_ERROR_POLICY != __HARUPP_ERROR_POLICY_ABORT
+#error "__HARUPP_ERROR_POLICY must be __HARUPP_ERROR_POLICY_THROW, __HARUPP_ERROR_POLICY_RECORD or __HARUPP_ERROR_POLICY_ABORT"
+#endif
+
+namespace pdf::consts {
+    /**
+     * @brief   Represents the error policy the library was built with.
+     * @details This is set by the `__HARUPP_ERROR_POLICY` macro.
+    */
+    constexpr enums::ErrorPolicy ERROR_POLICY = static_cast<enums::ErrorPolicy>(__HARUPP_ERROR_POLICY);
+}
+
+#endif // __HARUPP_ERRORPOLICY_HPP__
@@ -476,13 +476,40 @@ namespace pdf::excepts {
      * @author Nicolas Almerge
      * @date   2023-05-16
     */
-    class MemoryAllocationFailedException final: public Exception {
+    class MemoryAllocationFailedException: public Exception {
         public:
             /**
              * @brief   Creates a new MemoryAllocationFailedException.
              * @details The error code will be set to `0x1015`.
             */
             MemoryAllocationFailedException() noexcept;
+
+            /**
+             * @brief Creates a new MemoryAllocationFailedException with parameters.
+             * @param className Error class name.
+             * @param errorMessage Error message.
+             * @param errorCode Error code.
+             * @param detailCode Detail code.
+            */
+            MemoryAllocationFailedException(
+                const char* className, const char* errorMessage,
+                unsigned long errorCode, unsigned long detailCode = 0U
+            ) noexcept;
+    };
+
+    /**
+     * \class  MemoryQuotaExceededException
+     * @brief  An exception raised when an allocation would make a document exceed its memory quota.
+     * @file   Exception.hpp
+    */
+    class MemoryQuotaExceededException final: public MemoryAllocationFailedException {
+        public:
+            /**
+             * @brief   Creates a new MemoryQuotaExceededException.
+             * @details The error code will be set to `0x1015`.
+             * @param   quota Quota that was exceeded, in bytes. It is used as the detail code.
+            */
+            explicit MemoryQuotaExceededException(unsigned long quota) noexcept;
     };
 
     /**
@@ -1166,6 +1193,48 @@ namespace pdf::excepts {
             InvalidPageLayoutException() noexcept;
     };
 
+    /**
+     * \class  InvalidStreamingStateException
+     * @brief  An exception raised when calling Document::beginStreaming, Document::finalizePage or Document::endStreaming in an invalid streaming state.
+     * @file   Exception.hpp
+    */
+    class InvalidStreamingStateException final: public DocumentException {
+        public:
+            /**
+             * @brief   Creates a new InvalidStreamingStateException.
+             * @details The error code will be set to `0x2001`.
+            */
+            InvalidStreamingStateException() noexcept;
+    };
+
+    /**
+     * \class  MemoryAccountingUnavailableException
+     * @brief  An exception raised when memory accounting is required but the document is not accounted.
+     * @file   Exception.hpp
+    */
+    class MemoryAccountingUnavailableException final: public DocumentException {
+        public:
+            /**
+             * @brief   Creates a new MemoryAccountingUnavailableException.
+             * @details The error code will be set to `0x2002`.
+            */
+            MemoryAccountingUnavailableException() noexcept;
+    };
+
+    /**
+     * \class  ExpiredHandleException
+     * @brief  An exception raised when using an object whose document has been closed or revoked.
+     * @file   Exception.hpp
+    */
+    class ExpiredHandleException final: public DocumentException {
+        public:
+            /**
+             * @brief   Creates a new ExpiredHandleException.
+             * @details The error code will be set to `0x2003`.
+            */
+            ExpiredHandleException() noexcept;
+    };
+
     /**
      * \class   UndefinedException
      * @brief   Represents exceptions that should not be raised.
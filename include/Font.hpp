@@ -18,7 +18,7 @@ namespace pdf {
      * @date   2023-05-16
     */
     class Font final: public ContentStream {
-        explicit Font(_HPDF_Dict_Rec* content) noexcept;
+        explicit Font(_HPDF_Dict_Rec* content, const std::atomic<unsigned int>* generation = nullptr) noexcept;
         friend class Document;
         friend class Page;
 
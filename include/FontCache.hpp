@@ -0,0 +1,56 @@
+#ifndef __HARUPP_FONTCACHE_HPP__
+#define __HARUPP_FONTCACHE_HPP__
+#include "memory"
+#include "string"
+#include "vector"
+
+namespace pdf {
+
+    /**
+     * \class   FontCache
+     * @brief   Represents the process-wide cache of font files shared by every Document.
+     * @details Document::loadTrueTypeFontFromFile and Document::loadType1FontFromFile read font files through this cache,
+     *          so that a font used by many documents is read from disk once. Each document reading a cached font holds a
+     *          reference to its bytes, which are only released once no document uses them anymore and the entry has been
+     *          trimmed. A file modified on disk is read again on its next use.
+     * @note    LibHaru allocates parsed font definitions with the memory of their document, so each Document still parses
+     *          the tables it needs. Recycle documents with Document::newDocument (e.g. through a DocumentPool) to keep
+     *          parsed fonts across jobs.
+     * @note    All functions may be called from several threads.
+     * @file    FontCache.hpp
+    */
+    class FontCache final {
+        static std::shared_ptr<const std::vector<unsigned char>> __acquire(const std::string& fileName);
+        friend class Document;
+
+    public:
+        FontCache() = delete;
+
+        /**
+         * @brief Reads a font file into the cache ahead of time.
+         * @param fileName Relative or absolute path of a font file (`.ttf`, `.ttc`, `.afm`, `.pfa` or `.pfb`).
+         * @throw excepts::FileOpeningException if the file could not be read.
+        */
+        static void preload(const std::string& fileName);
+
+        /**
+         * @brief  Gets the number of cached font files.
+         * @return Number of cache entries.
+        */
+        static std::size_t getEntryCount();
+
+        /**
+         * @brief  Gets the number of bytes held by the cache entries.
+         * @return Size of the cached font files, in bytes.
+        */
+        static std::size_t getSize();
+
+        /**
+         * @brief   Removes the entries not used by any Document.
+         * @details Entries still used are kept. Their bytes are released once the last document using them is closed.
+        */
+        static void trim();
+    };
+}
+
+#endif // __HARUPP_FONTCACHE_HPP__
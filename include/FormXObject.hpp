@@ -0,0 +1,55 @@
+#ifndef __HARUPP_FORMXOBJECT_HPP__
+#define __HARUPP_FORMXOBJECT_HPP__
+#include "Box.hpp"
+#include "ContentStream.hpp"
+#include "TransposeMatrix.hpp"
+
+struct __HaruppPageState;
+
+namespace pdf {
+
+    class Page;
+
+    /**
+     * \class   FormXObject
+     * @brief   Represents a form XObject, a piece of artwork recorded once and drawn on any number of pages.
+     * @details Drawing operations are recorded on the canvas returned by ::getCanvas, with the same API as a Page. The form
+     *          is then stamped with Page::drawFormXObject, which only writes a reference to it, so that the artwork is
+     *          stored once in the document whatever the number of pages using it.
+     * @note    Note that this class cannot be instantiated manually. Rather, it is created when calling Document::createFormXObject.
+     * @file    FormXObject.hpp
+    */
+    class FormXObject final: public ContentStream {
+        _HPDF_Dict_Rec* canvas = nullptr;
+        __HaruppPageState* canvasState = nullptr;
+        Box boundingBox;
+        TransposeMatrix matrix;
+        explicit FormXObject(_HPDF_Dict_Rec* content, _HPDF_Dict_Rec* canvas, const Box& boundingBox, const TransposeMatrix& matrix,
+            const std::atomic<unsigned int>* generation = nullptr, __HaruppPageState* canvasState = nullptr) noexcept;
+        friend class Document;
+
+    public:
+
+        /**
+         * @brief   Gets the canvas recording the drawing operations of the form.
+         * @details The canvas is not part of the document pages. Its coordinates are the ones of the bounding box.
+         * @note    Recording can go on after the form has been stamped, until the document is saved.
+         * @return  Page drawing into the form.
+        */
+        Page getCanvas() const;
+
+        /**
+         * @brief  Gets the bounding box of the form.
+         * @return Box clipping the form, in form coordinates.
+        */
+        Box getBoundingBox() const noexcept;
+
+        /**
+         * @brief  Gets the matrix mapping form coordinates to the coordinates of the page drawing it.
+         * @return Form matrix.
+        */
+        TransposeMatrix getMatrix() const noexcept;
+    };
+}
+
+#endif // __HARUPP_FORMXOBJECT_HPP__
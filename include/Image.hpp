@@ -13,14 +13,16 @@ namespace pdf {
      *         Document::loadJPEGImageFromFile, Document::loadJPEGImageFromMemory,
      *         Document::loadPartialPNGImageFromFile,
      *         Document::loadPNGImageFromFile, Document::loadPNGImageFromMemory,
-     *         Document::loadRawImageFromFile and Document::loadRawImageFromMemory.
+     *         Document::loadRawImageFromFile, Document::loadRawImageFromMappedFile and
+     *         Document::loadRawImageFromMemory, or by a PendingImage.
      * @file   Image.hpp
      * @author Nicolas Almerge
      * @date   2023-05-16
     */
     class Image final: public ContentStream {
-        explicit Image(_HPDF_Dict_Rec* content) noexcept;
+        explicit Image(_HPDF_Dict_Rec* content, const std::atomic<unsigned int>* generation = nullptr) noexcept;
         friend class Document;
+        friend class PendingImage;
 
     public:
 
@@ -0,0 +1,80 @@
+#ifndef __HARUPP_IMAGEDOWNSAMPLING_HPP__
+#define __HARUPP_IMAGEDOWNSAMPLING_HPP__
+#include "Enums.hpp"
+#include "Object.hpp"
+
+namespace pdf {
+
+    /**
+     * \class   ImageDownsampling
+     * @brief   Represents the resolution an image is reduced to when it is loaded.
+     * @details Images are resampled before being compressed, so that they hold no more pixels than needed to be
+     *          drawn at `resolution` DPI on the given size. Images already below that resolution are left untouched.
+     * @note    Only 8 bits images are resampled.
+     * @file    ImageDownsampling.hpp
+    */
+    class ImageDownsampling final: public Object {
+        float resolution = 0.f;
+        float width = 0.f;
+        float height = 0.f;
+        enums::ResamplingFilter filter = enums::ResamplingFilter::LANCZOS;
+
+    public:
+
+        /**
+         * @brief Creates an empty ImageDownsampling, which leaves images untouched.
+        */
+        ImageDownsampling() noexcept;
+
+        /**
+         * @brief Creates an ImageDownsampling.
+         * @param resolution Target effective resolution, in dots per inch.
+         * @param width Width the image is drawn at, as given to Page::drawImage.
+         * @param height Height the image is drawn at, as given to Page::drawImage.
+         * @param filter enums::ResamplingFilter to use.
+        */
+        ImageDownsampling(
+            float resolution, float width, float height,
+            enums::ResamplingFilter filter = enums::ResamplingFilter::LANCZOS
+        ) noexcept;
+
+        /**
+         * @brief  Gets the target resolution.
+         * @return Resolution in dots per inch.
+        */
+        float getResolution() const noexcept;
+
+        /**
+         * @brief  Gets the width the image is drawn at.
+         * @return Width in points.
+        */
+        float getWidth() const noexcept;
+
+        /**
+         * @brief  Gets the height the image is drawn at.
+         * @return Height in points.
+        */
+        float getHeight() const noexcept;
+
+        /**
+         * @brief  Gets the resampling filter.
+         * @return enums::ResamplingFilter of the downsampling.
+        */
+        enums::ResamplingFilter getFilter() const noexcept;
+
+        /**
+         * @brief Computes the size an image is resampled to.
+         * @param width Width of the image in pixels, replaced by the resampled width.
+         * @param height Height of the image in pixels, replaced by the resampled height.
+        */
+        void computeTargetSize(unsigned int& width, unsigned int& height) const noexcept;
+
+        /**
+         * @brief  Checks whether the downsampling is empty.
+         * @return `true` if images are left untouched, `false` otherwise.
+        */
+        bool isEmpty() const noexcept override;
+    };
+}
+
+#endif // __HARUPP_IMAGEDOWNSAMPLING_HPP__
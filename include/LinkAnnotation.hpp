@@ -14,7 +14,7 @@ namespace pdf {
      * @date   2023-05-16
     */
     class LinkAnnotation final: public Annotation {
-        explicit LinkAnnotation(_HPDF_Dict_Rec* content) noexcept;
+        explicit LinkAnnotation(_HPDF_Dict_Rec* content, const std::atomic<unsigned int>* generation = nullptr) noexcept;
         friend class Page;
         using Annotation::setBorderStyle;
 
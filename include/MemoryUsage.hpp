@@ -0,0 +1,64 @@
+#ifndef __HARUPP_MEMORYUSAGE_HPP__
+#define __HARUPP_MEMORYUSAGE_HPP__
+#include "Enums.hpp"
+#include "Object.hpp"
+#include "cstddef"
+
+namespace pdf {
+
+    /**
+     * \class  MemoryUsage
+     * @brief  Represents a snapshot of the memory used by a document.
+     * @note   Note that this class cannot be instantiated manually. Rather, it is created when calling Document::getMemoryUsage.
+     *         Sizes are the number of bytes requested by LibHaru, allocator overhead excluded.
+     * @file   MemoryUsage.hpp
+    */
+    class MemoryUsage final: public Object {
+        std::size_t currentSize = 0U;
+        std::size_t peakSize = 0U;
+        std::size_t allocationCount = 0U;
+        std::size_t categorySizes[4] = {0U, 0U, 0U, 0U};
+        explicit MemoryUsage(std::size_t currentSize, std::size_t peakSize, std::size_t allocationCount, const std::size_t (&categorySizes)[4]) noexcept;
+        friend class Document;
+
+    public:
+
+        /**
+         * @brief Creates a new empty MemoryUsage.
+        */
+        MemoryUsage() noexcept;
+
+        /**
+         * @brief  Gets the number of bytes currently allocated.
+         * @return Current size.
+        */
+        std::size_t getCurrentSize() const noexcept;
+
+        /**
+         * @brief  Gets the highest number of bytes allocated at once since the document was opened.
+         * @return Peak size.
+        */
+        std::size_t getPeakSize() const noexcept;
+
+        /**
+         * @brief  Gets the total number of allocations made since the document was opened.
+         * @return Number of allocations.
+        */
+        std::size_t getAllocationCount() const noexcept;
+
+        /**
+         * @brief  Gets the number of bytes currently allocated for a subsystem.
+         * @param  category Subsystem to use.
+         * @return Current size of the subsystem.
+        */
+        std::size_t getCategorySize(enums::MemoryCategory category) const noexcept;
+
+        /**
+         * @brief  Checks whether the memory usage is empty.
+         * @return `true` if nothing was ever allocated, `false` otherwise.
+        */
+        bool isEmpty() const noexcept override;
+    };
+}
+
+#endif // __HARUPP_MEMORYUSAGE_HPP__
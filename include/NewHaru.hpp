@@ -1,9 +1,13 @@
 #ifndef __NEWHARU_HPP__
 #define __NEWHARU_HPP__
 
+#include "Allocator.hpp"
 #include "Annotation.hpp"
+#include "BatchRenderer.hpp"
 #include "Box.hpp"
 #include "Color.hpp"
+#include "ColorConversion.hpp"
+#include "ColorValue.hpp"
 #include "CompressionMode.hpp"
 #include "Constants.hpp"
 #include "ContentStream.hpp"
@@ -12,18 +16,29 @@
 #include "DateTime.hpp"
 #include "Destination.hpp"
 #include "Document.hpp"
+#include "DocumentPool.hpp"
 #include "Encoder.hpp"
 #include "Enums.hpp"
+#include "ErrorPolicy.hpp"
 #include "Exception.hpp"
 #include "Font.hpp"
+#include "FontCache.hpp"
+#include "FormXObject.hpp"
 #include "Image.hpp"
+#include "ImageDownsampling.hpp"
 #include "LinkAnnotation.hpp"
+#include "MemoryUsage.hpp"
 #include "Object.hpp"
 #include "Outline.hpp"
+#include "OutputSink.hpp"
 #include "Page.hpp"
+#include "PageSpec.hpp"
+#include "PathBuilder.hpp"
+#include "PendingImage.hpp"
 #include "Permissions.hpp"
 #include "TextAnnotation.hpp"
 #include "TextWidth.hpp"
+#include "ThreadPool.hpp"
 #include "TransposeMatrix.hpp"
 #include "Typedefs.hpp"
 #include "Utils.hpp"
@@ -14,7 +14,7 @@ namespace pdf {
      * @date   2023-05-16
     */
     class Outline final: public ContentStream {
-        explicit Outline(_HPDF_Dict_Rec* content) noexcept;
+        explicit Outline(_HPDF_Dict_Rec* content, const std::atomic<unsigned int>* generation = nullptr) noexcept;
         friend class Document;
 
     public:
@@ -0,0 +1,103 @@
+#ifndef __HARUPP_OUTPUTSINK_HPP__
+#define __HARUPP_OUTPUTSINK_HPP__
+#include "ostream"
+#include "vector"
+
+namespace pdf {
+
+    /**
+     * \class  OutputSink
+     * @brief  Represents a destination receiving the bytes of a saved pdf document.
+     * @note   Data is handed over in chunks, in order. Subclasses only need to implement ::write.
+     * @file   OutputSink.hpp
+    */
+    class OutputSink {
+    public:
+        virtual ~OutputSink() noexcept = 0;
+
+        /**
+         * @brief Writes a chunk of bytes to the sink.
+         * @param data Pointer to the first byte of the chunk. It is only valid during the call.
+         * @param size Number of bytes in the chunk.
+        */
+        virtual void write(const unsigned char* data, unsigned int size) = 0;
+    };
+
+    /**
+     * \class  FileDescriptorSink
+     * @brief  Represents an OutputSink writing to a POSIX file descriptor (file, pipe or socket).
+     * @note   The file descriptor is not closed by this class.
+     * @file   OutputSink.hpp
+    */
+    class FileDescriptorSink final: public OutputSink {
+        int fileDescriptor = -1;
+
+    public:
+
+        /**
+         * @brief Creates a new FileDescriptorSink.
+         * @param fileDescriptor Open file descriptor to write to.
+        */
+        explicit FileDescriptorSink(int fileDescriptor) noexcept;
+
+        /**
+         * @brief Writes a chunk of bytes to the file descriptor.
+         * @param data Pointer to the first byte of the chunk.
+         * @param size Number of bytes in the chunk.
+         * @throw excepts::FileIOException if writing failed. The detail code is set to `errno`.
+        */
+        void write(const unsigned char* data, unsigned int size) override;
+    };
+
+    /**
+     * \class  OStreamSink
+     * @brief  Represents an OutputSink writing to a standard output stream.
+     * @file   OutputSink.hpp
+    */
+    class OStreamSink final: public OutputSink {
+        std::ostream& stream;
+
+    public:
+
+        /**
+         * @brief Creates a new OStreamSink.
+         * @param stream Output stream to write to. It must outlive the sink.
+        */
+        explicit OStreamSink(std::ostream& stream) noexcept;
+
+        /**
+         * @brief Writes a chunk of bytes to the output stream.
+         * @param data Pointer to the first byte of the chunk.
+         * @param size Number of bytes in the chunk.
+         * @throw excepts::FileIOException if the stream is in a failed state after writing.
+        */
+        void write(const unsigned char* data, unsigned int size) override;
+    };
+
+    /**
+     * \class  BufferSink
+     * @brief  Represents an OutputSink appending to a caller-provided byte buffer.
+     * @note   The buffer grows as needed. Reserve capacity up front to avoid reallocations.
+     * @file   OutputSink.hpp
+    */
+    class BufferSink final: public OutputSink {
+        std::vector<unsigned char>& buffer;
+
+    public:
+
+        /**
+         * @brief Creates a new BufferSink.
+         * @param buffer Buffer to append to. It must outlive the sink.
+        */
+        explicit BufferSink(std::vector<unsigned char>& buffer) noexcept;
+
+        /**
+         * @brief Appends a chunk of bytes to the buffer.
+         * @param data Pointer to the first byte of the chunk.
+         * @param size Number of bytes in the chunk.
+        */
+        void write(const unsigned char* data, unsigned int size) override;
+    };
+}
+
+#endif // __HARUPP_OUTPUTSINK_HPP__
@@ -5,14 +5,20 @@
 #include "DashMode.hpp"
 #include "Destination.hpp"
 #include "Font.hpp"
+#include "FormXObject.hpp"
 #include "Encoder.hpp"
 #include "Enums.hpp"
 #include "Image.hpp"
 #include "LinkAnnotation.hpp"
+#include "PathBuilder.hpp"
 #include "TextAnnotation.hpp"
 #include "TransposeMatrix.hpp"
+#include "cstddef"
 #include "string"
 #include "utility"
+#include "vector"
+
+struct __HaruppPageState;
 
 namespace pdf {
 
@@ -20,14 +26,19 @@ namespace pdf {
      * \class  Page
      * @brief  Represents a pdf document page.
      * @note   Note that this class cannot be instantiated manually. Rather, it is created when calling
-     *         Document::addPage, Document::getCurrentPage, Document::getPageAtIndex and Document::insertPageBefore.
+     *         Document::addPage, Document::addPages, Document::getCurrentPage, Document::getPageAtIndex,
+     *         Document::insertPageBefore and FormXObject::getCanvas.
+     *         The graphics state is mirrored on the wrapper side: its getters do not go through LibHaru, and its setters
+     *         write nothing when the value is already in effect (see ::getElidedOperatorCount).
      * @file   Page.hpp
      * @author Nicolas Almerge
      * @date   2023-05-16
     */
     class Page final: public ContentStream {
-        explicit Page(_HPDF_Dict_Rec* content) noexcept;
+        __HaruppPageState* __state = nullptr;
+        explicit Page(_HPDF_Dict_Rec* content, const std::atomic<unsigned int>* generation = nullptr, __HaruppPageState* state = nullptr) noexcept;
         friend class Document;
+        friend class FormXObject;
 
     public:
 
@@ -324,6 +335,14 @@ namespace pdf {
         */
         unsigned int getGStateDepth() const;
 
+        /**
+         * @brief   Gets the number of graphics state operators that were not written because they changed nothing.
+         * @details The count is shared by every Page object of the same page. State set by a shared content stream
+         *          (see ::insertSharedContentStream) is considered unknown, so it is always written again.
+         * @return  Number of elided operators.
+        */
+        unsigned long getElidedOperatorCount() const;
+
         /**
          * @brief Configures the setting for slide transition of the page.
          * @param type Transition type.
@@ -344,6 +363,16 @@ namespace pdf {
         */
         void insertSharedContentStream(const ContentStream& sharedStream);
 
+        /**
+         * @brief Appends every operator of a path built in memory.
+         * @note  The graphics mode is checked once, before writing the whole path.
+         * @param path Path to append.
+         * @pre   The graphics mode must be set to enums::GraphicsMode::PAGE_DESCRIPTION or enums::GraphicsMode::PATH_OBJECT before calling this function.
+         *        If the path does not start with PathBuilder::moveTo or PathBuilder::rectangle, it must be set to enums::GraphicsMode::PATH_OBJECT.
+         * @post  The graphics mode will be set to enums::GraphicsMode::PATH_OBJECT after calling this function, unless the path is empty.
+        */
+        void appendPath(const PathBuilder& path);
+
         /**
          * @brief Appends a circle arc to the current path.
          * @param coors Center point of the circle.
@@ -459,6 +488,17 @@ namespace pdf {
         */
         void drawImage(const Image& image, const Coor2D& coors, float width, float height);
 
+        /**
+         * @brief Draws a FormXObject in one operation.
+         * @note  Only a reference to the form is written to the page, however often it is drawn.
+         * @param form FormXObject to use.
+         * @param coors The point where the origin of the form should be displayed.
+         * @param xScale Horizontal scale to apply to the form.
+         * @param yScale Vertical scale to apply to the form.
+         * @pre   The graphics mode must be set to enums::GraphicsMode::PAGE_DESCRIPTION before calling this function.
+        */
+        void drawFormXObject(const FormXObject& form, const Coor2D& coors, float xScale = 1.f, float yScale = 1.f);
+
         /**
          * @brief Appends an ellipse to the current path.
          * @param coors Center point of the ellipse.
@@ -597,6 +637,60 @@ namespace pdf {
         */
         void moveToNextLine();
 
+        /**
+         * @brief Appends independent line segments to the current path.
+         * @note  Each pair of points is written as a new subpath, e.g. `{a, b, c, d}` draws the lines `ab` and `cd`.
+         * @param points Start and end points of the segments.
+         * @param count Number of points.
+         * @throw excepts::InvalidParameterException if `count` is odd.
+         * @pre   The graphics mode must be set to enums::GraphicsMode::PAGE_DESCRIPTION or enums::GraphicsMode::PATH_OBJECT before calling this function.
+         * @post  The graphics mode will be set to enums::GraphicsMode::PATH_OBJECT after calling this function, unless `count` is `0`.
+        */
+        void multiLine(const Coor2D* points, std::size_t count);
+
+        /**
+         * @brief Appends independent line segments to the current path.
+         * @see   multiLine(const Coor2D*, std::size_t)
+         * @param points Start and end points of the segments.
+         * @throw excepts::InvalidParameterException if the number of points is odd.
+        */
+        void multiLine(const std::vector<Coor2D>& points);
+
+        /**
+         * @brief Appends a closed subpath through points to the current path.
+         * @note  This is a polyline followed by a closePath.
+         * @param points Points of the polygon.
+         * @param count Number of points.
+         * @pre   The graphics mode must be set to enums::GraphicsMode::PAGE_DESCRIPTION or enums::GraphicsMode::PATH_OBJECT before calling this function.
+         * @post  The graphics mode will be set to enums::GraphicsMode::PATH_OBJECT after calling this function, unless `count` is `0`.
+        */
+        void polygon(const Coor2D* points, std::size_t count);
+
+        /**
+         * @brief Appends a closed subpath through points to the current path.
+         * @see   polygon(const Coor2D*, std::size_t)
+         * @param points Points of the polygon.
+        */
+        void polygon(const std::vector<Coor2D>& points);
+
+        /**
+         * @brief Appends a subpath through points to the current path.
+         * @note  The first point starts the subpath, the others are joined with lines. The graphics mode is checked
+         *        once for all the points.
+         * @param points Points of the polyline.
+         * @param count Number of points.
+         * @pre   The graphics mode must be set to enums::GraphicsMode::PAGE_DESCRIPTION or enums::GraphicsMode::PATH_OBJECT before calling this function.
+         * @post  The graphics mode will be set to enums::GraphicsMode::PATH_OBJECT after calling this function, unless `count` is `0`.
+        */
+        void polyline(const Coor2D* points, std::size_t count);
+
+        /**
+         * @brief Appends a subpath through points to the current path.
+         * @see   polyline(const Coor2D*, std::size_t)
+         * @param points Points of the polyline.
+        */
+        void polyline(const std::vector<Coor2D>& points);
+
         /**
          * @brief Appends a rectangle to the current path.
          * @param lowerLeftCoors Lower left point of the rectangle.
@@ -615,18 +709,18 @@ namespace pdf {
         void setCharSpace(float value);
 
         /**
-         * @brief Sets the filling CMYKColor.
-         * @param color CMYKColor to use for filling.
+         * @brief Sets the filling CMYK color.
+         * @param color CMYKValue (or CMYKColor, which converts to it) to use for filling.
          * @pre   The graphics mode must be set to enums::GraphicsMode::PAGE_DESCRIPTION or enums::GraphicsMode::TEXT_OBJECT before calling this function.
         */
-        void setCMYKFill(const CMYKColor& color);
+        void setCMYKFill(const CMYKValue& color);
 
         /**
-         * @brief Sets the stroking CMYKColor.
-         * @param color CMYKColor to use for stroking.
+         * @brief Sets the stroking CMYK color.
+         * @param color CMYKValue (or CMYKColor, which converts to it) to use for stroking.
          * @pre   The graphics mode must be set to enums::GraphicsMode::PAGE_DESCRIPTION or enums::GraphicsMode::TEXT_OBJECT before calling this function.
         */
-        void setCMYKStroke(const CMYKColor& color);
+        void setCMYKStroke(const CMYKValue& color);
 
         /**
          * @brief Sets the dash pattern for lines in the page.
@@ -699,18 +793,18 @@ namespace pdf {
         void setMiterLimit(float miterLimit);
 
         /**
-         * @brief Sets the filling RGBColor.
-         * @param color RGBColor to use for filling.
+         * @brief Sets the filling RGB color.
+         * @param color RGBValue (or RGBColor, which converts to it) to use for filling.
          * @pre   The graphics mode must be set to enums::GraphicsMode::PAGE_DESCRIPTION or enums::GraphicsMode::TEXT_OBJECT before calling this function.
         */
-        void setRGBFill(const RGBColor& color);
+        void setRGBFill(const RGBValue& color);
 
         /**
-         * @brief Sets the stroking RGBColor.
-         * @param color RGBColor to use for stroking.
+         * @brief Sets the stroking RGB color.
+         * @param color RGBValue (or RGBColor, which converts to it) to use for stroking.
          * @pre   The graphics mode must be set to enums::GraphicsMode::PAGE_DESCRIPTION or enums::GraphicsMode::TEXT_OBJECT before calling this function.
         */
-        void setRGBStroke(const RGBColor& color);
+        void setRGBStroke(const RGBValue& color);
 
         /**
          * @brief Sets the line spacing for text displaying.
@@ -0,0 +1,117 @@
+#ifndef __HARUPP_PAGESPEC_HPP__
+#define __HARUPP_PAGESPEC_HPP__
+#include "Box.hpp"
+#include "Enums.hpp"
+#include "Object.hpp"
+
+namespace pdf {
+
+    /**
+     * \class  PageSpec
+     * @brief  Represents the layout shared by pages created with Document::addPages.
+     * @note   Boundaries that are not set are left to their LibHaru defaults.
+     * @file   PageSpec.hpp
+    */
+    class PageSpec final: public Object {
+        float width = 0.f;
+        float height = 0.f;
+        enums::PageSize size = enums::PageSize::A4;
+        enums::PageOrientation orientation = enums::PageOrientation::PORTRAIT;
+        bool predefinedSize = false;
+        enums::PageRotation rotation = enums::PageRotation::NONE;
+        Box boundaries[5];
+
+    public:
+
+        /**
+         * @brief   Creates an empty PageSpec.
+         * @details Pages keep the LibHaru default size.
+        */
+        PageSpec() noexcept;
+
+        /**
+         * @brief Creates a PageSpec from a predefined size.
+         * @param size enums::PageSize to use.
+         * @param orientation enums::PageOrientation to use.
+         * @param rotation enums::PageRotation to use.
+        */
+        PageSpec(enums::PageSize size, enums::PageOrientation orientation = enums::PageOrientation::PORTRAIT,
+            enums::PageRotation rotation = enums::PageRotation::NONE) noexcept;
+
+        /**
+         * @brief   Creates a PageSpec from dimensions.
+         * @details A dimension of `0` is not set, and keeps the LibHaru default (e.g. `PageSpec(300.f, 0.f)` makes pages 300
+         *          wide with the default height). Set dimensions must be between 3 and 14400, otherwise
+         *          Document::addPages adds no page and fails with an InvalidPageSizeException.
+         * @param   width Page width, or `0` to keep the default one.
+         * @param   height Page height, or `0` to keep the default one.
+         * @param   rotation enums::PageRotation to use.
+        */
+        PageSpec(float width, float height, enums::PageRotation rotation = enums::PageRotation::NONE) noexcept;
+
+        /**
+         * @brief Sets a page boundary.
+         * @note  Setting the enums::PageBoundary::MEDIABOX boundary overrides the size of the spec.
+         * @param pageBoundary Page boundary mode to use.
+         * @param box Box to use for the borders. An empty box unsets the boundary.
+        */
+        void setBoundary(enums::PageBoundary pageBoundary, const Box& box) noexcept;
+
+        /**
+         * @brief Sets the page rotation.
+         * @param rotation enums::PageRotation to use.
+        */
+        void setRotation(enums::PageRotation rotation) noexcept;
+
+        /**
+         * @brief  Gets a page boundary.
+         * @param  pageBoundary Page boundary mode to get.
+         * @return Box of the boundary, empty if it is not set.
+        */
+        Box getBoundary(enums::PageBoundary pageBoundary) const noexcept;
+
+        /**
+         * @brief  Gets the page rotation.
+         * @return enums::PageRotation of the spec.
+        */
+        enums::PageRotation getRotation() const noexcept;
+
+        /**
+         * @brief  Checks whether the spec uses a predefined size.
+         * @return `true` if the spec was created from an enums::PageSize, `false` otherwise.
+        */
+        bool hasPredefinedSize() const noexcept;
+
+        /**
+         * @brief  Gets the predefined page size.
+         * @return enums::PageSize of the spec. Only meaningful if ::hasPredefinedSize returns `true`.
+        */
+        enums::PageSize getSize() const noexcept;
+
+        /**
+         * @brief  Gets the page orientation.
+         * @return enums::PageOrientation of the spec. Only meaningful if ::hasPredefinedSize returns `true`.
+        */
+        enums::PageOrientation getOrientation() const noexcept;
+
+        /**
+         * @brief  Gets the page width.
+         * @return Page width, or `0` if the spec uses a predefined size or the default one.
+        */
+        float getWidth() const noexcept;
+
+        /**
+         * @brief  Gets the page height.
+         * @return Page height, or `0` if the spec uses a predefined size or the default one.
+        */
+        float getHeight() const noexcept;
+
+        /**
+         * @brief  Checks whether the spec is empty.
+         * @return `true` if the spec changes nothing from the LibHaru defaults, `false` otherwise.
+        */
+        bool isEmpty() const noexcept override;
+    };
+}
+
+#endif // __HARUPP_PAGESPEC_HPP__
@@ -0,0 +1,111 @@
+#ifndef __HARUPP_PATHBUILDER_HPP__
+#define __HARUPP_PATHBUILDER_HPP__
+#include "Coor2D.hpp"
+#include "Object.hpp"
+#include "cstddef"
+#include "vector"
+
+namespace pdf {
+    class Page;
+
+    /**
+     * \class   PathBuilder
+     * @brief   Represents a path built in memory, then appended to a Page at once with Page::appendPath.
+     * @details Building a path does not touch the page. Appending it checks the graphics mode once and writes all of its
+     *          operators in a single pass, instead of one LibHaru call per segment. The builder can be reused for
+     *          several pages.
+     * @file    PathBuilder.hpp
+    */
+    class PathBuilder final: public Object {
+        // Path operators (`m`, `l`, `c`, `h` and `r` for `re`) and their operands, in order
+        std::vector<char> operators;
+        std::vector<float> operands;
+        friend class Page;
+
+    public:
+
+        /**
+         * @brief Creates an empty PathBuilder.
+        */
+        PathBuilder() noexcept;
+
+        /**
+         * @brief  Starts a new subpath.
+         * @param  coors Start point of the subpath.
+         * @return Current builder.
+        */
+        PathBuilder& moveTo(const Coor2D& coors);
+
+        /**
+         * @brief  Appends a line from the current point.
+         * @param  coors End point of the line.
+         * @return Current builder.
+        */
+        PathBuilder& lineTo(const Coor2D& coors);
+
+        /**
+         * @brief  Appends a Bézier curve from the current point.
+         * @param  first First control point.
+         * @param  second Second control point.
+         * @param  third End point of the curve.
+         * @return Current builder.
+        */
+        PathBuilder& curveTo(const Coor2D& first, const Coor2D& second, const Coor2D& third);
+
+        /**
+         * @brief  Closes the current subpath with a line to its start point.
+         * @return Current builder.
+        */
+        PathBuilder& closePath();
+
+        /**
+         * @brief  Appends a rectangle as a closed subpath.
+         * @param  lowerLeftCoors Lower left point of the rectangle.
+         * @param  width Width of the rectangle.
+         * @param  height Height of the rectangle.
+         * @return Current builder.
+        */
+        PathBuilder& rectangle(const Coor2D& lowerLeftCoors, float width, float height);
+
+        /**
+         * @brief  Appends a subpath through points.
+         * @param  points Points of the polyline, the first one starts the subpath.
+         * @param  count Number of points.
+         * @return Current builder.
+        */
+        PathBuilder& polyline(const Coor2D* points, std::size_t count);
+
+        /**
+         * @brief  Appends a closed subpath through points.
+         * @param  points Points of the polygon, the first one starts the subpath.
+         * @param  count Number of points.
+         * @return Current builder.
+        */
+        PathBuilder& polygon(const Coor2D* points, std::size_t count);
+
+        /**
+         * @brief Reserves memory for a number of operators.
+         * @param operatorCount Number of operators the path is expected to hold.
+        */
+        void reserve(std::size_t operatorCount);
+
+        /**
+         * @brief Removes every operator, keeping the memory for reuse.
+        */
+        void clear() noexcept;
+
+        /**
+         * @brief  Gets the number of path operators.
+         * @return Number of operators appended since the builder was created or cleared.
+        */
+        std::size_t getOperatorCount() const noexcept;
+
+        /**
+         * @brief  Checks whether the path is empty.
+         * @return `true` if the path has no operator, `false` otherwise.
+        */
+        bool isEmpty() const noexcept override;
+    };
+}
+
+#endif // __HARUPP_PATHBUILDER_HPP__
@@ -0,0 +1,72 @@
+#ifndef __HARUPP_PENDINGIMAGE_HPP__
+#define __HARUPP_PENDINGIMAGE_HPP__
+#include "Image.hpp"
+#include "Object.hpp"
+#include "memory"
+
+struct __HaruppImageJob;
+
+namespace pdf {
+
+    /**
+     * \class   PendingImage
+     * @brief   Represents an image being decoded by a ThreadPool.
+     * @details The image handle is usable right away, e.g. to be drawn with Page::drawImage, while the file is read,
+     *          decoded and compressed by a worker. Its data, size and color properties are filled in on the document
+     *          thread once decoding is over, either by ::get or when the document is saved.
+     * @note    Note that this class cannot be instantiated manually. Rather, it is created when calling
+     *          Document::loadPNGImageFromFileAsync or Document::loadJPEGImageFromFileAsync.
+     * @note    ::get must be called from the thread using the document, like any other document function.
+     * @file    PendingImage.hpp
+    */
+    class PendingImage final: public Object {
+        std::shared_ptr<__HaruppImageJob> job;
+        Image image;
+
+        PendingImage(std::shared_ptr<__HaruppImageJob> job, const Image& image) noexcept;
+        friend class Document;
+
+    public:
+
+        /**
+         * @brief Creates a new empty PendingImage.
+        */
+        PendingImage() noexcept;
+
+        /**
+         * @brief  Checks whether the worker is done with the image.
+         * @return `true` if the image is decoded (or failed to), `false` otherwise.
+        */
+        bool isReady() const;
+
+        /**
+         * @brief Waits until the worker is done with the image.
+        */
+        void wait() const;
+
+        /**
+         * @brief  Gets the image handle without waiting.
+         * @note   Until the image is resolved, its size and color properties are not set.
+         * @return Image that will hold the decoded data.
+        */
+        const Image& getImage() const noexcept;
+
+        /**
+         * @brief  Waits for the image to be decoded, then fills in the image handle.
+         * @note   If the image could not be read or decoded, it is replaced with a white 1x1 image before throwing, so that
+         *         pages drawing it can still be saved.
+         * @return The complete image.
+         * @throw  excepts::FileOpeningException if the file could not be read.
+         * @throw  excepts::InvalidPNGImageException or excepts::UnsupportedJPEGFormatException if the image could not be decoded.
+        */
+        Image get();
+
+        /**
+         * @brief  Checks whether the pending image is empty.
+         * @return `true` if no image is being loaded, `false` otherwise.
+        */
+        bool isEmpty() const noexcept override;
+    };
+}
+
+#endif // __HARUPP_PENDINGIMAGE_HPP__
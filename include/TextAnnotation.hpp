@@ -13,7 +13,7 @@ namespace pdf {
      * @date   2023-05-16
     */
     class TextAnnotation final: public Annotation {
-        explicit TextAnnotation(_HPDF_Dict_Rec* content) noexcept;
+        explicit TextAnnotation(_HPDF_Dict_Rec* content, const std::atomic<unsigned int>* generation = nullptr) noexcept;
         friend class Page;
 
     public:
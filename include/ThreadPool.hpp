@@ -0,0 +1,108 @@
+#ifndef __HARUPP_THREADPOOL_HPP__
+#define __HARUPP_THREADPOOL_HPP__
+#include "atomic"
+#include "condition_variable"
+#include "deque"
+#include "functional"
+#include "memory"
+#include "mutex"
+#include "thread"
+#include "vector"
+
+namespace pdf {
+
+    /**
+     * \class   ThreadPool
+     * @brief   Represents a fixed set of worker threads running tasks.
+     * @details Every worker owns a task queue. A worker runs the most recent task of its own queue first and, once it is
+     *          empty, steals the oldest task of another worker, so that load is balanced without a single contended queue.
+     *          Tasks submitted from outside the pool are spread over the workers in turn, while tasks submitted from a
+     *          worker go to its own queue.
+     * @note    When a capacity is set, ::submit blocks while that many tasks are waiting to be run (backpressure).
+     *          Tasks submitted from a worker are never blocked, to avoid deadlocks.
+     * @file    ThreadPool.hpp
+    */
+    class ThreadPool final {
+    public:
+        /// Task run by the pool. Like with std::thread, an exception escaping a task calls std::terminate.
+        typedef std::function<void()> Task;
+
+    private:
+        struct Worker {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::vector<std::thread> threads;
+        mutable std::mutex mutex;
+        std::condition_variable workAvailable;
+        std::condition_variable spaceAvailable;
+        std::condition_variable allDone;
+        std::size_t capacity;
+        std::size_t pendingCount = 0U;
+        std::size_t activeCount = 0U;
+        std::atomic<std::size_t> queuedCount{0U};
+        std::atomic<unsigned int> nextWorker{0U};
+        bool stopping = false;
+
+        void __push(Task&& task);
+        bool __pop(unsigned int index, Task& task);
+        void __run(unsigned int index);
+
+    public:
+
+        /**
+         * @brief Creates a new ThreadPool and starts its workers.
+         * @param threadCount Number of workers. `0` uses the number of hardware threads.
+         * @param capacity Maximum number of tasks waiting to be run. `0` means unbounded.
+        */
+        explicit ThreadPool(unsigned int threadCount = 0U, std::size_t capacity = 0U);
+
+        /**
+         * @brief Runs the remaining tasks, then stops and joins the workers.
+        */
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /**
+         * @brief Submits a task, waiting for room in the queue if the pool is at capacity.
+         * @param task Task to run.
+        */
+        void submit(Task task);
+
+        /**
+         * @brief  Submits a task if the pool is not at capacity.
+         * @param  task Task to run.
+         * @return `true` if the task was submitted, `false` if the pool is full.
+        */
+        bool trySubmit(Task task);
+
+        /**
+         * @brief Waits until every submitted task has been run.
+        */
+        void wait();
+
+        /**
+         * @brief  Gets the number of workers.
+         * @return Number of workers.
+        */
+        unsigned int getThreadCount() const noexcept;
+
+        /**
+         * @brief  Gets the number of tasks waiting to be run.
+         * @return Number of pending tasks.
+        */
+        std::size_t getPendingCount() const;
+
+        /**
+         * @brief  Gets the index of the worker running the calling thread.
+         * @return Worker index, or `-1` if the calling thread is not a worker of any pool.
+        */
+        static int getCurrentWorkerIndex() noexcept;
+    };
+}
+
+#endif // __HARUPP_THREADPOOL_HPP__
@@ -1,15 +1,19 @@
 #ifndef __HARUPP_TRANSPOSEMATRIX_HPP__
 #define __HARUPP_TRANSPOSEMATRIX_HPP__
+#include "Box.hpp"
+#include "Coor2D.hpp"
 #include "Object.hpp"
+#include "cstddef"
 
 namespace pdf {
 
     /**
-     * \class  TransposeMatrix
-     * @brief  Represents a transpose matrix.
-     * @file   TransposeMatrix.hpp
-     * @author Nicolas Almerge
-     * @date   2023-05-16
+     * \class   TransposeMatrix
+     * @brief   Represents a transpose matrix.
+     * @details The matrix maps a point `(px, py)` to `(a * px + c * py + x, b * px + d * py + y)`, as PDF does.
+     * @file    TransposeMatrix.hpp
+     * @author  Nicolas Almerge
+     * @date    2023-05-16
     */
     class TransposeMatrix final: public Object {
         float a = 0.f;
@@ -79,6 +83,113 @@ namespace pdf {
          * @return Y coordinate.
         */
         float getY() const noexcept;
+
+        /**
+         * @brief  Creates the identity matrix.
+         * @return Matrix leaving points unchanged.
+        */
+        static TransposeMatrix identity() noexcept;
+
+        /**
+         * @brief  Creates a translation matrix.
+         * @param  x Horizontal offset.
+         * @param  y Vertical offset.
+         * @return Matrix moving points by `(x, y)`.
+        */
+        static TransposeMatrix translation(float x, float y) noexcept;
+
+        /**
+         * @brief  Creates a rotation matrix.
+         * @param  angle Counterclockwise angle, in radians.
+         * @return Matrix rotating points around the origin.
+        */
+        static TransposeMatrix rotation(float angle) noexcept;
+
+        /**
+         * @brief  Creates a scaling matrix.
+         * @param  x Horizontal factor.
+         * @param  y Vertical factor.
+         * @return Matrix scaling points from the origin.
+        */
+        static TransposeMatrix scaling(float x, float y) noexcept;
+
+        /**
+         * @brief  Creates a skewing matrix.
+         * @param  alpha Angle the x axis is skewed by, in radians.
+         * @param  beta Angle the y axis is skewed by, in radians.
+         * @return Matrix skewing points.
+        */
+        static TransposeMatrix skewing(float alpha, float beta) noexcept;
+
+        /**
+         * @brief   Concatenates two matrices.
+         * @details The result applies the current matrix first, then `other`. Page::concat with a matrix `m` thus turns
+         *          the current transformation matrix `ctm` into `m * ctm`.
+         * @param   other Matrix applied second.
+         * @return  Concatenated matrix.
+        */
+        TransposeMatrix operator*(const TransposeMatrix& other) const noexcept;
+
+        /**
+         * @brief  Concatenates a matrix to the current one, see ::operator*.
+         * @param  other Matrix applied second.
+         * @return Current matrix.
+        */
+        TransposeMatrix& operator*=(const TransposeMatrix& other) noexcept;
+
+        /**
+         * @brief  Checks whether two matrices are equal.
+         * @return `true` if all coordinates are equal, `false` otherwise.
+        */
+        bool operator==(const TransposeMatrix& other) const noexcept;
+
+        /**
+         * @brief  Checks whether two matrices are not equal.
+         * @return `true` if a coordinate differs, `false` otherwise.
+        */
+        bool operator!=(const TransposeMatrix& other) const noexcept;
+
+        /**
+         * @brief  Gets the determinant of the linear part of the matrix.
+         * @return `a * d - b * c`.
+        */
+        float getDeterminant() const noexcept;
+
+        /**
+         * @brief  Inverts the matrix.
+         * @return Matrix undoing the current one, or an empty matrix if the current one cannot be inverted.
+        */
+        TransposeMatrix inverse() const noexcept;
+
+        /**
+         * @brief  Transforms a point.
+         * @param  point Point to transform.
+         * @return Transformed point.
+        */
+        Coor2D transform(const Coor2D& point) const noexcept;
+
+        /**
+         * @brief  Transforms a box.
+         * @param  box Box to transform.
+         * @return Smallest box holding the four transformed corners of `box`.
+        */
+        Box transform(const Box& box) const noexcept;
+
+        /**
+         * @brief Transforms points.
+         * @param points Points to transform.
+         * @param results Transformed points, `count` of them. It may be `points` itself.
+         * @param count Number of points.
+        */
+        void transform(const Coor2D* points, Coor2D* results, std::size_t count) const noexcept;
+
+        /**
+         * @brief Transforms points given as interleaved coordinates, several at a time with SSE or NEON.
+         * @param points Interleaved x and y coordinates.
+         * @param results Transformed coordinates, `2 * count` of them. It may be `points` itself.
+         * @param count Number of points.
+        */
+        void transform(const float* points, float* results, std::size_t count) const noexcept;
     };
 }
 
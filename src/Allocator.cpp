@@ -0,0 +1,95 @@
+#include "../include/Allocator.hpp"
+#include "cstdlib"
+#include "new"
+using namespace pdf;
+
+
+/****************************** HELPERS ******************************/
+static constexpr std::size_t __haruppAlign(std::size_t size) noexcept {
+    constexpr std::size_t alignment = alignof(std::max_align_t);
+    return (size + alignment - 1U) & ~(alignment - 1U);
+}
+
+
+/****************************** ALLOCATOR ******************************/
+Allocator::~Allocator() noexcept {}
+
+void Allocator::reset() noexcept {}
+
+
+/****************************** MEMORY ARENA ******************************/
+struct MemoryArena::Block {
+    Block* next;
+    std::size_t capacity;
+    std::size_t offset;
+
+    unsigned char* data() noexcept {
+        return reinterpret_cast<unsigned char*>(this) + __haruppAlign(sizeof(Block));
+    }
+};
+
+MemoryArena::MemoryArena(std::size_t blockSize) noexcept: blockSize(__haruppAlign(blockSize)) {}
+
+MemoryArena::~MemoryArena() noexcept {
+    reset();
+    if (blocks != nullptr) std::free(blocks);
+}
+
+void* MemoryArena::allocate(std::size_t size) {
+    size = __haruppAlign((size == 0U)? 1U: size);
+
+    // Fast path: bump the pointer of the current block
+    if (blocks != nullptr && blocks->capacity - blocks->offset >= size) {
+        void* pointer = blocks->data() + blocks->offset;
+        blocks->offset += size;
+        usedSize += size;
+        return pointer;
+    }
+
+    // Slow path: request a new block from the system
+    std::size_t capacity = (size > blockSize)? size: blockSize;
+    Block* block = static_cast<Block*>(std::malloc(__haruppAlign(sizeof(Block)) + capacity));
+    if (block == nullptr) throw std::bad_alloc();
+    block->capacity = capacity;
+    block->offset = size;
+    reservedSize += capacity;
+    usedSize += size;
+
+    // Oversized blocks are put behind the current one, so that its free space is not lost
+    if (capacity > blockSize && blocks != nullptr) {
+        block->next = blocks->next;
+        blocks->next = block;
+    } else {
+        block->next = blocks;
+        blocks = block;
+    }
+    return block->data();
+}
+
+void MemoryArena::deallocate(void*) noexcept {}
+
+void MemoryArena::reset() noexcept {
+    // Keep the last standard-sized block for the next document
+    Block* kept = nullptr;
+    while (blocks != nullptr) {
+        Block* next = blocks->next;
+        if (kept == nullptr && blocks->capacity == blockSize) kept = blocks;
+        else std::free(blocks);
+        blocks = next;
+    }
+    if (kept != nullptr) {
+        kept->next = nullptr;
+        kept->offset = 0U;
+    }
+    blocks = kept;
+    usedSize = 0U;
+    reservedSize = (kept != nullptr)? kept->capacity: 0U;
+}
+
+std::size_t MemoryArena::getUsedSize() const noexcept {
+    return usedSize;
+}
+
+std::size_t MemoryArena::getReservedSize() const noexcept {
+    return reservedSize;
+}
@@ -0,0 +1,117 @@
+#include "../include/BatchRenderer.hpp"
+#include "../include/Exception.hpp"
+using namespace pdf;
+
+
+/****************************** HELPERS ******************************/
+// Every worker allocates its documents from its own arena, reset after each job
+static thread_local MemoryArena __workerArena;
+
+
+/******************** RENDER RESULT ********************/
+
+RenderResult::RenderResult() noexcept {}
+
+std::size_t RenderResult::getJobId() const noexcept {
+    return jobId;
+}
+
+bool RenderResult::isSuccessful() const noexcept {
+    return successful;
+}
+
+unsigned long RenderResult::getErrorCode() const noexcept {
+    return errorCode;
+}
+
+unsigned long RenderResult::getDetailCode() const noexcept {
+    return detailCode;
+}
+
+const std::string& RenderResult::getErrorMessage() const noexcept {
+    return errorMessage;
+}
+
+const std::vector<unsigned char>& RenderResult::getOutput() const noexcept {
+    return output;
+}
+
+std::vector<unsigned char> RenderResult::takeOutput() noexcept {
+    return std::move(output);
+}
+
+std::chrono::nanoseconds RenderResult::getWaitTime() const noexcept {
+    return waitTime;
+}
+
+std::chrono::nanoseconds RenderResult::getRenderTime() const noexcept {
+    return renderTime;
+}
+
+bool RenderResult::isEmpty() const noexcept {
+    return output.empty();
+}
+
+
+/******************** BATCH RENDERER ********************/
+
+BatchRenderer::BatchRenderer(unsigned int threadCount, std::size_t queueCapacity, bool collectOutput):
+    pool(threadCount, queueCapacity), collectOutput(collectOutput) {}
+
+ThreadPool::Task BatchRenderer::__makeTask(RenderFunction&& render, std::shared_ptr<std::promise<RenderResult>> promise) {
+    std::size_t jobId = nextJobId.fetch_add(1U, std::memory_order_relaxed);
+    std::chrono::steady_clock::time_point submitted = std::chrono::steady_clock::now();
+    bool collect = collectOutput;
+
+    return [render = std::move(render), promise = std::move(promise), jobId, submitted, collect]() {
+        RenderResult result;
+        result.jobId = jobId;
+        std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+        result.waitTime = started - submitted;
+
+        try {
+            Document document;
+            document.open(__workerArena);
+            render(document);
+            if (collect && document.isOpen() && document.hasDocument()) {
+                BufferSink sink(result.output);
+                document.saveToSink(sink);
+            }
+            result.successful = true;
+        } catch (const excepts::Exception& exception) {
+            result.errorCode = exception.getErrorCode();
+            result.detailCode = exception.getDetailCode();
+            result.errorMessage = exception.what();
+        } catch (const std::exception& exception) {
+            result.errorMessage = exception.what();
+        } catch (...) {
+            result.errorMessage = "Unknown exception.";
+        }
+        if (!result.successful) result.output.clear();
+
+        result.renderTime = std::chrono::steady_clock::now() - started;
+        promise->set_value(std::move(result));
+    };
+}
+
+std::future<RenderResult> BatchRenderer::submit(RenderFunction render) {
+    std::shared_ptr<std::promise<RenderResult>> promise = std::make_shared<std::promise<RenderResult>>();
+    std::future<RenderResult> future = promise->get_future();
+    pool.submit(__makeTask(std::move(render), std::move(promise)));
+    return future;
+}
+
+std::optional<std::future<RenderResult>> BatchRenderer::trySubmit(RenderFunction render) {
+    std::shared_ptr<std::promise<RenderResult>> promise = std::make_shared<std::promise<RenderResult>>();
+    std::future<RenderResult> future = promise->get_future();
+    if (!pool.trySubmit(__makeTask(std::move(render), std::move(promise)))) return std::nullopt;
+    return future;
+}
+
+void BatchRenderer::wait() {
+    pool.wait();
+}
+
+unsigned int BatchRenderer::getThreadCount() const noexcept {
+    return pool.getThreadCount();
+}
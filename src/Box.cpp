@@ -1,4 +1,5 @@
 #include "../include/Box.hpp"
+#include "../include/TransposeMatrix.hpp"
 using namespace pdf;
 
 
@@ -25,3 +26,7 @@ float Box::getRight() const noexcept {
 float Box::getTop() const noexcept {
     return top;
 }
+
+Box Box::transform(const TransposeMatrix& matrix) const noexcept {
+    return matrix.transform(*this);
+}
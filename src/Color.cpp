@@ -22,6 +22,12 @@ CMYKColor::CMYKColor() noexcept {}
 
 CMYKColor::CMYKColor(float c, float m, float y, float k) noexcept: c(c), m(m), y(y), k(k) {}
 
+CMYKColor::CMYKColor(const CMYKValue& value) noexcept: c(value.getC()), m(value.getM()), y(value.getY()), k(value.getK()) {}
+
+CMYKColor::operator CMYKValue() const noexcept {
+    return CMYKValue(c, m, y, k);
+}
+
 float CMYKColor::getC() const noexcept {
     return c;
 }
@@ -72,6 +78,12 @@ RGBColor::RGBColor() noexcept {}
 
 RGBColor::RGBColor(float r, float g, float b) noexcept: r(r), g(g), b(b) {}
 
+RGBColor::RGBColor(const RGBValue& value) noexcept: r(value.getR()), g(value.getG()), b(value.getB()) {}
+
+RGBColor::operator RGBValue() const noexcept {
+    return RGBValue(r, g, b);
+}
+
 float RGBColor::getR() const noexcept {
     return r;
 }
@@ -92,7 +104,8 @@ CMYKColor RGBColor::toCMYK() const noexcept {
     const float _maxGB = __haruppMax(g, b);
     const float K = 1.f - __haruppMax(r, _maxGB);
     const float invK = 1.f - K;
-    return CMYKColor((1-r-K)/invK, (1-b-K)/invK, (1-b-K)/invK, K);
+    if (invK <= 0.f) return CMYKColor::BLACK;
+    return CMYKColor((1-r-K)/invK, (1-g-K)/invK, (1-b-K)/invK, K);
 }
 
 bool RGBColor::operator==(const Color& other) const noexcept {
@@ -112,4 +125,4 @@ const RGBColor RGBColor::BLUE(0, 0, 1);
 const RGBColor RGBColor::CYAN(0, 1, 1);
 const RGBColor RGBColor::MAGENTA(1, 0, 1);
 const RGBColor RGBColor::YELLOW(1, 1, 0);
-const RGBColor RGBColor::GRAY(128/255, 128/255, 128/255);
+const RGBColor RGBColor::GRAY(128.f/255.f, 128.f/255.f, 128.f/255.f);
@@ -0,0 +1,318 @@
+#include "../include/ColorConversion.hpp"
+#include "../include/Exception.hpp"
+#include "algorithm"
+#include "cstring"
+#if defined(__AVX2__)
+#include "immintrin.h"
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include "arm_neon.h"
+#endif
+using namespace pdf;
+using namespace pdf::enums;
+using namespace pdf::excepts;
+
+
+/****************************** HELPERS ******************************/
+// The vector kernels below compute exactly the same values as these scalar ones, which also handle the remaining pixels
+
+// round(x * y / 255) for `x, y <= 255`
+static inline unsigned int __haruppMultiply255(unsigned int x, unsigned int y) noexcept {
+    unsigned int t = x * y + 128U;
+    return (t + (t >> 8)) >> 8;
+}
+
+static inline unsigned char __haruppScale255(unsigned int numerator, unsigned int denominator) noexcept {
+    return (unsigned char) ((float) (numerator * 255U) / (float) denominator + 0.5f);
+}
+
+static inline void __haruppRGBToCMYK(const unsigned char* source, unsigned char* target) noexcept {
+    unsigned int r = source[0], g = source[1], b = source[2];
+    unsigned int maximum = std::max(r, std::max(g, b));
+    unsigned int denominator = std::max(maximum, 1U);
+    target[0] = __haruppScale255(maximum - r, denominator);
+    target[1] = __haruppScale255(maximum - g, denominator);
+    target[2] = __haruppScale255(maximum - b, denominator);
+    target[3] = (unsigned char) (255U - maximum);
+}
+
+static inline void __haruppCMYKToRGB(const unsigned char* source, unsigned char* target) noexcept {
+    unsigned int inverseK = 255U - source[3];
+    target[0] = (unsigned char) __haruppMultiply255(255U - source[0], inverseK);
+    target[1] = (unsigned char) __haruppMultiply255(255U - source[1], inverseK);
+    target[2] = (unsigned char) __haruppMultiply255(255U - source[2], inverseK);
+}
+
+// BT.601 luma with weights summing to 256
+static inline unsigned char __haruppRGBToGray(const unsigned char* source) noexcept {
+    return (unsigned char) ((77U * source[0] + 150U * source[1] + 29U * source[2] + 128U) >> 8);
+}
+
+static std::size_t __haruppChannels(ColorSpace colorSpace) {
+    switch (colorSpace) {
+        case ColorSpace::DEVICE_GRAY: return 1U;
+        case ColorSpace::DEVICE_RGB: return 3U;
+        case ColorSpace::DEVICE_CMYK: return 4U;
+        default: throw InvalidColorSpaceException();
+    }
+}
+
+
+/****************************** VECTOR KERNELS ******************************/
+// Each kernel converts as many pixels as it can and returns their number, leaving the rest to the scalar loops
+#if defined(__AVX2__)
+
+// Eight RGB pixels as `0x00BBGGRR` words, reading 28 bytes
+static inline __m256i __haruppLoadRGB(const unsigned char* source) noexcept {
+    const __m128i spread = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    __m128i low = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) source), spread);
+    __m128i high = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (source + 12)), spread);
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+}
+
+static inline __m256i __haruppScale255(__m256i numerator, __m256 denominator) noexcept {
+    __m256 scaled = _mm256_cvtepi32_ps(_mm256_mullo_epi32(numerator, _mm256_set1_epi32(255)));
+    return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_div_ps(scaled, denominator), _mm256_set1_ps(0.5f)));
+}
+
+static inline __m256i __haruppMultiply255(__m256i x, __m256i y) noexcept {
+    __m256i t = _mm256_add_epi32(_mm256_mullo_epi32(x, y), _mm256_set1_epi32(128));
+    return _mm256_srli_epi32(_mm256_add_epi32(t, _mm256_srli_epi32(t, 8)), 8);
+}
+
+static std::size_t __haruppRGBToCMYKVector(const unsigned char* source, unsigned char* target, std::size_t count) noexcept {
+    const __m256i byte = _mm256_set1_epi32(0xFF);
+    std::size_t i = 0U;
+    for (; i + 10U <= count; i += 8U) {
+        __m256i pixels = __haruppLoadRGB(source + 3U * i);
+        __m256i r = _mm256_and_si256(pixels, byte);
+        __m256i g = _mm256_and_si256(_mm256_srli_epi32(pixels, 8), byte);
+        __m256i b = _mm256_srli_epi32(pixels, 16);
+        __m256i maximum = _mm256_max_epu32(r, _mm256_max_epu32(g, b));
+        __m256 denominator = _mm256_cvtepi32_ps(_mm256_max_epu32(maximum, _mm256_set1_epi32(1)));
+        __m256i c = __haruppScale255(_mm256_sub_epi32(maximum, r), denominator);
+        __m256i m = __haruppScale255(_mm256_sub_epi32(maximum, g), denominator);
+        __m256i y = __haruppScale255(_mm256_sub_epi32(maximum, b), denominator);
+        __m256i k = _mm256_sub_epi32(byte, maximum);
+        __m256i cmyk = _mm256_or_si256(
+            _mm256_or_si256(c, _mm256_slli_epi32(m, 8)),
+            _mm256_or_si256(_mm256_slli_epi32(y, 16), _mm256_slli_epi32(k, 24))
+        );
+        _mm256_storeu_si256((__m256i*) (target + 4U * i), cmyk);
+    }
+    return i;
+}
+
+static std::size_t __haruppCMYKToRGBVector(const unsigned char* source, unsigned char* target, std::size_t count) noexcept {
+    const __m256i byte = _mm256_set1_epi32(0xFF);
+    const __m256i pack = _mm256_setr_epi8(
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1
+    );
+    std::size_t i = 0U;
+    for (; i + 10U <= count; i += 8U) {
+        __m256i pixels = _mm256_loadu_si256((const __m256i*) (source + 4U * i));
+        __m256i inverseK = _mm256_sub_epi32(byte, _mm256_srli_epi32(pixels, 24));
+        __m256i inverse = _mm256_xor_si256(pixels, _mm256_set1_epi32(-1));
+        __m256i r = __haruppMultiply255(_mm256_and_si256(inverse, byte), inverseK);
+        __m256i g = __haruppMultiply255(_mm256_and_si256(_mm256_srli_epi32(inverse, 8), byte), inverseK);
+        __m256i b = __haruppMultiply255(_mm256_and_si256(_mm256_srli_epi32(inverse, 16), byte), inverseK);
+        __m256i rgb = _mm256_shuffle_epi8(_mm256_or_si256(r, _mm256_or_si256(_mm256_slli_epi32(g, 8), _mm256_slli_epi32(b, 16))), pack);
+
+        // The second store overwrites the padding of the first one, its own padding is overwritten afterwards
+        _mm_storeu_si128((__m128i*) (target + 3U * i), _mm256_castsi256_si128(rgb));
+        _mm_storeu_si128((__m128i*) (target + 3U * i + 12U), _mm256_extracti128_si256(rgb, 1));
+    }
+    return i;
+}
+
+static std::size_t __haruppRGBToGrayVector(const unsigned char* source, unsigned char* target, std::size_t count) noexcept {
+    const __m256i byte = _mm256_set1_epi32(0xFF);
+    const __m256i pack = _mm256_setr_epi8(
+        0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+    );
+    std::size_t i = 0U;
+    for (; i + 10U <= count; i += 8U) {
+        __m256i pixels = __haruppLoadRGB(source + 3U * i);
+        __m256i r = _mm256_mullo_epi32(_mm256_and_si256(pixels, byte), _mm256_set1_epi32(77));
+        __m256i g = _mm256_mullo_epi32(_mm256_and_si256(_mm256_srli_epi32(pixels, 8), byte), _mm256_set1_epi32(150));
+        __m256i b = _mm256_mullo_epi32(_mm256_srli_epi32(pixels, 16), _mm256_set1_epi32(29));
+        __m256i sum = _mm256_add_epi32(_mm256_add_epi32(r, g), _mm256_add_epi32(b, _mm256_set1_epi32(128)));
+        __m256i gray = _mm256_shuffle_epi8(_mm256_srli_epi32(sum, 8), pack);
+        int low = _mm_cvtsi128_si32(_mm256_castsi256_si128(gray));
+        int high = _mm_cvtsi128_si32(_mm256_extracti128_si256(gray, 1));
+        std::memcpy(target + i, &low, 4U);
+        std::memcpy(target + i + 4U, &high, 4U);
+    }
+    return i;
+}
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+static inline uint8x8_t __haruppScale255(uint8x8_t numerator, float32x4_t denominatorLow, float32x4_t denominatorHigh) noexcept {
+    uint16x8_t scaled = vmull_u8(numerator, vdup_n_u8(255));
+    float32x4_t low = vcvtq_f32_u32(vmovl_u16(vget_low_u16(scaled)));
+    float32x4_t high = vcvtq_f32_u32(vmovl_u16(vget_high_u16(scaled)));
+    uint32x4_t lowResult = vcvtq_u32_f32(vaddq_f32(vdivq_f32(low, denominatorLow), vdupq_n_f32(0.5f)));
+    uint32x4_t highResult = vcvtq_u32_f32(vaddq_f32(vdivq_f32(high, denominatorHigh), vdupq_n_f32(0.5f)));
+    return vmovn_u16(vcombine_u16(vmovn_u32(lowResult), vmovn_u32(highResult)));
+}
+
+static inline uint8x8_t __haruppMultiply255(uint8x8_t x, uint8x8_t y) noexcept {
+    uint16x8_t t = vaddq_u16(vmull_u8(x, y), vdupq_n_u16(128));
+    return vshrn_n_u16(vaddq_u16(t, vshrq_n_u16(t, 8)), 8);
+}
+
+static std::size_t __haruppRGBToCMYKVector(const unsigned char* source, unsigned char* target, std::size_t count) noexcept {
+    std::size_t i = 0U;
+    for (; i + 8U <= count; i += 8U) {
+        uint8x8x3_t rgb = vld3_u8(source + 3U * i);
+        uint8x8_t maximum = vmax_u8(rgb.val[0], vmax_u8(rgb.val[1], rgb.val[2]));
+        uint16x8_t denominator = vmovl_u8(vmax_u8(maximum, vdup_n_u8(1)));
+        float32x4_t denominatorLow = vcvtq_f32_u32(vmovl_u16(vget_low_u16(denominator)));
+        float32x4_t denominatorHigh = vcvtq_f32_u32(vmovl_u16(vget_high_u16(denominator)));
+        uint8x8x4_t cmyk;
+        for (int c = 0; c < 3; ++c) cmyk.val[c] = __haruppScale255(vsub_u8(maximum, rgb.val[c]), denominatorLow, denominatorHigh);
+        cmyk.val[3] = vmvn_u8(maximum);
+        vst4_u8(target + 4U * i, cmyk);
+    }
+    return i;
+}
+
+static std::size_t __haruppCMYKToRGBVector(const unsigned char* source, unsigned char* target, std::size_t count) noexcept {
+    std::size_t i = 0U;
+    for (; i + 8U <= count; i += 8U) {
+        uint8x8x4_t cmyk = vld4_u8(source + 4U * i);
+        uint8x8_t inverseK = vmvn_u8(cmyk.val[3]);
+        uint8x8x3_t rgb;
+        for (int c = 0; c < 3; ++c) rgb.val[c] = __haruppMultiply255(vmvn_u8(cmyk.val[c]), inverseK);
+        vst3_u8(target + 3U * i, rgb);
+    }
+    return i;
+}
+
+static std::size_t __haruppRGBToGrayVector(const unsigned char* source, unsigned char* target, std::size_t count) noexcept {
+    std::size_t i = 0U;
+    for (; i + 8U <= count; i += 8U) {
+        uint8x8x3_t rgb = vld3_u8(source + 3U * i);
+        uint16x8_t sum = vmlal_u8(vmlal_u8(vmull_u8(rgb.val[0], vdup_n_u8(77)), rgb.val[1], vdup_n_u8(150)), rgb.val[2], vdup_n_u8(29));
+        vst1_u8(target + i, vshrn_n_u16(vaddq_u16(sum, vdupq_n_u16(128)), 8));
+    }
+    return i;
+}
+
+#else
+
+static std::size_t __haruppRGBToCMYKVector(const unsigned char*, unsigned char*, std::size_t) noexcept {
+    return 0U;
+}
+
+static std::size_t __haruppCMYKToRGBVector(const unsigned char*, unsigned char*, std::size_t) noexcept {
+    return 0U;
+}
+
+static std::size_t __haruppRGBToGrayVector(const unsigned char*, unsigned char*, std::size_t) noexcept {
+    return 0U;
+}
+
+#endif
+
+
+/******************** COLORS ********************/
+
+void utils::convertRGBToCMYK(const RGBColor* colors, CMYKColor* results, std::size_t count) noexcept {
+    for (std::size_t i = 0U; i < count; ++i) results[i] = colors[i].toCMYK();
+}
+
+void utils::convertCMYKToRGB(const CMYKColor* colors, RGBColor* results, std::size_t count) noexcept {
+    for (std::size_t i = 0U; i < count; ++i) results[i] = colors[i].toRGB();
+}
+
+void utils::convertRGBToCMYK(const RGBValue* colors, CMYKValue* results, std::size_t count) noexcept {
+    for (std::size_t i = 0U; i < count; ++i) results[i] = colors[i].toCMYK();
+}
+
+void utils::convertCMYKToRGB(const CMYKValue* colors, RGBValue* results, std::size_t count) noexcept {
+    for (std::size_t i = 0U; i < count; ++i) results[i] = colors[i].toRGB();
+}
+
+// Branchless loops over plain arrays, left to the compiler to vectorize
+void utils::convertRGBToCMYK(const float* rgb, float* cmyk, std::size_t count) noexcept {
+    for (std::size_t i = 0U; i < count; ++i) {
+        float r = rgb[3U * i], g = rgb[3U * i + 1U], b = rgb[3U * i + 2U];
+        float maximum = std::max(r, std::max(g, b));
+        float denominator = (maximum > 0.f)? maximum: 1.f;
+        cmyk[4U * i] = (maximum - r) / denominator;
+        cmyk[4U * i + 1U] = (maximum - g) / denominator;
+        cmyk[4U * i + 2U] = (maximum - b) / denominator;
+        cmyk[4U * i + 3U] = 1.f - maximum;
+    }
+}
+
+void utils::convertCMYKToRGB(const float* cmyk, float* rgb, std::size_t count) noexcept {
+    for (std::size_t i = 0U; i < count; ++i) {
+        float inverseK = 1.f - cmyk[4U * i + 3U];
+        rgb[3U * i] = (1.f - cmyk[4U * i]) * inverseK;
+        rgb[3U * i + 1U] = (1.f - cmyk[4U * i + 1U]) * inverseK;
+        rgb[3U * i + 2U] = (1.f - cmyk[4U * i + 2U]) * inverseK;
+    }
+}
+
+void utils::convertRGBToGray(const float* rgb, float* gray, std::size_t count) noexcept {
+    for (std::size_t i = 0U; i < count; ++i) gray[i] = 0.299f * rgb[3U * i] + 0.587f * rgb[3U * i + 1U] + 0.114f * rgb[3U * i + 2U];
+}
+
+
+/******************** PIXELS ********************/
+
+std::vector<unsigned char> utils::convertPixels(
+    const unsigned char* pixels, std::size_t pixelCount,
+    ColorSpace colorSpace, ColorSpace targetColorSpace
+) {
+    std::size_t channels = __haruppChannels(colorSpace);
+    std::size_t targetChannels = __haruppChannels(targetColorSpace);
+    std::vector<unsigned char> target(pixelCount * targetChannels);
+    if (pixelCount == 0U) return target;
+    if (colorSpace == targetColorSpace) {
+        std::memcpy(target.data(), pixels, target.size());
+        return target;
+    }
+
+    unsigned char* output = target.data();
+    std::size_t i = 0U;
+    switch (channels * 8U + targetChannels) {
+        case 3U * 8U + 4U:
+            i = __haruppRGBToCMYKVector(pixels, output, pixelCount);
+            for (; i < pixelCount; ++i) __haruppRGBToCMYK(pixels + 3U * i, output + 4U * i);
+            break;
+        case 4U * 8U + 3U:
+            i = __haruppCMYKToRGBVector(pixels, output, pixelCount);
+            for (; i < pixelCount; ++i) __haruppCMYKToRGB(pixels + 4U * i, output + 3U * i);
+            break;
+        case 3U * 8U + 1U:
+            i = __haruppRGBToGrayVector(pixels, output, pixelCount);
+            for (; i < pixelCount; ++i) output[i] = __haruppRGBToGray(pixels + 3U * i);
+            break;
+        case 4U * 8U + 1U:
+            for (; i < pixelCount; ++i) {
+                unsigned char rgb[3];
+                __haruppCMYKToRGB(pixels + 4U * i, rgb);
+                output[i] = __haruppRGBToGray(rgb);
+            }
+            break;
+        case 1U * 8U + 3U:
+            for (; i < pixelCount; ++i) output[3U * i] = output[3U * i + 1U] = output[3U * i + 2U] = pixels[i];
+            break;
+        default:
+            // Gray to CMYK only uses the black component
+            for (; i < pixelCount; ++i) output[4U * i + 3U] = (unsigned char) (255U - pixels[i]);
+            break;
+    }
+    return target;
+}
+
+std::vector<unsigned char> utils::convertPixels(
+    const std::vector<unsigned char>& pixels, ColorSpace colorSpace, ColorSpace targetColorSpace
+) {
+    return convertPixels(pixels.data(), pixels.size() / __haruppChannels(colorSpace), colorSpace, targetColorSpace);
+}
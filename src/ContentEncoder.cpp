@@ -0,0 +1,80 @@
+#include "ContentEncoder.hpp"
+#include "cstdint"
+#include "cstring"
+
+
+// Longest number written: a sign, the 10 digits of the integer part, a dot and 5 fraction digits
+static constexpr std::size_t __HARUPP_MAX_REAL_LENGTH = 17U;
+
+// Largest float whose integer part fits the 32 bits HPDF_FToA keeps it in
+static constexpr float __HARUPP_MAX_REAL_INTEGER = 2147483520.f;
+
+
+char* __HaruppContentEncoder::__reserve(std::size_t count) {
+    if (buffer.size() < length + count) buffer.resize((length + count > 2U * buffer.size())? length + count: 2U * buffer.size());
+    return buffer.data() + length;
+}
+
+void __HaruppContentEncoder::writeReal(float value) {
+    // Same clamping and rounding as HPDF_FToA, so that operators are written byte for byte as LibHaru writes them
+    if (value != value) value = 0.f;
+    else if (value > HPDF_LIMIT_MAX_REAL) value = HPDF_LIMIT_MAX_REAL;
+    else if (value < HPDF_LIMIT_MIN_REAL) value = HPDF_LIMIT_MIN_REAL;
+    if (value > __HARUPP_MAX_REAL_INTEGER) value = __HARUPP_MAX_REAL_INTEGER;
+    else if (value < -__HARUPP_MAX_REAL_INTEGER) value = -__HARUPP_MAX_REAL_INTEGER;
+
+    char* first = __reserve(__HARUPP_MAX_REAL_LENGTH + 1U);
+    char* last = first;
+    if (value < 0.f) {
+        *last++ = '-';
+        value = -value;
+    }
+    std::int32_t integer = (std::int32_t) (value + 0.000005);
+    std::int32_t fraction = (std::int32_t) ((float) (value - integer + 0.000005) * 100000);
+
+    // Digits are written from the last one, then trailing fraction zeros are dropped with the dot if nothing is left
+    char digits[__HARUPP_MAX_REAL_LENGTH];
+    char* end = digits + sizeof(digits);
+    char* begin = end;
+    for (int i = 0; i < 5; ++i, fraction /= 10) *--begin = (char) ('0' + fraction % 10);
+    *--begin = '.';
+    if (integer == 0) *--begin = '0';
+    for (; integer > 0; integer /= 10) *--begin = (char) ('0' + integer % 10);
+    while (end[-1] == '0') --end;
+    if (end[-1] == '.') --end;
+
+    std::memcpy(last, begin, end - begin);
+    last += end - begin;
+    *last++ = ' ';
+    length += last - first;
+}
+
+void __HaruppContentEncoder::writeOperator(const char* name) {
+    std::size_t size = std::strlen(name);
+    char* first = __reserve(size + 1U);
+    std::memcpy(first, name, size);
+    first[size] = '\012';
+    length += size + 1U;
+}
+
+void __HaruppContentEncoder::clear() noexcept {
+    length = 0U;
+}
+
+bool __HaruppContentEncoder::isFull() const noexcept {
+    return length >= BLOCK_SIZE;
+}
+
+HPDF_STATUS __HaruppContentEncoder::flush(HPDF_Stream stream) {
+    std::size_t size = length;
+    length = 0U;
+    if (size == 0U) return HPDF_OK;
+    return HPDF_Stream_Write(stream, (const HPDF_BYTE*) buffer.data(), (HPDF_UINT) size);
+}
+
+__HaruppContentEncoder& __haruppContentEncoder() {
+    // The buffer is kept between calls so that steady drawing does not allocate
+    static thread_local __HaruppContentEncoder encoder;
+    encoder.clear();
+    return encoder;
+}
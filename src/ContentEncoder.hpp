@@ -0,0 +1,40 @@
+#ifndef __HARUPP_CONTENTENCODER_HPP__
+#define __HARUPP_CONTENTENCODER_HPP__
+#include "hpdf.h"
+#include "cstddef"
+#include "vector"
+
+// Internal header: content stream operator encoding used by Page, not part of the public API.
+
+// Encodes operators and their operands into a growable buffer, then writes them to a LibHaru stream in one block.
+// Numbers are written the way HPDF_FToA writes them: clamped to the range LibHaru accepts, rounded to 5 fraction digits
+// at most, without exponent, and NaN as `0`.
+class __HaruppContentEncoder {
+    std::vector<char> buffer;
+    std::size_t length = 0U;
+
+    char* __reserve(std::size_t count);
+
+public:
+    // Size from which batched writers should flush the encoder before going on
+    static constexpr std::size_t BLOCK_SIZE = 64U * 1024U;
+
+    // Appends a number followed by a space, written like HPDF_FToA does: with 5 fraction digits at most and trailing zeros
+    // dropped. NaN is written as `0`.
+    void writeReal(float value);
+
+    // Appends an operator followed by a line feed
+    void writeOperator(const char* name);
+
+    void clear() noexcept;
+
+    bool isFull() const noexcept;
+
+    // Writes the encoded bytes to `stream` and empties the encoder, even on failure
+    HPDF_STATUS flush(HPDF_Stream stream);
+};
+
+// Gets the encoder of the calling thread, emptied
+__HaruppContentEncoder& __haruppContentEncoder();
+
+#endif // __HARUPP_CONTENTENCODER_HPP__
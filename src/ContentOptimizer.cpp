@@ -0,0 +1,444 @@
+#include "ContentOptimizer.hpp"
+#include "algorithm"
+#include "array"
+#include "climits"
+#include "cstdint"
+#include "deque"
+#include "string"
+#include "string_view"
+#include "unordered_map"
+
+
+/****************************** HELPERS ******************************/
+// Operator with its operands, pointing into the parsed stream or into generated text
+struct __HaruppInstruction {
+    std::string_view name;
+    std::vector<std::string_view> operands;
+};
+
+// How the optimizer handles an operator
+enum class __HaruppOperatorKind {
+    SAVE, RESTORE, BEGIN_TEXT, END_TEXT, TEXT_MOVE, TEXT_MOVE_LEADING, TEXT_MATRIX, TEXT_NEXT_LINE,
+    SHOW, SHOW_SPACED, STATE, FILL_SPACE, STROKE_SPACE, EXTERN_STATE, NEUTRAL, VISIBLE, UNKNOWN
+};
+
+// State parameters tracked by the optimizer, fill and stroke colors being set by several operators
+enum __HaruppStateGroup: std::size_t {
+    __HARUPP_GROUP_LINE_WIDTH, __HARUPP_GROUP_LINE_CAP, __HARUPP_GROUP_LINE_JOIN, __HARUPP_GROUP_MITER_LIMIT,
+    __HARUPP_GROUP_DASH, __HARUPP_GROUP_INTENT, __HARUPP_GROUP_FLATNESS, __HARUPP_GROUP_CHAR_SPACE,
+    __HARUPP_GROUP_WORD_SPACE, __HARUPP_GROUP_SCALING, __HARUPP_GROUP_LEADING, __HARUPP_GROUP_FONT,
+    __HARUPP_GROUP_RENDERING_MODE, __HARUPP_GROUP_RISE, __HARUPP_GROUP_FILL, __HARUPP_GROUP_STROKE, __HARUPP_GROUP_COUNT
+};
+
+struct __HaruppOperator {
+    __HaruppOperatorKind kind = __HaruppOperatorKind::UNKNOWN;
+    std::size_t group = __HARUPP_GROUP_COUNT;
+};
+
+// Instruction setting each state parameter, if known
+static constexpr std::size_t __HARUPP_UNKNOWN_STATE = SIZE_MAX;
+typedef std::array<std::size_t, __HARUPP_GROUP_COUNT> __HaruppOptimizerState;
+
+static __HaruppOperator __haruppFindOperator(std::string_view name) {
+    typedef __HaruppOperatorKind Kind;
+    static const std::unordered_map<std::string_view, __HaruppOperator> operators = {
+        {"q", {Kind::SAVE}}, {"Q", {Kind::RESTORE}}, {"BT", {Kind::BEGIN_TEXT}}, {"ET", {Kind::END_TEXT}},
+        {"Td", {Kind::TEXT_MOVE}}, {"TD", {Kind::TEXT_MOVE_LEADING}}, {"Tm", {Kind::TEXT_MATRIX}}, {"T*", {Kind::TEXT_NEXT_LINE}},
+        {"Tj", {Kind::SHOW}}, {"TJ", {Kind::SHOW}}, {"'", {Kind::VISIBLE}}, {"\"", {Kind::SHOW_SPACED}},
+        {"w", {Kind::STATE, __HARUPP_GROUP_LINE_WIDTH}}, {"J", {Kind::STATE, __HARUPP_GROUP_LINE_CAP}},
+        {"j", {Kind::STATE, __HARUPP_GROUP_LINE_JOIN}}, {"M", {Kind::STATE, __HARUPP_GROUP_MITER_LIMIT}},
+        {"d", {Kind::STATE, __HARUPP_GROUP_DASH}}, {"ri", {Kind::STATE, __HARUPP_GROUP_INTENT}},
+        {"i", {Kind::STATE, __HARUPP_GROUP_FLATNESS}}, {"Tc", {Kind::STATE, __HARUPP_GROUP_CHAR_SPACE}},
+        {"Tw", {Kind::STATE, __HARUPP_GROUP_WORD_SPACE}}, {"Tz", {Kind::STATE, __HARUPP_GROUP_SCALING}},
+        {"TL", {Kind::STATE, __HARUPP_GROUP_LEADING}}, {"Tf", {Kind::STATE, __HARUPP_GROUP_FONT}},
+        {"Tr", {Kind::STATE, __HARUPP_GROUP_RENDERING_MODE}}, {"Ts", {Kind::STATE, __HARUPP_GROUP_RISE}},
+        {"g", {Kind::STATE, __HARUPP_GROUP_FILL}}, {"rg", {Kind::STATE, __HARUPP_GROUP_FILL}},
+        {"k", {Kind::STATE, __HARUPP_GROUP_FILL}}, {"sc", {Kind::STATE, __HARUPP_GROUP_FILL}},
+        {"scn", {Kind::STATE, __HARUPP_GROUP_FILL}}, {"G", {Kind::STATE, __HARUPP_GROUP_STROKE}},
+        {"RG", {Kind::STATE, __HARUPP_GROUP_STROKE}}, {"K", {Kind::STATE, __HARUPP_GROUP_STROKE}},
+        {"SC", {Kind::STATE, __HARUPP_GROUP_STROKE}}, {"SCN", {Kind::STATE, __HARUPP_GROUP_STROKE}},
+        {"cs", {Kind::FILL_SPACE}}, {"CS", {Kind::STROKE_SPACE}}, {"gs", {Kind::EXTERN_STATE}},
+        {"cm", {Kind::NEUTRAL}}, {"m", {Kind::NEUTRAL}}, {"l", {Kind::NEUTRAL}}, {"c", {Kind::NEUTRAL}},
+        {"v", {Kind::NEUTRAL}}, {"y", {Kind::NEUTRAL}}, {"h", {Kind::NEUTRAL}}, {"re", {Kind::NEUTRAL}},
+        {"n", {Kind::NEUTRAL}}, {"W", {Kind::NEUTRAL}}, {"W*", {Kind::NEUTRAL}},
+        {"S", {Kind::VISIBLE}}, {"s", {Kind::VISIBLE}}, {"f", {Kind::VISIBLE}}, {"F", {Kind::VISIBLE}},
+        {"f*", {Kind::VISIBLE}}, {"B", {Kind::VISIBLE}}, {"B*", {Kind::VISIBLE}}, {"b", {Kind::VISIBLE}},
+        {"b*", {Kind::VISIBLE}}, {"sh", {Kind::VISIBLE}}, {"Do", {Kind::VISIBLE}}
+    };
+    std::unordered_map<std::string_view, __HaruppOperator>::const_iterator found = operators.find(name);
+    return (found == operators.end())? __HaruppOperator(): found->second;
+}
+
+static bool __haruppIsWhiteSpace(char c) noexcept {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f' || c == '\0';
+}
+
+static bool __haruppIsDelimiter(char c) noexcept {
+    return c == '(' || c == ')' || c == '<' || c == '>' || c == '[' || c == ']' || c == '{' || c == '}' || c == '/' || c == '%';
+}
+
+// Skips white spaces and comments
+static void __haruppSkipSpaces(const char* data, std::size_t size, std::size_t& pos) noexcept {
+    while (pos < size) {
+        if (__haruppIsWhiteSpace(data[pos])) ++pos;
+        else if (data[pos] == '%') {
+            while (pos < size && data[pos] != '\n' && data[pos] != '\r') ++pos;
+        }
+        else break;
+    }
+}
+
+// Moves `pos` past the object starting there, returns `false` if it is malformed
+static bool __haruppSkipObject(const char* data, std::size_t size, std::size_t& pos, unsigned int depth = 0U) noexcept {
+    if (depth > 64U) return false;
+    char first = data[pos];
+    if (first == '(') {
+        unsigned int nesting = 0U;
+        for (; pos < size; ++pos) {
+            if (data[pos] == '\\') ++pos;
+            else if (data[pos] == '(') ++nesting;
+            else if (data[pos] == ')' && --nesting == 0U) {
+                ++pos;
+                return true;
+            }
+        }
+        return false;
+    }
+    if (first == '<' && pos + 1U < size && data[pos + 1U] == '<') {
+        for (pos += 2U;;) {
+            __haruppSkipSpaces(data, size, pos);
+            if (pos >= size) return false;
+            if (data[pos] == '>') {
+                if (pos + 1U >= size || data[pos + 1U] != '>') return false;
+                pos += 2U;
+                return true;
+            }
+            if (!__haruppSkipObject(data, size, pos, depth + 1U)) return false;
+        }
+    }
+    if (first == '<') {
+        while (pos < size && data[pos] != '>') ++pos;
+        if (pos >= size) return false;
+        ++pos;
+        return true;
+    }
+    if (first == '[') {
+        for (++pos;;) {
+            __haruppSkipSpaces(data, size, pos);
+            if (pos >= size) return false;
+            if (data[pos] == ']') {
+                ++pos;
+                return true;
+            }
+            if (!__haruppSkipObject(data, size, pos, depth + 1U)) return false;
+        }
+    }
+    if (first == ')' || first == '>' || first == ']' || first == '{' || first == '}') return false;
+
+    // Names and regular tokens
+    if (first == '/') ++pos;
+    while (pos < size && !__haruppIsWhiteSpace(data[pos]) && !__haruppIsDelimiter(data[pos])) ++pos;
+    return true;
+}
+
+static bool __haruppIsOperand(std::string_view token) noexcept {
+    char first = token[0];
+    return (first >= '0' && first <= '9') || first == '+' || first == '-' || first == '.'
+        || token == "true" || token == "false" || token == "null";
+}
+
+// Splits a content stream into instructions, returns `false` if it cannot be rewritten
+static bool __haruppParseContent(const char* data, std::size_t size, std::vector<__HaruppInstruction>& instructions) {
+    __HaruppInstruction current;
+    std::size_t pos = 0U;
+    for (__haruppSkipSpaces(data, size, pos); pos < size; __haruppSkipSpaces(data, size, pos)) {
+        std::size_t start = pos;
+        if (!__haruppSkipObject(data, size, pos)) return false;
+        std::string_view token(data + start, pos - start);
+        if (__haruppIsDelimiter(data[start]) || __haruppIsOperand(token)) {
+            current.operands.push_back(token);
+            continue;
+        }
+
+        // Inline image data is binary, it cannot be told from operators safely
+        if (token == "BI" || token == "ID") return false;
+        current.name = token;
+        instructions.push_back(std::move(current));
+        current = __HaruppInstruction();
+    }
+    return current.operands.empty();
+}
+
+// PDF numbers have no exponent, they are kept as an integer and a count of fraction digits to be compared and added exactly
+struct __HaruppDecimal {
+    long long mantissa = 0;
+    int scale = 0;
+};
+
+// Returns `false` if the operand is not a number, or has too many digits to be held exactly
+static bool __haruppParseNumber(std::string_view text, __HaruppDecimal& value) noexcept {
+    value = __HaruppDecimal();
+    bool negative = !text.empty() && text[0] == '-';
+    if (!text.empty() && (text[0] == '+' || text[0] == '-')) text.remove_prefix(1U);
+    bool dot = false;
+    bool digits = false;
+    for (char c: text) {
+        if (c == '.' && !dot) {
+            dot = true;
+            continue;
+        }
+        if (c < '0' || c > '9' || value.mantissa > (LLONG_MAX - 9) / 10) return false;
+        value.mantissa = 10 * value.mantissa + (c - '0');
+        if (dot) ++value.scale;
+        digits = true;
+    }
+    if (negative) value.mantissa = -value.mantissa;
+    return digits;
+}
+
+// Gives both numbers the same count of fraction digits, returns `false` on overflow
+static bool __haruppAlignDecimals(__HaruppDecimal& a, __HaruppDecimal& b) noexcept {
+    for (__HaruppDecimal* value: {&a, &b}) {
+        const __HaruppDecimal& other = (value == &a)? b: a;
+        for (; value->scale < other.scale; ++value->scale) {
+            if (value->mantissa > LLONG_MAX / 10 || value->mantissa < LLONG_MIN / 10) return false;
+            value->mantissa *= 10;
+        }
+    }
+    return true;
+}
+
+static bool __haruppSameOperand(std::string_view first, std::string_view second) noexcept {
+    if (first == second) return true;
+    __HaruppDecimal a;
+    __HaruppDecimal b;
+    return __haruppParseNumber(first, a) && __haruppParseNumber(second, b) && __haruppAlignDecimals(a, b) && a.mantissa == b.mantissa;
+}
+
+static bool __haruppSameInstruction(const __HaruppInstruction& first, const __HaruppInstruction& second) noexcept {
+    if (first.name != second.name || first.operands.size() != second.operands.size()) return false;
+    for (std::size_t i = 0U; i < first.operands.size(); ++i) {
+        if (!__haruppSameOperand(first.operands[i], second.operands[i])) return false;
+    }
+    return true;
+}
+
+// Checks whether a string or array operand holds nothing
+static bool __haruppIsEmptyOperand(std::string_view operand) noexcept {
+    if (operand.size() < 2U || (operand[0] != '(' && operand[0] != '<' && operand[0] != '[')) return false;
+    if (operand[0] == '(') return operand.size() == 2U;
+    for (std::size_t i = 1U; i + 1U < operand.size(); ++i) {
+        if (!__haruppIsWhiteSpace(operand[i])) return false;
+    }
+    return true;
+}
+
+// Adds two numbers, written with as many fraction digits as the most precise one at most. Returns an empty string if an
+// operand is not a number or if the sum cannot be held exactly.
+static std::string __haruppAddNumbers(std::string_view first, std::string_view second) {
+    __HaruppDecimal a;
+    __HaruppDecimal b;
+    if (!__haruppParseNumber(first, a) || !__haruppParseNumber(second, b) || !__haruppAlignDecimals(a, b)) return std::string();
+    if ((b.mantissa > 0 && a.mantissa > LLONG_MAX - b.mantissa) || (b.mantissa < 0 && a.mantissa < LLONG_MIN - b.mantissa))
+        return std::string();
+
+    // Digits are written from the last one, trailing fraction zeros are dropped
+    long long sum = a.mantissa + b.mantissa;
+    unsigned long long magnitude = (sum < 0)? 0ULL - (unsigned long long) sum: (unsigned long long) sum;
+    char buffer[48];
+    char* begin = buffer + sizeof(buffer);
+    int scale = a.scale;
+    for (; scale > 0 && magnitude % 10U == 0U; --scale) magnitude /= 10U;
+    do {
+        *--begin = (char) ('0' + magnitude % 10U);
+        magnitude /= 10U;
+        if (--scale == 0) *--begin = '.';
+    } while (magnitude > 0U || scale >= 0);
+    if (sum < 0) *--begin = '-';
+    return std::string(begin, buffer + sizeof(buffer));
+}
+
+
+/****************************** OPTIMIZER ******************************/
+
+bool __haruppOptimizeContent(const unsigned char* content, std::size_t size, std::vector<unsigned char>& optimized) {
+    typedef __HaruppOperatorKind Kind;
+    std::vector<__HaruppInstruction> instructions;
+    if (!__haruppParseContent((const char*) content, size, instructions)) return false;
+    std::size_t parsedCount = instructions.size();
+    // Merged text moves are appended, and must not move the parsed instructions
+    instructions.reserve(2U * parsedCount);
+    std::deque<std::string> generated;
+
+    // Save operators still open, with the kept instruction count when they were met
+    struct __HaruppSave {
+        std::size_t position;
+        bool visible;
+        __HaruppOptimizerState state;
+    };
+    std::vector<__HaruppSave> saves;
+    __HaruppOptimizerState state;
+    state.fill(__HARUPP_UNKNOWN_STATE);
+    std::vector<std::size_t> kept;
+    kept.reserve(parsedCount);
+
+    bool inText = false;
+    bool textShows = false;
+    std::size_t textPosition = 0U;
+    for (std::size_t i = 0U; i < parsedCount; ++i) {
+        __HaruppOperator op = __haruppFindOperator(instructions[i].name);
+        // Save and restore are not allowed in text objects, and text objects cannot be nested
+        if ((inText && (op.kind == Kind::SAVE || op.kind == Kind::RESTORE || op.kind == Kind::BEGIN_TEXT))
+            || (!inText && op.kind == Kind::END_TEXT)) op.kind = Kind::UNKNOWN;
+
+        switch (op.kind) {
+            case Kind::SAVE:
+                saves.push_back({kept.size(), false, state});
+                kept.push_back(i);
+                break;
+
+            case Kind::RESTORE:
+                if (saves.empty()) {
+                    // Restores a state saved before the stream
+                    kept.push_back(i);
+                    state.fill(__HARUPP_UNKNOWN_STATE);
+                    break;
+                }
+                state = saves.back().state;
+                if (!saves.back().visible) kept.resize(saves.back().position);
+                else {
+                    kept.push_back(i);
+                    if (saves.size() > 1U) saves[saves.size() - 2U].visible = true;
+                }
+                saves.pop_back();
+                break;
+
+            case Kind::BEGIN_TEXT:
+                inText = true;
+                textShows = false;
+                textPosition = kept.size();
+                kept.push_back(i);
+                break;
+
+            case Kind::END_TEXT:
+                inText = false;
+                if (textShows) {
+                    kept.push_back(i);
+                    break;
+                }
+                // Nothing was shown, only the state operators of the text object matter
+                kept.erase(std::remove_if(kept.begin() + textPosition, kept.end(), [&instructions](std::size_t index) {
+                    Kind kind = __haruppFindOperator(instructions[index].name).kind;
+                    return kind == Kind::BEGIN_TEXT || kind == Kind::TEXT_MOVE || kind == Kind::TEXT_MATRIX || kind == Kind::TEXT_NEXT_LINE;
+                }), kept.end());
+                break;
+
+            case Kind::TEXT_MOVE: {
+                const __HaruppInstruction& move = instructions[i];
+                if (inText && kept.size() > textPosition + 1U && instructions[kept.back()].name == "Td"
+                    && move.operands.size() == 2U && instructions[kept.back()].operands.size() == 2U) {
+                    const __HaruppInstruction& previous = instructions[kept.back()];
+                    std::string x = __haruppAddNumbers(previous.operands[0], move.operands[0]);
+                    std::string y = __haruppAddNumbers(previous.operands[1], move.operands[1]);
+                    if (!x.empty() && !y.empty()) {
+                        generated.push_back(std::move(x));
+                        generated.push_back(std::move(y));
+                        instructions.push_back({move.name, {generated[generated.size() - 2U], generated.back()}});
+                        kept.back() = instructions.size() - 1U;
+                        break;
+                    }
+                }
+                kept.push_back(i);
+                break;
+            }
+
+            case Kind::TEXT_MATRIX:
+                // The text matrix replaces the effect of the previous moves
+                if (inText && kept.size() > textPosition + 1U
+                    && (instructions[kept.back()].name == "Td" || instructions[kept.back()].name == "Tm")) kept.back() = i;
+                else kept.push_back(i);
+                break;
+
+            case Kind::TEXT_MOVE_LEADING:
+                kept.push_back(i);
+                state[__HARUPP_GROUP_LEADING] = __HARUPP_UNKNOWN_STATE;
+                if (inText) textShows = true;
+                break;
+
+            case Kind::SHOW:
+                if (instructions[i].operands.size() == 1U && __haruppIsEmptyOperand(instructions[i].operands[0])) break;
+                kept.push_back(i);
+                textShows = true;
+                if (!saves.empty()) saves.back().visible = true;
+                break;
+
+            case Kind::SHOW_SPACED:
+                kept.push_back(i);
+                state[__HARUPP_GROUP_WORD_SPACE] = __HARUPP_UNKNOWN_STATE;
+                state[__HARUPP_GROUP_CHAR_SPACE] = __HARUPP_UNKNOWN_STATE;
+                textShows = true;
+                if (!saves.empty()) saves.back().visible = true;
+                break;
+
+            case Kind::STATE:
+                if (state[op.group] != __HARUPP_UNKNOWN_STATE && __haruppSameInstruction(instructions[state[op.group]], instructions[i])) break;
+                kept.push_back(i);
+                state[op.group] = i;
+                break;
+
+            case Kind::FILL_SPACE:
+                kept.push_back(i);
+                state[__HARUPP_GROUP_FILL] = __HARUPP_UNKNOWN_STATE;
+                break;
+
+            case Kind::STROKE_SPACE:
+                kept.push_back(i);
+                state[__HARUPP_GROUP_STROKE] = __HARUPP_UNKNOWN_STATE;
+                break;
+
+            case Kind::EXTERN_STATE:
+                // Extended graphics states may set any parameter but colors
+                kept.push_back(i);
+                for (std::size_t group = 0U; group < __HARUPP_GROUP_FILL; ++group) state[group] = __HARUPP_UNKNOWN_STATE;
+                break;
+
+            case Kind::NEUTRAL:
+                kept.push_back(i);
+                break;
+
+            case Kind::VISIBLE:
+                kept.push_back(i);
+                if (inText) textShows = true;
+                if (!saves.empty()) saves.back().visible = true;
+                break;
+
+            default:
+                kept.push_back(i);
+                state.fill(__HARUPP_UNKNOWN_STATE);
+                if (inText) textShows = true;
+                if (!saves.empty()) saves.back().visible = true;
+                break;
+        }
+    }
+
+    std::size_t length = 0U;
+    for (std::size_t index: kept) {
+        const __HaruppInstruction& instruction = instructions[index];
+        for (std::string_view operand: instruction.operands) length += operand.size() + 1U;
+        length += instruction.name.size() + 1U;
+    }
+    if (length >= size) return false;
+
+    optimized.clear();
+    optimized.reserve(length);
+    for (std::size_t index: kept) {
+        const __HaruppInstruction& instruction = instructions[index];
+        for (std::string_view operand: instruction.operands) {
+            optimized.insert(optimized.end(), operand.begin(), operand.end());
+            optimized.push_back(' ');
+        }
+        optimized.insert(optimized.end(), instruction.name.begin(), instruction.name.end());
+        optimized.push_back('\012');
+    }
+    return true;
+}
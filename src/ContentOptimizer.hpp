@@ -0,0 +1,15 @@
+#ifndef __HARUPP_CONTENTOPTIMIZER_HPP__
+#define __HARUPP_CONTENTOPTIMIZER_HPP__
+#include "cstddef"
+#include "vector"
+
+// Internal header: content stream optimization used when saving documents, not part of the public API.
+
+// Rewrites a content stream into an equivalent smaller one. Save/restore pairs enclosing nothing visible are removed,
+// consecutive text moves are merged, text objects showing nothing are unwrapped, empty text showing operators are
+// dropped and state operators setting the value already in effect are skipped. Nothing is assumed about the state the
+// stream starts in. Returns `false`, leaving `optimized` untouched, if the stream cannot be parsed (e.g. it holds an
+// inline image) or would not get smaller.
+bool __haruppOptimizeContent(const unsigned char* content, std::size_t size, std::vector<unsigned char>& optimized);
+
+#endif // __HARUPP_CONTENTOPTIMIZER_HPP__
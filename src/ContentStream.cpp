@@ -1,12 +1,24 @@
 #include "../include/ContentStream.hpp"
+#include "../include/Exception.hpp"
 #include "hpdf.h"
 using namespace pdf;
 
 
-ContentStream::ContentStream(_HPDF_Dict_Rec* content) noexcept: __innerContent(content) {}
+ContentStream::ContentStream(_HPDF_Dict_Rec* content, const std::atomic<unsigned int>* generation) noexcept:
+    __innerContent(content), __generation(generation),
+    __expectedGeneration((generation == nullptr)? 0U: generation->load(std::memory_order_acquire)) {}
 
 ContentStream::~ContentStream() noexcept {}
 
+_HPDF_Dict_Rec* ContentStream::__content() const {
+#ifndef __HARUPP_DISABLE_HANDLE_CHECKS
+    // The owning document bumps its generation when it gets closed or revoked
+    if (__generation != nullptr && __generation->load(std::memory_order_acquire) != __expectedGeneration)
+        throw excepts::ExpiredHandleException();
+#endif
+    return __innerContent;
+}
+
 bool ContentStream::isEmpty() const noexcept {
     return __innerContent == nullptr;
 }
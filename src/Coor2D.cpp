@@ -1,4 +1,5 @@
 #include "../include/Coor2D.hpp"
+#include "../include/TransposeMatrix.hpp"
 using namespace pdf;
 
 
@@ -17,3 +18,7 @@ float Coor2D::getX() const noexcept {
 float Coor2D::getY() const noexcept {
     return y;
 }
+
+Coor2D Coor2D::transform(const TransposeMatrix& matrix) const noexcept {
+    return matrix.transform(*this);
+}
@@ -1,4 +1,5 @@
 #include "../include/Destination.hpp"
+#include "ErrorHandler.hpp"
 #include "hpdf.h"
 using namespace pdf;
 
@@ -10,33 +11,33 @@ bool Destination::isEmpty() const noexcept {
 }
 
 void Destination::setXYZ(float left, float top, float zoom) {
-    HPDF_Destination_SetXYZ(__innerContent, left, top, zoom);
+    __haruppCheck(HPDF_Destination_SetXYZ(__innerContent, left, top, zoom));
 }
 
 void Destination::setFit() {
-    HPDF_Destination_SetFit(__innerContent);
+    __haruppCheck(HPDF_Destination_SetFit(__innerContent));
 }
 
 void Destination::setFitH(float top) {
-    HPDF_Destination_SetFitH(__innerContent, top);
+    __haruppCheck(HPDF_Destination_SetFitH(__innerContent, top));
 }
 
 void Destination::setFitV(float left) {
-    HPDF_Destination_SetFitV(__innerContent, left);
+    __haruppCheck(HPDF_Destination_SetFitV(__innerContent, left));
 }
 
 void Destination::setFitR(float left, float bottom, float right, float top) {
-    HPDF_Destination_SetFitR(__innerContent, left, bottom, right, top);
+    __haruppCheck(HPDF_Destination_SetFitR(__innerContent, left, bottom, right, top));
 }
 
 void Destination::setFitB() {
-    HPDF_Destination_SetFitB(__innerContent);
+    __haruppCheck(HPDF_Destination_SetFitB(__innerContent));
 }
 
 void Destination::setFitBH(float top) {
-    HPDF_Destination_SetFitBH(__innerContent, top);
+    __haruppCheck(HPDF_Destination_SetFitBH(__innerContent, top));
 }
 
 void Destination::setFitBV(float left) {
-    HPDF_Destination_SetFitBV(__innerContent, left);
+    __haruppCheck(HPDF_Destination_SetFitBV(__innerContent, left));
 }
@@ -1,6 +1,32 @@
 #include "../include/Document.hpp"
 #include "../include/Exception.hpp"
+#include "../include/FontCache.hpp"
+#include "../include/ThreadPool.hpp"
+#include "ContentOptimizer.hpp"
+#include "ErrorHandler.hpp"
+#include "FontSubset.hpp"
+#include "GraphicsState.hpp"
+#include "ImageDecoder.hpp"
+#include "ImageResampler.hpp"
+#include "MappedFile.hpp"
+#include "MemoryContext.hpp"
+#include "algorithm"
+#include "array"
+#include "atomic"
+#include "cstdint"
+#include "cstdio"
+#include "cstdlib"
+#include "climits"
+#include "cstring"
+#include "errno.h"
+#include "exception"
+#include "filesystem"
+#include "fstream"
 #include "hpdf.h"
+#include "mutex"
+#include "string"
+#include "utility"
+#include "zlib.h"
 using namespace pdf;
 using namespace pdf::excepts;
 using namespace pdf::enums;
@@ -17,9 +43,147 @@ using namespace pdf::enums;
 #define __HARUPP_ENCODING_INDEX_START       1
 #define __HARUPP_ENCODING_IMPORTS_LENGTH    5
 
+#ifndef __HARUPP_PAGE_TREE_FANOUT
+#define __HARUPP_PAGE_TREE_FANOUT           32
+#endif
+
+#ifndef __HARUPP_ALLOCATOR_SLOTS
+#define __HARUPP_ALLOCATOR_SLOTS            1024
+#endif
+
+#ifndef __HARUPP_SINK_BUFFER_SIZE
+#define __HARUPP_SINK_BUFFER_SIZE           65536
+#endif
+
+
+/****************************** ALLOCATION HOOKS ******************************/
+// Prepended to every accounted block, since LibHaru does not give the size back when freeing
+struct __HaruppBlockHeader {
+    std::size_t size;
+    MemoryCategory category;
+};
+
+static constexpr std::size_t __haruppBlockHeaderSize =
+    (sizeof(__HaruppBlockHeader) + alignof(std::max_align_t) - 1U) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+static void* __haruppContextAlloc(__HaruppMemoryContext* context, std::size_t size) {
+    if (context->quota > 0U && context->currentSize + size > context->quota) {
+        context->quotaExceeded = true;
+        return nullptr;
+    }
+
+    // Never let an exception go through LibHaru, it reports the failure itself
+    void* block = nullptr;
+    try {
+        if (context->allocator != nullptr) block = context->allocator->allocate(__haruppBlockHeaderSize + size);
+        else block = std::malloc(__haruppBlockHeaderSize + size);
+    } catch (...) {
+        return nullptr;
+    }
+    if (block == nullptr) return nullptr;
+
+    __HaruppBlockHeader* header = static_cast<__HaruppBlockHeader*>(block);
+    header->size = size;
+    header->category = context->category;
+    context->currentSize += size;
+    context->categorySizes[static_cast<int>(header->category)] += size;
+    if (context->currentSize > context->peakSize) context->peakSize = context->currentSize;
+    ++context->allocationCount;
+    return static_cast<unsigned char*>(block) + __haruppBlockHeaderSize;
+}
+
+static void __haruppContextFree(__HaruppMemoryContext* context, void* pointer) {
+    if (pointer == nullptr) return;
+    void* block = static_cast<unsigned char*>(pointer) - __haruppBlockHeaderSize;
+    __HaruppBlockHeader* header = static_cast<__HaruppBlockHeader*>(block);
+    context->currentSize -= header->size;
+    context->categorySizes[static_cast<int>(header->category)] -= header->size;
+
+    if (context->allocator != nullptr) context->allocator->deallocate(block);
+    else std::free(block);
+}
+
+// LibHaru's allocation hooks take no user data, so every accounted document is given a slot,
+// each slot having its own pair of hooks.
+static std::atomic<__HaruppMemoryContext*> __haruppMemorySlots[__HARUPP_ALLOCATOR_SLOTS];
+
+template<std::size_t Slot>
+static void* __haruppSlotAlloc(HPDF_UINT size) {
+    return __haruppContextAlloc(__haruppMemorySlots[Slot].load(std::memory_order_acquire), size);
+}
+
+template<std::size_t Slot>
+static void __haruppSlotFree(void* pointer) {
+    __haruppContextFree(__haruppMemorySlots[Slot].load(std::memory_order_acquire), pointer);
+}
+
+struct __HaruppSlotHooks {
+    HPDF_Alloc_Func alloc;
+    HPDF_Free_Func free;
+};
+
+template<std::size_t... Slots>
+static constexpr std::array<__HaruppSlotHooks, sizeof...(Slots)> __haruppMakeSlotHooks(std::index_sequence<Slots...>) {
+    return {{{__haruppSlotAlloc<Slots>, __haruppSlotFree<Slots>}...}};
+}
+
+static constexpr std::array<__HaruppSlotHooks, __HARUPP_ALLOCATOR_SLOTS> __haruppSlotHooks =
+    __haruppMakeSlotHooks(std::make_index_sequence<__HARUPP_ALLOCATOR_SLOTS>());
+
+static int __haruppAcquireSlot(__HaruppMemoryContext* context) {
+    for (int i = 0; i < __HARUPP_ALLOCATOR_SLOTS; ++i) {
+        __HaruppMemoryContext* expected = nullptr;
+        if (__haruppMemorySlots[i].compare_exchange_strong(expected, context, std::memory_order_acq_rel))
+            return i;
+    }
+    return -1;
+}
+
+static void __haruppReleaseSlot(int slot) {
+    __haruppMemorySlots[slot].store(nullptr, std::memory_order_release);
+}
+
+static unsigned long __haruppTakeExceededQuota(unsigned long errorNo, void* userData) noexcept {
+    if (errorNo != 0x1015 || userData == nullptr) return 0U;
+    __HaruppMemoryContext* context = static_cast<__HaruppMemoryContext*>(userData);
+    if (!context->quotaExceeded) return 0U;
+    context->quotaExceeded = false;
+    return context->quota;
+}
+
 
 /****************************** HELPERS ******************************/
-static void __haruppErrorHandler(unsigned long errorNo, unsigned long detailNo, void*) {
+// Reports an error found by the wrapper through LibHaru, so that it is recorded like LibHaru's own errors, then throws
+// it. Anything still pending was left by an earlier call, the new error replaces it.
+static void __haruppRaiseError(HPDF_Doc pdfDoc, HPDF_STATUS errorNo, HPDF_STATUS detailNo) {
+    __haruppClearError();
+    HPDF_RaiseError(&pdfDoc->error, errorNo, detailNo);
+    __haruppCheck(errorNo);
+}
+
+void __haruppErrorHandler(unsigned long errorNo, unsigned long detailNo, void* userData) {
+    unsigned long quota = __haruppTakeExceededQuota(errorNo, userData);
+
+#if __HARUPP_ERROR_POLICY == __HARUPP_ERROR_POLICY_ABORT
+    (void) detailNo;
+    (void) quota;
+    std::abort();
+#elif __HARUPP_ERROR_POLICY == __HARUPP_ERROR_POLICY_THROW
+    // Never throw from here: LibHaru frames are still on the stack
+    if (__haruppPendingError.errorNo == 0U) __haruppPendingError = {errorNo, detailNo, quota};
+#else
+    (void) detailNo;
+    (void) quota;
+#endif
+}
+
+void __haruppRaisePendingError() {
+    unsigned long errorNo = __haruppPendingError.errorNo;
+    unsigned long detailNo = __haruppPendingError.detailNo;
+    unsigned long quota = __haruppPendingError.quota;
+    __haruppClearError();
+
+    if (quota > 0U) throw MemoryQuotaExceededException(quota);
     switch (errorNo) {
         case 0x1004: throw BinaryLengthTooLongException();
         case 0x1007: throw TooManyIndirectObjectsException();
@@ -134,19 +298,662 @@ static const char* multiByteEncodingToString(MultiByteEncoding encoding) {
 static std::vector<unsigned char> __execAndGetVector(unsigned long (&fn)(HPDF_Doc, unsigned char*, unsigned int*), HPDF_Doc pdfDoc, unsigned int size) {
     if (size == 0U || pdfDoc == nullptr) return std::vector<unsigned char>();
 
-    // Allocate data
-    std::vector<unsigned char> data;
-    data.reserve(size);
+    // Never allocate more than what the stream holds
+    unsigned int streamSize = HPDF_GetStreamSize(pdfDoc);
+    if (size > streamSize) size = streamSize;
+    if (size == 0U) return std::vector<unsigned char>();
 
-    // Call the function
+    // Let the function write straight into the vector storage
+    std::vector<unsigned char> data(size);
     unsigned int newSize = size;
-    fn(pdfDoc, data.data(), &newSize);
+    __haruppCheck(fn(pdfDoc, data.data(), &newSize));
 
     // Safety check
-    if (newSize > size) newSize = size;
+    if (newSize < size) data.resize(newSize);
+    return data;
+}
+
+static void __writeStreamChunks(HPDF_Stream stream, OutputSink& sink) {
+    if (stream == nullptr) return;
+    unsigned int count = HPDF_MemStream_GetBufCount(stream);
+    for (unsigned int i = 0U; i < count; ++i) {
+        unsigned int size = 0U;
+        const unsigned char* chunk = HPDF_MemStream_GetBufPtr(stream, i, &size);
+        if (chunk != nullptr && size > 0U) sink.write(chunk, size);
+    }
+}
+
+// LibHaru stream writing to an OutputSink. LibHaru writes token by token, so small writes are gathered first.
+// Exceptions cannot go through LibHaru: the first one is kept and rethrown once LibHaru has returned.
+struct __HaruppSinkStream {
+    HPDF_Stream_Rec stream;
+    OutputSink* sink;
+    std::vector<unsigned char> buffer;
+    std::exception_ptr exception;
+};
+
+static void __haruppFlushSinkStream(__HaruppSinkStream& target) {
+    if (target.buffer.empty()) return;
+    target.sink->write(target.buffer.data(), (unsigned int) target.buffer.size());
+    target.buffer.clear();
+}
+
+static HPDF_STATUS __haruppSinkStreamWrite(HPDF_Stream stream, const HPDF_BYTE* ptr, HPDF_UINT size) {
+    __HaruppSinkStream* target = (__HaruppSinkStream*) stream->attr;
+    if (target->exception != nullptr) return HPDF_SetError(stream->error, HPDF_FILE_IO_ERROR, 0);
+    try {
+        if (target->buffer.size() + size > __HARUPP_SINK_BUFFER_SIZE) __haruppFlushSinkStream(*target);
+        if (size >= __HARUPP_SINK_BUFFER_SIZE) target->sink->write(ptr, size);
+        else target->buffer.insert(target->buffer.end(), ptr, ptr + size);
+    } catch (...) {
+        target->exception = std::current_exception();
+        return HPDF_SetError(stream->error, HPDF_FILE_IO_ERROR, 0);
+    }
+    return HPDF_OK;
+}
+
+// The stream record lives in `target`, it is never handed to HPDF_Stream_Free
+static void __haruppInitSinkStream(HPDF_Doc pdfDoc, __HaruppSinkStream& target, OutputSink& sink) {
+    std::memset(&target.stream, 0, sizeof(HPDF_Stream_Rec));
+    target.stream.sig_bytes = HPDF_STREAM_SIG_BYTES;
+    target.stream.type = HPDF_STREAM_UNKNOWN;
+    target.stream.mmgr = pdfDoc->mmgr;
+    target.stream.error = &pdfDoc->error;
+    target.stream.write_fn = __haruppSinkStreamWrite;
+    target.stream.attr = &target;
+    target.sink = &sink;
+    target.buffer.reserve(__HARUPP_SINK_BUFFER_SIZE);
+}
+
+// Hands the gathered bytes to the sink once `res` is known, then throws the sink exception or the LibHaru error if any.
+// A sink exception is thrown as is, the error LibHaru reported for it being dropped.
+static void __haruppCheckSinkWrite(HPDF_Doc pdfDoc, __HaruppSinkStream& target, HPDF_STATUS res) {
+    if (res == HPDF_OK && target.exception == nullptr) {
+        try {
+            __haruppFlushSinkStream(target);
+        } catch (...) {
+            target.exception = std::current_exception();
+        }
+    }
+    if (target.exception != nullptr) {
+        __haruppClearError();
+        HPDF_ResetError(pdfDoc);
+        std::rethrow_exception(target.exception);
+    }
+    if (res != HPDF_OK) HPDF_CheckError(&pdfDoc->error);
+    __haruppCheck(res);
+}
+
+
+/******************** STREAMING OUTPUT ********************/
+// Object numbers are stored below LibHaru's object type flags
+static constexpr HPDF_UINT32 __HARUPP_OBJECT_ID_MASK = 0x00FFFFFFU;
+
+// Document being streamed, objects written ahead of the end are flagged by object number
+struct __HaruppStreamingOutput {
+    __HaruppSinkStream target;
+    int version = 0;
+    std::vector<bool> written;
+};
+
+// Same layout as the objects LibHaru writes when saving
+static HPDF_STATUS __haruppWriteIndirectObject(HPDF_Stream stream, HPDF_XrefEntry entry, HPDF_UINT id) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%u %u obj\012", id, (unsigned int) entry->gen_no);
+    entry->byte_offset = stream->size;
+    HPDF_STATUS res = HPDF_Stream_WriteStr(stream, buffer);
+    if (res == HPDF_OK) res = HPDF_Obj_WriteValue(entry->obj, stream, nullptr);
+    if (res == HPDF_OK) res = HPDF_Stream_WriteStr(stream, "\012endobj\012");
+    return res;
+}
+
+// Releases the data of a stream already written, a memory stream keeps its record but no buffer
+static void __haruppReleaseStreamData(HPDF_Doc pdfDoc, HPDF_Dict object) {
+    if (object->stream == nullptr) return;
+    if (object->stream->type == HPDF_STREAM_MEMORY) {
+        HPDF_MemStream_FreeData(object->stream);
+        return;
+    }
+    HPDF_Stream empty = HPDF_MemStream_New(pdfDoc->mmgr, HPDF_STREAM_BUF_SIZ);
+    if (empty == nullptr) {
+        // Keeping the data only costs memory
+        HPDF_ResetError(pdfDoc);
+        return;
+    }
+    HPDF_Stream_Free(object->stream);
+    object->stream = empty;
+}
+
+// Writes an indirect object to the streaming output ahead of the end, then releases its stream data
+static HPDF_STATUS __haruppStreamObject(HPDF_Doc pdfDoc, __HaruppStreamingOutput& output, HPDF_Dict object) {
+    if (object == nullptr || !(object->header.obj_id & HPDF_OTYPE_INDIRECT)) return HPDF_OK;
+    HPDF_UINT id = object->header.obj_id & __HARUPP_OBJECT_ID_MASK;
+    if (id >= pdfDoc->xref->entries->count || (id < output.written.size() && output.written[id])) return HPDF_OK;
+
+    HPDF_STATUS res = __haruppWriteIndirectObject(&output.target.stream, HPDF_Xref_GetEntry(pdfDoc->xref, id), id);
+    if (res != HPDF_OK) return res;
+    if (id >= output.written.size()) output.written.resize(id + 1U, false);
+    output.written[id] = true;
+    __haruppReleaseStreamData(pdfDoc, object);
+    return HPDF_OK;
+}
+
+// Image XObjects drawn on a page, as listed by its resources
+static std::vector<HPDF_Dict> __haruppGetPageImages(HPDF_Page page) {
+    std::vector<HPDF_Dict> images;
+    HPDF_Dict xobjects = ((HPDF_PageAttr) page->attr)->xobjects;
+    if (xobjects == nullptr) return images;
+    for (HPDF_UINT i = 0U; i < xobjects->list->count; ++i) {
+        HPDF_DictElement element = (HPDF_DictElement) HPDF_List_ItemAt(xobjects->list, i);
+        void* value = element->value;
+        if ((((HPDF_Obj_Header*) value)->obj_class & HPDF_OCLASS_ANY) == HPDF_OCLASS_PROXY) value = ((HPDF_Proxy) value)->obj;
+        HPDF_Dict xobject = (HPDF_Dict) value;
+        if ((xobject->header.obj_class & HPDF_OCLASS_ANY) != HPDF_OCLASS_DICT || xobject->stream == nullptr) continue;
+        HPDF_Name subtype = (HPDF_Name) HPDF_Dict_GetItem(xobject, "Subtype", HPDF_OCLASS_NAME);
+        if (subtype != nullptr && std::strcmp(subtype->value, "Image") == 0) images.push_back(xobject);
+    }
+    return images;
+}
+
+// Writes the objects not streamed yet, then the xref table and the trailer, the way LibHaru ends a saved document
+static HPDF_STATUS __haruppWriteStreamingEnd(HPDF_Doc pdfDoc, __HaruppStreamingOutput& output) {
+    HPDF_Stream stream = &output.target.stream;
+    HPDF_Xref xref = pdfDoc->xref;
+    HPDF_STATUS res = HPDF_Dict_Add(xref->trailer, "Root", pdfDoc->catalog);
+    if (res == HPDF_OK && pdfDoc->info != nullptr) res = HPDF_Dict_Add(xref->trailer, "Info", pdfDoc->info);
+
+    // The header is already written, so a later version is declared by the catalog instead
+    if (res == HPDF_OK && (int) pdfDoc->pdf_version > output.version) {
+        char version[] = {'1', '.', (char) ('2' + (int) pdfDoc->pdf_version), '\0'};
+        res = HPDF_Dict_AddName(pdfDoc->catalog, "Version", version);
+    }
+    for (HPDF_UINT id = 1U; res == HPDF_OK && id < xref->entries->count; ++id) {
+        if (id < output.written.size() && output.written[id]) continue;
+        res = __haruppWriteIndirectObject(stream, HPDF_Xref_GetEntry(xref, id), id);
+    }
+    if (res != HPDF_OK) return res;
+
+    HPDF_UINT address = stream->size;
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "xref\0120 %u\012", xref->entries->count);
+    res = HPDF_Stream_WriteStr(stream, buffer);
+    for (HPDF_UINT i = 0U; res == HPDF_OK && i < xref->entries->count; ++i) {
+        HPDF_XrefEntry entry = HPDF_Xref_GetEntry(xref, i);
+        std::snprintf(buffer, sizeof(buffer), "%010u %05u %c\015\012", entry->byte_offset, (unsigned int) entry->gen_no, entry->entry_typ);
+        res = HPDF_Stream_WriteStr(stream, buffer);
+    }
+    if (res == HPDF_OK) res = HPDF_Dict_AddNumber(xref->trailer, "Size", (HPDF_INT32) xref->entries->count);
+    if (res == HPDF_OK) res = HPDF_Stream_WriteStr(stream, "trailer\012");
+    if (res == HPDF_OK) res = HPDF_Dict_Write(xref->trailer, stream, nullptr);
+    if (res != HPDF_OK) return res;
+    std::snprintf(buffer, sizeof(buffer), "\012startxref\012%u\012%%%%EOF\012", address);
+    return HPDF_Stream_WriteStr(stream, buffer);
+}
+
+static std::vector<unsigned char> __haruppReadMemStream(HPDF_Stream stream) {
+    std::vector<unsigned char> data;
+    data.reserve(stream->size);
+    unsigned int count = HPDF_MemStream_GetBufCount(stream);
+    for (unsigned int i = 0U; i < count; ++i) {
+        unsigned int size = 0U;
+        const unsigned char* chunk = HPDF_MemStream_GetBufPtr(stream, i, &size);
+        if (chunk != nullptr) data.insert(data.end(), chunk, chunk + size);
+    }
+    if (data.size() > stream->size) data.resize(stream->size);
+    return data;
+}
+
+static HPDF_STATUS __haruppRewriteMemStream(HPDF_Doc pdfDoc, HPDF_Stream stream, const std::vector<unsigned char>& data) {
+    HPDF_MemStream_FreeData(stream);
+    HPDF_STATUS res = HPDF_Stream_Write(stream, data.data(), (HPDF_UINT) data.size());
+    if (res != HPDF_OK) HPDF_CheckError(&pdfDoc->error);
+    return __haruppCheck(res);
+}
+
+/******************** HANDLE GENERATIONS ********************/
+// Generation counters are never freed, so that handles outliving their document can still read them.
+// A counter is only ever incremented, even once reused by another document.
+static std::mutex __haruppGenerationMutex;
+static std::vector<std::atomic<unsigned int>*> __haruppFreeGenerations;
+
+static std::atomic<unsigned int>* __haruppAcquireGeneration() {
+    std::lock_guard<std::mutex> lock(__haruppGenerationMutex);
+    if (__haruppFreeGenerations.empty()) return new std::atomic<unsigned int>(0U);
+    std::atomic<unsigned int>* generation = __haruppFreeGenerations.back();
+    __haruppFreeGenerations.pop_back();
+    return generation;
+}
 
-    // Put everything into a vector and return
-    return std::vector<unsigned char>(data.begin(), data.begin() + newSize);
+static void __haruppReleaseGeneration(std::atomic<unsigned int>* generation) {
+    std::lock_guard<std::mutex> lock(__haruppGenerationMutex);
+    __haruppFreeGenerations.push_back(generation);
+}
+
+static void __haruppExpireHandles(std::atomic<unsigned int>* generation) noexcept {
+    if (generation != nullptr) generation->fetch_add(1U, std::memory_order_acq_rel);
+}
+
+
+static void __closePage(HPDF_Page page) {
+    // Same clean-up as the one done by LibHaru just before writing a page
+    unsigned short mode = HPDF_Page_GetGMode(page);
+    if (mode == HPDF_GMODE_PATH_OBJECT) __haruppCheck(HPDF_Page_EndPath(page));
+    else if (mode == HPDF_GMODE_TEXT_OBJECT) __haruppCheck(HPDF_Page_EndText(page));
+    while (HPDF_Page_GetGStateDepth(page) > 1U) __haruppCheck(HPDF_Page_GRestore(page));
+}
+
+// LibHaru drops the Filter entry of streams written without a filter, so data encoded beforehand declares it from here,
+// once the dictionary entries are written
+static HPDF_STATUS __haruppWriteFlateFilter(HPDF_Dict dict, HPDF_Stream stream) {
+    (void) dict;
+    return HPDF_Stream_WriteStr(stream, "/Filter /FlateDecode\012");
+}
+
+static void __encodePageContents(HPDF_Page page) {
+    HPDF_Dict contents = ((HPDF_PageAttr) page->attr)->contents;
+    if (contents == nullptr || !(contents->filter & HPDF_STREAM_FILTER_FLATE_DECODE)) return;
+
+    HPDF_Stream stream = contents->stream;
+    unsigned int bufferCount = HPDF_MemStream_GetBufCount(stream);
+    if (HPDF_Stream_Size(stream) == 0U) return;
+
+    z_stream zStream = {};
+    int status = deflateInit(&zStream, Z_DEFAULT_COMPRESSION);
+    if (status != Z_OK) throw ZLibException(status);
+
+    // Deflate every buffer of the memory stream without copying them first
+    std::vector<unsigned char> encoded(deflateBound(&zStream, HPDF_Stream_Size(stream)));
+    zStream.next_out = encoded.data();
+    zStream.avail_out = encoded.size();
+    for (unsigned int i = 0U; i < bufferCount; ++i) {
+        unsigned int length = 0U;
+        zStream.next_in = HPDF_MemStream_GetBufPtr(stream, i, &length);
+        zStream.avail_in = length;
+        status = deflate(&zStream, (i + 1U == bufferCount)? Z_FINISH: Z_NO_FLUSH);
+        if (status == Z_STREAM_ERROR) break;
+    }
+    deflateEnd(&zStream);
+    if (status != Z_STREAM_END) throw ZLibException(status);
+
+    // Replace the raw operators with the encoded data
+    HPDF_MemStream_FreeData(stream);
+    HPDF_STATUS res = HPDF_Stream_Write(stream, encoded.data(), zStream.total_out);
+    if (res != HPDF_OK) HPDF_CheckError(page->error);
+    if (__haruppCheck(res) != HPDF_OK) return;
+    contents->filter = HPDF_STREAM_FILTER_NONE;
+    contents->write_fn = __haruppWriteFlateFilter;
+}
+
+static void __optimizePageContents(HPDF_Doc pdfDoc, HPDF_Page page) {
+    HPDF_Dict contents = ((HPDF_PageAttr) page->attr)->contents;
+    if (contents == nullptr || contents->stream == nullptr) return;
+
+    std::vector<unsigned char> data = __haruppReadMemStream(contents->stream);
+    std::vector<unsigned char> optimized;
+    if (__haruppOptimizeContent(data.data(), data.size(), optimized)) __haruppRewriteMemStream(pdfDoc, contents->stream, optimized);
+}
+
+// Makes a LibHaru list grow by at least `count` items at once while alive
+struct __HaruppListGrowth {
+    HPDF_List list;
+    unsigned int itemsPerBlock = 0U;
+
+    __HaruppListGrowth(HPDF_List list, unsigned int count) noexcept: list(list) {
+        if (list == nullptr) return;
+        itemsPerBlock = list->items_per_block;
+        if (count > itemsPerBlock) list->items_per_block = count;
+    }
+
+    ~__HaruppListGrowth() {
+        if (list != nullptr) list->items_per_block = itemsPerBlock;
+    }
+};
+
+static bool __haruppGetBoxValues(HPDF_Page page, const char* key, float (&values)[4]) {
+    HPDF_Array box = (HPDF_Array) HPDF_Dict_GetItem(page, key, HPDF_OCLASS_ARRAY);
+    if (box == nullptr) return false;
+    for (unsigned int i = 0U; i < 4U; ++i) {
+        HPDF_Real value = (HPDF_Real) HPDF_Array_GetItem(box, i, HPDF_OCLASS_REAL);
+        if (value == nullptr) return false;
+        values[i] = value->value;
+    }
+    return true;
+}
+
+static void __haruppSetBoxValues(HPDF_Page page, const char* key, const float (&values)[4]) {
+    // Fresh pages always hold a box of four reals, so no array has to be allocated
+    HPDF_Array box = (HPDF_Array) HPDF_Dict_GetItem(page, key, HPDF_OCLASS_ARRAY);
+    if (box == nullptr) return;
+    for (unsigned int i = 0U; i < 4U; ++i) {
+        HPDF_Real value = (HPDF_Real) HPDF_Array_GetItem(box, i, HPDF_OCLASS_REAL);
+        if (value != nullptr) value->value = values[i];
+    }
+}
+
+// SHA-256 digest of some bytes, as 32 raw bytes. Registries trust a digest match to mean the same bytes, so it must be
+// a cryptographic one: a weaker hash would let crafted data be swapped for an image or font loaded earlier.
+static std::string __haruppDigestBytes(const unsigned char* data, std::size_t size) {
+    static const std::uint32_t constants[64] = {
+        0x428A2F98U, 0x71374491U, 0xB5C0FBCFU, 0xE9B5DBA5U, 0x3956C25BU, 0x59F111F1U, 0x923F82A4U, 0xAB1C5ED5U,
+        0xD807AA98U, 0x12835B01U, 0x243185BEU, 0x550C7DC3U, 0x72BE5D74U, 0x80DEB1FEU, 0x9BDC06A7U, 0xC19BF174U,
+        0xE49B69C1U, 0xEFBE4786U, 0x0FC19DC6U, 0x240CA1CCU, 0x2DE92C6FU, 0x4A7484AAU, 0x5CB0A9DCU, 0x76F988DAU,
+        0x983E5152U, 0xA831C66DU, 0xB00327C8U, 0xBF597FC7U, 0xC6E00BF3U, 0xD5A79147U, 0x06CA6351U, 0x14292967U,
+        0x27B70A85U, 0x2E1B2138U, 0x4D2C6DFCU, 0x53380D13U, 0x650A7354U, 0x766A0ABBU, 0x81C2C92EU, 0x92722C85U,
+        0xA2BFE8A1U, 0xA81A664BU, 0xC24B8B70U, 0xC76C51A3U, 0xD192E819U, 0xD6990624U, 0xF40E3585U, 0x106AA070U,
+        0x19A4C116U, 0x1E376C08U, 0x2748774CU, 0x34B0BCB5U, 0x391C0CB3U, 0x4ED8AA4AU, 0x5B9CCA4FU, 0x682E6FF3U,
+        0x748F82EEU, 0x78A5636FU, 0x84C87814U, 0x8CC70208U, 0x90BEFFFAU, 0xA4506CEBU, 0xBEF9A3F7U, 0xC67178F2U
+    };
+    std::uint32_t state[8] = {0x6A09E667U, 0xBB67AE85U, 0x3C6EF372U, 0xA54FF53AU, 0x510E527FU, 0x9B05688CU, 0x1F83D9ABU, 0x5BE0CD19U};
+    auto rotate = [](std::uint32_t value, unsigned int bits) noexcept { return (value >> bits) | (value << (32U - bits)); };
+    auto compressBlock = [&](const unsigned char* block) noexcept {
+        std::uint32_t words[64];
+        for (unsigned int i = 0U; i < 16U; ++i)
+            words[i] = ((std::uint32_t) block[4U * i] << 24) | ((std::uint32_t) block[4U * i + 1U] << 16) | ((std::uint32_t) block[4U * i + 2U] << 8) | block[4U * i + 3U];
+        for (unsigned int i = 16U; i < 64U; ++i) {
+            std::uint32_t s0 = rotate(words[i - 15U], 7U) ^ rotate(words[i - 15U], 18U) ^ (words[i - 15U] >> 3);
+            std::uint32_t s1 = rotate(words[i - 2U], 17U) ^ rotate(words[i - 2U], 19U) ^ (words[i - 2U] >> 10);
+            words[i] = words[i - 16U] + s0 + words[i - 7U] + s1;
+        }
+        std::uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4], f = state[5], g = state[6], h = state[7];
+        for (unsigned int i = 0U; i < 64U; ++i) {
+            std::uint32_t t1 = h + (rotate(e, 6U) ^ rotate(e, 11U) ^ rotate(e, 25U)) + ((e & f) ^ (~e & g)) + constants[i] + words[i];
+            std::uint32_t t2 = (rotate(a, 2U) ^ rotate(a, 13U) ^ rotate(a, 22U)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    };
+
+    std::size_t i = 0U;
+    for (; i + 64U <= size; i += 64U) compressBlock(data + i);
+    // Last bytes, then a 1 bit, zeros and the size in bits, over one or two blocks
+    unsigned char tail[128] = {};
+    std::size_t rest = size - i;
+    if (rest > 0U) std::memcpy(tail, data + i, rest);
+    tail[rest] = 0x80U;
+    std::size_t tailSize = (rest < 56U)? 64U: 128U;
+    std::uint64_t bits = (std::uint64_t) size * 8U;
+    for (unsigned int j = 0U; j < 8U; ++j) tail[tailSize - 1U - j] = (unsigned char) (bits >> (8U * j));
+    for (std::size_t j = 0U; j < tailSize; j += 64U) compressBlock(tail + j);
+
+    std::string digest(32U, '\0');
+    for (unsigned int j = 0U; j < 32U; ++j) digest[j] = (char) (state[j / 4U] >> (24U - 8U * (j % 4U)));
+    return digest;
+}
+
+static std::string __haruppMemoryImageKey(bool enabled, char loader, const unsigned char* data, std::size_t size, const std::string& parameters = "") {
+    if (!enabled) return std::string();
+    return std::string("M") + loader + __haruppDigestBytes(data, size) + ':' + parameters;
+}
+
+static std::string __haruppFileImageKey(bool enabled, char loader, const std::string& fileName, const std::string& parameters = "") {
+    if (!enabled) return std::string();
+
+    // Unreadable files are not deduplicated, LibHaru reports the error
+    std::error_code error;
+    std::filesystem::file_time_type time = std::filesystem::last_write_time(fileName, error);
+    if (error) return std::string();
+    std::uintmax_t size = std::filesystem::file_size(fileName, error);
+    if (error) return std::string();
+    return std::string("F") + loader + std::to_string(time.time_since_epoch().count()) + ':' + std::to_string(size) + ':' + parameters + ':' + fileName;
+}
+
+// Number of bytes of a raw image, rows being padded to a whole byte
+static std::size_t __haruppRawImageSize(unsigned int width, unsigned int height, ColorSpace colorSpace, unsigned int bitsPerComponent) {
+    if (bitsPerComponent != 1U && bitsPerComponent != 2U && bitsPerComponent != 4U && bitsPerComponent != 8U)
+        throw InvalidBitsPerComponentException();
+    std::size_t components;
+    switch (colorSpace) {
+        case ColorSpace::DEVICE_GRAY: components = 1U; break;
+        case ColorSpace::DEVICE_RGB: components = 3U; break;
+        case ColorSpace::DEVICE_CMYK: components = 4U; break;
+        default: throw InvalidColorSpaceException();
+    }
+    if (width == 0U || height == 0U) throw InvalidImageException();
+    std::size_t size = ((std::size_t) width * components * bitsPerComponent + 7U) / 8U * height;
+    if (size > INT_MAX) throw BinaryLengthTooLongException();
+    return size;
+}
+
+// Key parameters of a downsampled load, empty if images are left untouched
+static std::string __haruppDownsamplingKey(const ImageDownsampling& downsampling) {
+    if (downsampling.isEmpty()) return std::string();
+    return std::string("d") + std::to_string(downsampling.getResolution()) + ':' + std::to_string(downsampling.getWidth()) + 'x'
+        + std::to_string(downsampling.getHeight()) + ':' + std::to_string((int) downsampling.getFilter());
+}
+
+// Checks whether a raw image is resampled by a downsampling, only 8 bits images are
+static bool __haruppReducesImage(unsigned int width, unsigned int height, unsigned int bitsPerComponent, const ImageDownsampling& downsampling) noexcept {
+    if (bitsPerComponent != 8U) return false;
+    unsigned int targetWidth = width, targetHeight = height;
+    downsampling.computeTargetSize(targetWidth, targetHeight);
+    return targetWidth < width || targetHeight < height;
+}
+
+// Read-only LibHaru stream over bytes owned elsewhere, kept alive until LibHaru frees the stream
+struct __HaruppSharedStream {
+    std::shared_ptr<const void> owner;
+    const unsigned char* data;
+    unsigned int size;
+    unsigned int position;
+};
+
+static HPDF_STATUS __haruppSharedStreamRead(HPDF_Stream stream, HPDF_BYTE* ptr, HPDF_UINT* size) {
+    __HaruppSharedStream* shared = (__HaruppSharedStream*) stream->attr;
+    unsigned int available = shared->size - shared->position;
+    bool end = *size > available;
+    if (end) *size = available;
+    std::memcpy(ptr, shared->data + shared->position, *size);
+    shared->position += *size;
+    return end? HPDF_STREAM_EOF: HPDF_OK;
+}
+
+static HPDF_STATUS __haruppSharedStreamSeek(HPDF_Stream stream, HPDF_INT pos, HPDF_WhenceMode mode) {
+    __HaruppSharedStream* shared = (__HaruppSharedStream*) stream->attr;
+    long long position = pos;
+    if (mode == HPDF_SEEK_CUR) position += shared->position;
+    else if (mode == HPDF_SEEK_END) position += shared->size;
+    if (position < 0 || position > (long long) shared->size) return HPDF_SetError(stream->error, HPDF_STREAM_EOF, 0);
+    shared->position = (unsigned int) position;
+    return HPDF_OK;
+}
+
+static HPDF_INT32 __haruppSharedStreamTell(HPDF_Stream stream) {
+    return (HPDF_INT32) ((__HaruppSharedStream*) stream->attr)->position;
+}
+
+static HPDF_UINT32 __haruppSharedStreamSize(HPDF_Stream stream) {
+    return ((__HaruppSharedStream*) stream->attr)->size;
+}
+
+static void __haruppSharedStreamFree(HPDF_Stream stream) {
+    delete (__HaruppSharedStream*) stream->attr;
+    stream->attr = nullptr;
+}
+
+static HPDF_Stream __haruppNewSharedStream(HPDF_Doc pdfDoc, std::shared_ptr<const void> owner, const unsigned char* data, std::size_t size) {
+    if (size > INT_MAX) return nullptr;
+    HPDF_Stream stream = (HPDF_Stream) HPDF_GetMem(pdfDoc->mmgr, sizeof(HPDF_Stream_Rec));
+    if (stream == nullptr) return nullptr;
+    std::memset(stream, 0, sizeof(HPDF_Stream_Rec));
+    stream->sig_bytes = HPDF_STREAM_SIG_BYTES;
+    stream->type = HPDF_STREAM_UNKNOWN;
+    stream->mmgr = pdfDoc->mmgr;
+    stream->error = &pdfDoc->error;
+    stream->size = (unsigned int) size;
+    stream->read_fn = __haruppSharedStreamRead;
+    stream->seek_fn = __haruppSharedStreamSeek;
+    stream->tell_fn = __haruppSharedStreamTell;
+    stream->size_fn = __haruppSharedStreamSize;
+    stream->free_fn = __haruppSharedStreamFree;
+    stream->attr = new __HaruppSharedStream{std::move(owner), data, (unsigned int) size, 0U};
+    return stream;
+}
+
+static bool __haruppReadFile(const std::string& fileName, std::vector<unsigned char>& bytes) {
+    std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+    std::streamoff size = file.tellg();
+    if (size < 0 || !file.seekg(0)) return false;
+    bytes.resize((std::size_t) size);
+    return (bool) file.read((char*) bytes.data(), size);
+}
+
+// Gives an image dictionary data which is already Flate encoded
+static void __haruppSetFlateData(HPDF_Doc pdfDoc, HPDF_Dict image, std::vector<unsigned char>&& data) {
+    std::shared_ptr<const std::vector<unsigned char>> owner = std::make_shared<const std::vector<unsigned char>>(std::move(data));
+    HPDF_Stream stream = __haruppNewSharedStream(pdfDoc, owner, owner->data(), owner->size());
+    if (stream == nullptr) {
+        HPDF_CheckError(&pdfDoc->error);
+        __haruppCheck(stream);
+        return;
+    }
+    HPDF_Stream_Free(image->stream);
+    image->stream = stream;
+    image->filter = HPDF_STREAM_FILTER_NONE;
+    image->write_fn = __haruppWriteFlateFilter;
+}
+
+// Fills an image dictionary from a decoded image
+static void __haruppWriteDecodedImage(HPDF_Doc pdfDoc, HPDF_Image image, __HaruppDecodedImage& decoded) {
+    __haruppCheck(HPDF_Dict_AddNumber(image, "Width", (HPDF_INT32) decoded.width));
+    __haruppCheck(HPDF_Dict_AddNumber(image, "Height", (HPDF_INT32) decoded.height));
+    __haruppCheck(HPDF_Dict_AddNumber(image, "BitsPerComponent", (HPDF_INT32) decoded.bitsPerComponent));
+    switch (decoded.colorSpace) {
+        case ColorSpace::DEVICE_GRAY: __haruppCheck(HPDF_Dict_AddName(image, "ColorSpace", "DeviceGray")); break;
+        case ColorSpace::DEVICE_CMYK: {
+            // Same decode array as LibHaru's JPEG loader
+            __haruppCheck(HPDF_Dict_AddName(image, "ColorSpace", "DeviceCMYK"));
+            HPDF_Array decode = __haruppCheck(HPDF_Array_New(pdfDoc->mmgr));
+            if (decode == nullptr) return;
+            for (int i = 0; i < 4; ++i) {
+                __haruppCheck(HPDF_Array_AddNumber(decode, 1));
+                __haruppCheck(HPDF_Array_AddNumber(decode, 0));
+            }
+            __haruppCheck(HPDF_Dict_Add(image, "Decode", decode));
+            break;
+        }
+        case ColorSpace::INDEXED: {
+            HPDF_Array colorSpace = __haruppCheck(HPDF_Array_New(pdfDoc->mmgr));
+            if (colorSpace == nullptr) return;
+            __haruppCheck(HPDF_Array_AddName(colorSpace, "Indexed"));
+            __haruppCheck(HPDF_Array_AddName(colorSpace, "DeviceRGB"));
+            __haruppCheck(HPDF_Array_AddNumber(colorSpace, (HPDF_INT32) (decoded.palette.size() / 3U) - 1));
+            __haruppCheck(HPDF_Array_Add(colorSpace, __haruppCheck(HPDF_Binary_New(pdfDoc->mmgr, decoded.palette.data(), (HPDF_UINT) decoded.palette.size()))));
+            __haruppCheck(HPDF_Dict_Add(image, "ColorSpace", colorSpace));
+            break;
+        }
+        default: __haruppCheck(HPDF_Dict_AddName(image, "ColorSpace", "DeviceRGB")); break;
+    }
+
+    // JPEG data is written as is by LibHaru, Flate data is already encoded
+    if (decoded.dct) {
+        std::shared_ptr<const std::vector<unsigned char>> owner = std::make_shared<const std::vector<unsigned char>>(std::move(decoded.data));
+        HPDF_Stream stream = __haruppNewSharedStream(pdfDoc, owner, owner->data(), owner->size());
+        if (stream == nullptr) {
+            HPDF_CheckError(&pdfDoc->error);
+            __haruppCheck(stream);
+            return;
+        }
+        HPDF_Stream_Free(image->stream);
+        image->stream = stream;
+        image->filter = HPDF_STREAM_FILTER_DCT_DECODE;
+        return;
+    }
+    __haruppSetFlateData(pdfDoc, image, std::move(decoded.data));
+    if (decoded.predictorColors > 0U) {
+        HPDF_Dict parameters = __haruppCheck(HPDF_Dict_New(pdfDoc->mmgr));
+        if (parameters == nullptr) return;
+        __haruppCheck(HPDF_Dict_AddNumber(parameters, "Predictor", 15));
+        __haruppCheck(HPDF_Dict_AddNumber(parameters, "Colors", (HPDF_INT32) decoded.predictorColors));
+        __haruppCheck(HPDF_Dict_AddNumber(parameters, "BitsPerComponent", (HPDF_INT32) decoded.bitsPerComponent));
+        __haruppCheck(HPDF_Dict_AddNumber(parameters, "Columns", (HPDF_INT32) decoded.width));
+        __haruppCheck(HPDF_Dict_Add(image, "DecodeParms", parameters));
+    }
+
+    // Transparency goes to a soft mask, as done by LibHaru's PNG loader
+    if (!decoded.alpha.empty()) {
+        HPDF_Dict mask = __haruppCheck(HPDF_DictStream_New(pdfDoc->mmgr, pdfDoc->xref));
+        if (mask == nullptr) return;
+        mask->header.obj_class |= HPDF_OSUBCLASS_XOBJECT;
+        __haruppCheck(HPDF_Dict_AddName(mask, "Type", "XObject"));
+        __haruppCheck(HPDF_Dict_AddName(mask, "Subtype", "Image"));
+        __haruppCheck(HPDF_Dict_AddNumber(mask, "Width", (HPDF_INT32) decoded.width));
+        __haruppCheck(HPDF_Dict_AddNumber(mask, "Height", (HPDF_INT32) decoded.height));
+        __haruppCheck(HPDF_Dict_AddName(mask, "ColorSpace", "DeviceGray"));
+        __haruppCheck(HPDF_Dict_AddNumber(mask, "BitsPerComponent", 8));
+        __haruppSetFlateData(pdfDoc, mask, std::move(decoded.alpha));
+        __haruppCheck(HPDF_Dict_Add(image, "SMask", mask));
+    }
+}
+
+// Turns an image dictionary into a white 1x1 image, for images whose data could not be read
+static void __haruppWriteBlankImage(HPDF_Image image) {
+    static const HPDF_BYTE white = 0xFFU;
+    __haruppCheck(HPDF_Dict_AddNumber(image, "Width", 1));
+    __haruppCheck(HPDF_Dict_AddNumber(image, "Height", 1));
+    __haruppCheck(HPDF_Dict_AddNumber(image, "BitsPerComponent", 8));
+    __haruppCheck(HPDF_Dict_AddName(image, "ColorSpace", "DeviceGray"));
+    HPDF_MemStream_FreeData(image->stream);
+    HPDF_STATUS res = HPDF_Stream_Write(image->stream, &white, 1U);
+    if (res != HPDF_OK) HPDF_CheckError(image->error);
+    __haruppCheck(res);
+}
+
+// Image dictionary without its size, color space nor data
+static HPDF_Image __haruppNewImage(HPDF_Doc pdfDoc) {
+    HPDF_Image image = __haruppCheck(HPDF_DictStream_New(pdfDoc->mmgr, pdfDoc->xref));
+    if (image == nullptr) return nullptr;
+    image->header.obj_class |= HPDF_OSUBCLASS_XOBJECT;
+    __haruppCheck(HPDF_Dict_AddName(image, "Type", "XObject"));
+    __haruppCheck(HPDF_Dict_AddName(image, "Subtype", "Image"));
+    return image;
+}
+
+// Same registration as the LibHaru loaders, except that a font already registered is returned instead of raising an error
+static const char* __haruppRegisterFontDef(HPDF_Doc pdfDoc, HPDF_FontDef def) {
+    if (def == nullptr) return nullptr;
+    HPDF_FontDef existing = HPDF_Doc_FindFontDef(pdfDoc, def->base_font);
+    if (existing != nullptr) {
+        HPDF_FontDef_Free(def);
+        return existing->base_font;
+    }
+    if (HPDF_Doc_RegisterFontDef(pdfDoc, def) != HPDF_OK) return nullptr;
+    return def->base_font;
+}
+
+static const char* __haruppLoadTrueTypeFont(HPDF_Doc pdfDoc, HPDF_Stream stream, int index, bool embedding) {
+    // The font definition takes the stream over, even when loading fails
+    if (stream == nullptr) return nullptr;
+    HPDF_FontDef def = (index < 0)? HPDF_TTFontDef_Load(pdfDoc->mmgr, stream, embedding):
+        HPDF_TTFontDef_Load2(pdfDoc->mmgr, stream, (unsigned int) index, embedding);
+    if (def == nullptr) return nullptr;
+    // Embedded definitions are renamed below, so they are never found by name again: callers key them in the font registry
+    bool registered = HPDF_Doc_FindFontDef(pdfDoc, def->base_font) != nullptr;
+    const char* name = __haruppRegisterFontDef(pdfDoc, def);
+    if (name == nullptr || registered || !embedding) return name;
+
+    // Embedded fonts get unique subset tags: HPDFAA, HPDFAB...
+    if (pdfDoc->ttfont_tag[0] == 0) std::memcpy(pdfDoc->ttfont_tag, "HPDFAA", 6U);
+    else for (int i = 5; i >= 0; --i) {
+        if (++pdfDoc->ttfont_tag[i] > 'Z') pdfDoc->ttfont_tag[i] = 'A';
+        else break;
+    }
+    HPDF_TTFontDef_SetTagName(def, (char*) pdfDoc->ttfont_tag);
+    return name;
 }
 
 static UTCIndicator __toUTCInd(char c) {
@@ -175,12 +982,94 @@ Document::~Document() {
     close();
 }
 
+Document::Document(Document&& other) noexcept {
+    *this = std::move(other);
+}
+
+Document& Document::operator=(Document&& other) noexcept {
+    if (this == &other) return *this;
+    close();
+    pdfDoc = other.pdfDoc;
+    imports = std::move(other.imports);
+    ownedStreamingSink = std::move(other.ownedStreamingSink);
+    streamingOutput = std::move(other.streamingOutput);
+    memoryContext = std::move(other.memoryContext);
+    allocatorSlot = other.allocatorSlot;
+    generation = other.generation;
+    pageIndex = std::move(other.pageIndex);
+    pageTreeNodes = std::move(other.pageTreeNodes);
+    pageTreeConfigured = other.pageTreeConfigured;
+    imageRegistry = std::move(other.imageRegistry);
+    imageDeduplication = other.imageDeduplication;
+    fontRegistry = std::move(other.fontRegistry);
+    fontSubsetting = other.fontSubsetting;
+    fontSubsets = std::move(other.fontSubsets);
+    remappedGlyphMaps = std::move(other.remappedGlyphMaps);
+    pendingImages = std::move(other.pendingImages);
+    graphicsStates = std::move(other.graphicsStates);
+    contentStreamOptimization = other.contentStreamOptimization;
+    formCanvases = std::move(other.formCanvases);
+    encodedPages = std::move(other.encodedPages);
+
+    // Handles follow the document, since they point to its generation counter
+    other.pdfDoc = nullptr;
+    other.allocatorSlot = -1;
+    other.generation = nullptr;
+    other.__clearDocumentState();
+    other.fontRegistry.clear();
+    return *this;
+}
+
 
 /******************** BASIC FUNCTIONS ********************/
 
 void Document::open() {
-    pdfDoc = HPDF_New(__haruppErrorHandler, nullptr);
-    if (pdfDoc == nullptr) throw MemoryAllocationFailedException();
+    // An error left pending by another document of this thread must not be thrown from this one
+    __haruppClearError();
+    // Accounting is best effort here, fall back to the plain allocator when every slot is taken
+    std::unique_ptr<__HaruppMemoryContext> context = std::make_unique<__HaruppMemoryContext>();
+    int slot = __haruppAcquireSlot(context.get());
+    if (slot < 0) pdfDoc = HPDF_New(__haruppErrorHandler, nullptr);
+    else {
+        const __HaruppSlotHooks& hooks = __haruppSlotHooks[slot];
+        pdfDoc = HPDF_NewEx(__haruppErrorHandler, hooks.alloc, hooks.free, 0U, context.get());
+        if (pdfDoc == nullptr) __haruppReleaseSlot(slot);
+    }
+    if (pdfDoc == nullptr) {
+        __haruppClearError();
+        throw MemoryAllocationFailedException();
+    }
+    if (slot >= 0) {
+        memoryContext = std::move(context);
+        allocatorSlot = slot;
+    }
+
+    generation = __haruppAcquireGeneration();
+
+    // Initialise imports
+    imports.reserve(__HARUPP_ENCODING_IMPORTS_LENGTH);
+    for (int _ = 0; _ < __HARUPP_ENCODING_IMPORTS_LENGTH; ++_) imports.push_back(false);
+}
+
+void Document::open(Allocator& allocator) {
+    __haruppClearError();
+    std::unique_ptr<__HaruppMemoryContext> context = std::make_unique<__HaruppMemoryContext>();
+    context->allocator = &allocator;
+    int slot = __haruppAcquireSlot(context.get());
+    if (slot < 0) throw MemoryAllocationFailedException();
+
+    const __HaruppSlotHooks& hooks = __haruppSlotHooks[slot];
+    pdfDoc = HPDF_NewEx(__haruppErrorHandler, hooks.alloc, hooks.free, 0U, context.get());
+    if (pdfDoc == nullptr) {
+        __haruppClearError();
+        allocator.reset();
+        __haruppReleaseSlot(slot);
+        throw MemoryAllocationFailedException();
+    }
+    memoryContext = std::move(context);
+    allocatorSlot = slot;
+
+    generation = __haruppAcquireGeneration();
 
     // Initialise imports
     imports.reserve(__HARUPP_ENCODING_IMPORTS_LENGTH);
@@ -188,14 +1077,34 @@ void Document::open() {
 }
 
 void Document::close() {
+    streamingOutput.reset();
+    ownedStreamingSink.reset();
+    if (generation != nullptr) {
+        __haruppExpireHandles(generation);
+        __haruppReleaseGeneration(generation);
+        generation = nullptr;
+    }
     if (pdfDoc != nullptr) {
         HPDF_Free(pdfDoc);
         pdfDoc = nullptr;
     }
+    __clearDocumentState();
+    fontRegistry.clear();
+
+    // LibHaru is done with the allocator, everything can go at once
+    if (memoryContext != nullptr) {
+        if (memoryContext->allocator != nullptr) memoryContext->allocator->reset();
+        __haruppReleaseSlot(allocatorSlot);
+        memoryContext.reset();
+        allocatorSlot = -1;
+    }
 }
 
 void Document::newDocument() {
-    HPDF_NewDoc(pdfDoc);
+    __haruppClearError();
+    __haruppExpireHandles(generation);
+    __clearDocumentState();
+    __haruppCheck(HPDF_NewDoc(pdfDoc));
 }
 
 bool Document::isOpen() const noexcept {
@@ -203,21 +1112,32 @@ bool Document::isOpen() const noexcept {
 }
 
 void Document::freeResources() {
+    __haruppExpireHandles(generation);
+    __clearDocumentState();
     HPDF_FreeDoc(pdfDoc);
 }
 
 void Document::freeAllResources() {
+    __haruppExpireHandles(generation);
+    __clearDocumentState();
     HPDF_FreeDocAll(pdfDoc);
+    fontRegistry.clear();
     for (int i = __HARUPP_ENCODING_INDEX_START; i < __HARUPP_ENCODING_IMPORTS_LENGTH; ++i)
         imports[i] = false;
 }
 
 void Document::saveToFile(const std::string& fileName) {
-    HPDF_SaveToFile(pdfDoc, fileName.c_str());
+    if (streamingOutput != nullptr) throw InvalidStreamingStateException();
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::OTHER);
+    __prepareSave();
+    __haruppCheck(HPDF_SaveToFile(pdfDoc, fileName.c_str()));
 }
 
 void Document::saveToStream() {
-    HPDF_SaveToStream(pdfDoc);
+    if (streamingOutput != nullptr) throw InvalidStreamingStateException();
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::OTHER);
+    __prepareSave();
+    __haruppCheck(HPDF_SaveToStream(pdfDoc));
 }
 
 unsigned int Document::getStreamSize() const {
@@ -230,16 +1150,123 @@ std::vector<unsigned char> Document::readFromStream(unsigned int size) {
     return __execAndGetVector(HPDF_ReadFromStream, pdfDoc, size);
 }
 
+unsigned int Document::readFromStream(unsigned char* buffer, unsigned int size) {
+    if (size == 0U || getStreamSize() == 0U) return 0U;
+    __haruppCheck(HPDF_ReadFromStream(pdfDoc, buffer, &size));
+    return size;
+}
+
 std::vector<unsigned char> Document::readFromStream() {
     return readFromStream(getStreamSize());
 }
 
+void Document::saveToSink(OutputSink& sink) {
+    if (streamingOutput != nullptr) throw InvalidStreamingStateException();
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::OTHER);
+    __prepareSave();
+    __HaruppSinkStream target;
+    __haruppInitSinkStream(pdfDoc, target, sink);
+
+    // LibHaru only saves to the document stream, which is swapped for the sink stream meanwhile
+    HPDF_Stream previous = pdfDoc->stream;
+    pdfDoc->stream = &target.stream;
+    HPDF_STATUS res = HPDF_SaveToStream(pdfDoc);
+    pdfDoc->stream = previous;
+    __haruppCheckSinkWrite(pdfDoc, target, res);
+}
+
+void Document::writeStreamTo(OutputSink& sink) const {
+    if (pdfDoc == nullptr) return;
+    __writeStreamChunks(pdfDoc->stream, sink);
+}
+
+unsigned int Document::getStreamChunkCount() const {
+    if (pdfDoc == nullptr || pdfDoc->stream == nullptr) return 0U;
+    return HPDF_MemStream_GetBufCount(pdfDoc->stream);
+}
+
+std::pair<const unsigned char*, unsigned int> Document::getStreamChunk(unsigned int index) const {
+    if (index >= getStreamChunkCount()) return {nullptr, 0U};
+    unsigned int size = 0U;
+    const unsigned char* chunk = HPDF_MemStream_GetBufPtr(pdfDoc->stream, index, &size);
+    return {chunk, size};
+}
+
 void Document::rewindStream() {
-    if (getStreamSize() > 0U) HPDF_ResetStream(pdfDoc);
+    if (getStreamSize() > 0U) __haruppCheck(HPDF_ResetStream(pdfDoc));
+}
+
+void Document::beginStreaming(OutputSink& sink) {
+    if (pdfDoc == nullptr || streamingOutput != nullptr || pdfDoc->encrypt_on) throw InvalidStreamingStateException();
+    __beginStreaming(sink);
+}
+
+void Document::beginStreaming(std::ostream& sink) {
+    if (pdfDoc == nullptr || streamingOutput != nullptr || pdfDoc->encrypt_on) throw InvalidStreamingStateException();
+    std::unique_ptr<OutputSink> ownedSink = std::make_unique<OStreamSink>(sink);
+    __beginStreaming(*ownedSink);
+    ownedStreamingSink = std::move(ownedSink);
+}
+
+void Document::finalizePage(const Page& page) {
+    if (streamingOutput == nullptr) throw InvalidStreamingStateException();
+    HPDF_Page content = page.__content();
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::PAGES);
+    __closePage(content);
+    if (contentStreamOptimization) __optimizePageContents(pdfDoc, content);
+    __encodePageContents(content);
+    encodedPages.insert(content);
+
+    // Any further drawing operation on this page will now raise an InvalidGModeException
+    HPDF_PageAttr attr = (HPDF_PageAttr) content->attr;
+    attr->gmode = 0U;
+
+    // The content and the decoded images of the page are written now and their data is released. The page dictionary
+    // waits for the end, since the page tree is balanced when saving.
+    HPDF_STATUS res = __haruppStreamObject(pdfDoc, *streamingOutput, attr->contents);
+    for (HPDF_Dict image: __haruppGetPageImages(content)) {
+        if (res != HPDF_OK) break;
+        bool pending = std::any_of(pendingImages.begin(), pendingImages.end(),
+            [image](const std::shared_ptr<__HaruppImageJob>& job) { return job->dict == image; });
+        if (pending) continue;
+        res = __haruppStreamObject(pdfDoc, *streamingOutput, image);
+        if (res == HPDF_OK) res = __haruppStreamObject(pdfDoc, *streamingOutput, (HPDF_Dict) HPDF_Dict_GetItem(image, "SMask", HPDF_OCLASS_DICT));
+    }
+    __haruppCheckSinkWrite(pdfDoc, streamingOutput->target, res);
+}
+
+void Document::endStreaming() {
+    if (streamingOutput == nullptr) throw InvalidStreamingStateException();
+    std::unique_ptr<__HaruppStreamingOutput> output = std::move(streamingOutput);
+    std::unique_ptr<OutputSink> ownedSink = std::move(ownedStreamingSink);
+    {
+        __HaruppMemoryScope scope(memoryContext, MemoryCategory::OTHER);
+        __prepareSave();
+        __haruppCheckSinkWrite(pdfDoc, output->target, __haruppWriteStreamingEnd(pdfDoc, *output));
+    }
+    freeResources();
+}
+
+bool Document::isStreaming() const noexcept {
+    return streamingOutput != nullptr;
+}
+
+void Document::__beginStreaming(OutputSink& sink) {
+    std::unique_ptr<__HaruppStreamingOutput> output = std::make_unique<__HaruppStreamingOutput>();
+    __haruppInitSinkStream(pdfDoc, output->target, sink);
+    output->version = (int) pdfDoc->pdf_version;
+
+    // Same header as LibHaru's, handed to the sink right away
+    char header[] = "%PDF-1.0\012%\267\276\255\252\012";
+    header[7] = (char) ('2' + output->version);
+    __haruppCheckSinkWrite(pdfDoc, output->target, HPDF_Stream_WriteStr(&output->target.stream, header));
+    streamingOutput = std::move(output);
 }
 
 bool Document::hasDocument() const {
-    return HPDF_HasDoc(pdfDoc);
+    // A revoked document is not an error
+    if (pdfDoc == nullptr || pdfDoc->catalog == nullptr) return false;
+    return __haruppCheck(HPDF_HasDoc(pdfDoc));
 }
 
 bool Document::isEmpty() const noexcept {
@@ -257,6 +1284,7 @@ unsigned long Document::getLastErrorDetail() const {
 }
 
 void Document::resetErrorCode() {
+    __haruppClearError();
     HPDF_ResetError(pdfDoc);
 }
 
@@ -264,25 +1292,122 @@ std::vector<unsigned char> Document::getContent(unsigned int size) const {
     return __execAndGetVector(HPDF_GetContents, pdfDoc, size);
 }
 
+bool Document::isMemoryAccounted() const noexcept {
+    return memoryContext != nullptr;
+}
+
+MemoryUsage Document::getMemoryUsage() const noexcept {
+    if (memoryContext == nullptr) return MemoryUsage();
+    return MemoryUsage(memoryContext->currentSize, memoryContext->peakSize, memoryContext->allocationCount, memoryContext->categorySizes);
+}
+
+void Document::setMemoryQuota(std::size_t bytes) {
+    if (memoryContext == nullptr) throw MemoryAccountingUnavailableException();
+    memoryContext->quota = bytes;
+}
+
+std::size_t Document::getMemoryQuota() const noexcept {
+    if (memoryContext == nullptr) return 0U;
+    return memoryContext->quota;
+}
+
+unsigned long Document::getElidedOperatorCount() const noexcept {
+    if (graphicsStates == nullptr) return 0UL;
+    unsigned long count = 0UL;
+    for (const std::pair<HPDF_Page const, __HaruppPageState>& page: graphicsStates->pages) count += page.second.elidedOperators;
+    return count;
+}
+
 
 /******************** PAGES HANDLING ********************/
 
+__HaruppPageState* Document::__getPageState(HPDF_Page page, bool inherited) const {
+    if (graphicsStates == nullptr) graphicsStates = std::make_unique<__HaruppGraphicsStates>();
+    return __haruppGetPageState(*graphicsStates, page, inherited);
+}
+
+void Document::__clearDocumentState() noexcept {
+    pageIndex.clear();
+    pageTreeNodes.clear();
+    pageTreeConfigured = false;
+    imageRegistry.clear();
+    fontSubsets.clear();
+    remappedGlyphMaps.clear();
+    graphicsStates.reset();
+    formCanvases.clear();
+    encodedPages.clear();
+
+    // Images still decoding are dropped, their handles expire with the document
+    for (const std::shared_ptr<__HaruppImageJob>& job: pendingImages) job->pdfDoc = nullptr;
+    pendingImages.clear();
+}
+
+void Document::__prepareSave() {
+    __resolveImages();
+    __balancePageTree();
+    __subsetFonts();
+    __optimizeContentStreams();
+}
+
+void Document::__balancePageTree() {
+    // LibHaru hangs every page off the root node unless configured otherwise, which gives a huge flat Kids array
+    if (pdfDoc == nullptr || pageTreeConfigured || pageIndex.size() <= __HARUPP_PAGE_TREE_FANOUT) return;
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::PAGES);
+    HPDF_Array rootKids = (HPDF_Array) HPDF_Dict_GetItem(pdfDoc->root_pages, "Kids", HPDF_OCLASS_ARRAY);
+    if (rootKids == nullptr) return;
+
+    // Detach everything, intermediate nodes from a previous save are reused so that none is left orphaned
+    HPDF_Array_Clear(rootKids);
+    for (HPDF_Pages node: pageTreeNodes) {
+        HPDF_Array_Clear((HPDF_Array) HPDF_Dict_GetItem(node, "Kids", HPDF_OCLASS_ARRAY));
+        HPDF_Dict_RemoveElement(node, "Parent");
+    }
+    for (HPDF_Page page: pageIndex) HPDF_Dict_RemoveElement(page, "Parent");
+
+    // Group the level into nodes of at most FANOUT kids until the root can hold it, page counts are computed by LibHaru on write
+    std::vector<HPDF_Dict> level(pageIndex.begin(), pageIndex.end());
+    std::size_t usedNodes = 0U;
+    while (level.size() > __HARUPP_PAGE_TREE_FANOUT) {
+        std::vector<HPDF_Dict> parents;
+        parents.reserve((level.size() + __HARUPP_PAGE_TREE_FANOUT - 1U) / __HARUPP_PAGE_TREE_FANOUT);
+        for (std::size_t i = 0U; i < level.size(); i += __HARUPP_PAGE_TREE_FANOUT) {
+            if (usedNodes == pageTreeNodes.size())
+                pageTreeNodes.push_back(__haruppCheck(HPDF_Pages_New(pdfDoc->mmgr, nullptr, pdfDoc->xref)));
+            HPDF_Pages node = pageTreeNodes[usedNodes++];
+            std::size_t end = std::min(i + __HARUPP_PAGE_TREE_FANOUT, level.size());
+            for (std::size_t j = i; j < end; ++j) __haruppCheck(HPDF_Pages_AddKids(node, level[j]));
+            parents.push_back(node);
+        }
+        level = std::move(parents);
+    }
+    for (HPDF_Dict kid: level) __haruppCheck(HPDF_Pages_AddKids(pdfDoc->root_pages, kid));
+
+    // New pages are appended to the root until the next save
+    pdfDoc->cur_pages = pdfDoc->root_pages;
+}
+
 void Document::setPageConfiguration(unsigned int pagePerPages) {
-    HPDF_SetPagesConfiguration(pdfDoc, pagePerPages);
+    __haruppCheck(HPDF_SetPagesConfiguration(pdfDoc, pagePerPages));
+    pageTreeConfigured = true;
 }
 
 Page Document::getPageAtIndex(unsigned int index) const {
-    HPDF_Page page = HPDF_GetPageByIndex(pdfDoc, index);
+    if (index < pageIndex.size()) return Page(pageIndex[index], generation, __getPageState(pageIndex[index]));
+    HPDF_Page page = __haruppCheck(HPDF_GetPageByIndex(pdfDoc, index));
     if (page == nullptr) throw InvalidPageIndexException();
-    return Page(page);
+    return Page(page, generation, __getPageState(page));
+}
+
+unsigned int Document::getPageCount() const noexcept {
+    return (unsigned int) pageIndex.size();
 }
 
 void Document::setPageLayout(PageLayout layout) {
-    HPDF_SetPageLayout(pdfDoc, (HPDF_PageLayout) layout);
+    __haruppCheck(HPDF_SetPageLayout(pdfDoc, (HPDF_PageLayout) layout));
 }
 
 PageLayout Document::getPageLayout() const {
-    switch (HPDF_GetPageLayout(pdfDoc)) {
+    switch (__haruppCheck(HPDF_GetPageLayout(pdfDoc))) {
         case HPDF_PAGE_LAYOUT_SINGLE: return PageLayout::SINGLE_PAGE;
         case HPDF_PAGE_LAYOUT_ONE_COLUMN: return PageLayout::ONE_COLUMN;
         case HPDF_PAGE_LAYOUT_TWO_COLUMN_LEFT: return PageLayout::TWO_COLUMN_LEFT;
@@ -294,11 +1419,11 @@ PageLayout Document::getPageLayout() const {
 }
 
 void Document::setPageMode(PageMode mode) {
-    HPDF_SetPageMode(pdfDoc, (HPDF_PageMode) mode);
+    __haruppCheck(HPDF_SetPageMode(pdfDoc, (HPDF_PageMode) mode));
 }
 
 PageMode Document::getPageMode() const {
-    switch (HPDF_GetPageMode(pdfDoc)) {
+    switch (__haruppCheck(HPDF_GetPageMode(pdfDoc))) {
         case HPDF_PAGE_MODE_USE_NONE: return PageMode::NONE;
         case HPDF_PAGE_MODE_USE_OUTLINE: return PageMode::USE_OUTLINE;
         case HPDF_PAGE_MODE_USE_THUMBS: return PageMode::USE_THUMBS;
@@ -308,33 +1433,101 @@ PageMode Document::getPageMode() const {
 }
 
 void Document::setViewerPreferences(const ViewerPreferences& preferences) {
-    HPDF_SetViewerPreference(pdfDoc, preferences.value);
+    __haruppCheck(HPDF_SetViewerPreference(pdfDoc, preferences.value));
 }
 
 ViewerPreferences Document::getViewerPreferences() const {
-    return ViewerPreferences(HPDF_GetViewerPreference(pdfDoc));
+    return ViewerPreferences(__haruppCheck(HPDF_GetViewerPreference(pdfDoc)));
 }
 
 void Document::setOpenDestination(const Destination& destination) {
-    HPDF_SetOpenAction(pdfDoc, destination.__innerContent);
+    __haruppCheck(HPDF_SetOpenAction(pdfDoc, destination.__innerContent));
 }
 
 Page Document::getCurrentPage() const {
-    HPDF_Page page = HPDF_GetCurrentPage(pdfDoc);
+    HPDF_Page page = __haruppCheck(HPDF_GetCurrentPage(pdfDoc));
     if (page == nullptr) throw InvalidPageIndexException();
-    return Page(page);
+    return Page(page, generation, __getPageState(page));
 }
 
 Page Document::addPage() {
-    return Page(HPDF_AddPage(pdfDoc));
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::PAGES);
+    HPDF_Page page = __haruppCheck(HPDF_AddPage(pdfDoc));
+    if (page != nullptr) pageIndex.push_back(page);
+    return Page(page, generation, __getPageState(page));
 }
 
 Page Document::insertPageBefore(const Page& page) {
-    return Page(HPDF_InsertPage(pdfDoc, page.__innerContent));
+    HPDF_Page target = page.__content();
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::PAGES);
+    HPDF_Page newPage = __haruppCheck(HPDF_InsertPage(pdfDoc, target));
+    if (newPage != nullptr) pageIndex.insert(std::find(pageIndex.begin(), pageIndex.end(), target), newPage);
+    return Page(newPage, generation, __getPageState(newPage));
+}
+
+std::vector<Page> Document::addPages(unsigned int count, PageSize size, PageOrientation orientation) {
+    return addPages(count, PageSpec(size, orientation));
+}
+
+std::vector<Page> Document::addPages(unsigned int count, const PageSpec& spec) {
+    std::vector<Page> pages;
+    if (count == 0U) return pages;
+    // A dimension left to 0 keeps its default, the set ones are checked before any page is added
+    float width = spec.getWidth(), height = spec.getHeight();
+    if ((width != 0.f && !(width >= HPDF_MIN_PAGE_WIDTH && width <= HPDF_MAX_PAGE_WIDTH)) ||
+        (height != 0.f && !(height >= HPDF_MIN_PAGE_HEIGHT && height <= HPDF_MAX_PAGE_HEIGHT))) {
+        __haruppRaiseError(pdfDoc, HPDF_PAGE_INVALID_SIZE, 0);
+        return pages;
+    }
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::PAGES);
+    pages.reserve(count);
+    pageIndex.reserve(pageIndex.size() + count);
+
+    // The first page goes through the checked setters
+    HPDF_Page first = __haruppCheck(HPDF_AddPage(pdfDoc));
+    if (first == nullptr) return pages;
+    pageIndex.push_back(first);
+    pages.push_back(Page(first, generation, __getPageState(first)));
+    if (spec.hasPredefinedSize())
+        __haruppCheck(HPDF_Page_SetSize(first, (HPDF_PageSizes) spec.getSize(), (HPDF_PageDirection) spec.getOrientation()));
+    if (width != 0.f) __haruppCheck(HPDF_Page_SetWidth(first, width));
+    if (height != 0.f) __haruppCheck(HPDF_Page_SetHeight(first, height));
+    for (int i = (int) PageBoundary::MEDIABOX; i <= (int) PageBoundary::ARTBOX; ++i) {
+        Box box = spec.getBoundary((PageBoundary) i);
+        if (!box.isEmpty())
+            __haruppCheck(HPDF_Page_SetBoundary(first, (HPDF_PageBoundary) i, box.getLeft(), box.getBottom(), box.getRight(), box.getTop()));
+    }
+    if (spec.getRotation() != PageRotation::NONE) __haruppCheck(HPDF_Page_SetRotate(first, (unsigned short) spec.getRotation()));
+    if (count == 1U) return pages;
+
+    // Grow the page list and the Kids array of the current Pages node once, instead of every few pages
+    // (with a pages configuration, LibHaru keeps switching to new Pages nodes, so only the page list is grown)
+    HPDF_Array kids = (pdfDoc->page_per_pages == 0U)? (HPDF_Array) HPDF_Dict_GetItem(pdfDoc->cur_pages, "Kids", HPDF_OCLASS_ARRAY): nullptr;
+    __HaruppListGrowth pageListGrowth(pdfDoc->page_list, count);
+    __HaruppListGrowth kidsGrowth((kids != nullptr)? kids->list: nullptr, count);
+
+    // The others get a copy of the validated media box, written in place
+    float mediaBox[4];
+    if (!__haruppGetBoxValues(first, "MediaBox", mediaBox)) throw InvalidPageSizeException();
+    for (unsigned int n = 1U; n < count; ++n) {
+        HPDF_Page page = __haruppCheck(HPDF_AddPage(pdfDoc));
+        if (page == nullptr) break;
+        pageIndex.push_back(page);
+        pages.push_back(Page(page, generation, __getPageState(page)));
+
+        __haruppSetBoxValues(page, "MediaBox", mediaBox);
+        for (int i = (int) PageBoundary::CROPBOX; i <= (int) PageBoundary::ARTBOX; ++i) {
+            Box box = spec.getBoundary((PageBoundary) i);
+            if (!box.isEmpty())
+                __haruppCheck(HPDF_Page_SetBoundary(page, (HPDF_PageBoundary) i, box.getLeft(), box.getBottom(), box.getRight(), box.getTop()));
+        }
+        if (spec.getRotation() != PageRotation::NONE) __haruppCheck(HPDF_Dict_AddNumber(page, "Rotate", (int) spec.getRotation()));
+    }
+    return pages;
 }
 
 void __addPageLabel(HPDF_Doc pdfDoc, PageNumberStyle style, unsigned int pageNumber, unsigned int firstPage, const char* prefix) {
-    HPDF_AddPageLabel(pdfDoc, pageNumber, (HPDF_PageNumStyle) style, firstPage, prefix);
+    __haruppCheck(HPDF_AddPageLabel(pdfDoc, pageNumber, (HPDF_PageNumStyle) style, firstPage, prefix));
 }
 
 void Document::addPageLabel(PageNumberStyle style, unsigned int pageNumber, unsigned int firstPage) {
@@ -349,7 +1542,8 @@ void Document::addPageLabel(const std::string& prefix, PageNumberStyle style, un
 /******************** FONT HANDLING ********************/
 
 Font Document::__getFont(const char* fontName, const char* encodingName) {
-    return Font(HPDF_GetFont(pdfDoc, fontName, encodingName));
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::FONTS);
+    return Font(__haruppCheck(HPDF_GetFont(pdfDoc, fontName, encodingName)), generation);
 }
 
 Font Document::getFont(const std::string& fontName, SingleByteEncoding encoding) {
@@ -365,8 +1559,32 @@ Font Document::getFont(const std::string& fontName, const std::string& encodingN
 }
 
 std::string Document::__loadType1FontFromFile(const char* AFMFileName, const char* dataFileName) {
-    const char* res = HPDF_LoadType1FontFromFile(pdfDoc, AFMFileName, dataFileName);
-    return (res == nullptr)? std::string(): res;
+    std::string key = std::string("1") + AFMFileName + '\n' + ((dataFileName == nullptr)? "": dataFileName);
+    std::unordered_map<std::string, std::string>::const_iterator it = fontRegistry.find(key);
+    if (it != fontRegistry.end()) return it->second;
+
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::FONTS);
+    std::shared_ptr<const std::vector<unsigned char>> metrics = FontCache::__acquire(AFMFileName);
+    std::shared_ptr<const std::vector<unsigned char>> data = (dataFileName == nullptr)? nullptr: FontCache::__acquire(dataFileName);
+    const char* res;
+    if (metrics == nullptr || (dataFileName != nullptr && data == nullptr)) {
+        // Let LibHaru report why the files cannot be read
+        res = __haruppCheck(HPDF_LoadType1FontFromFile(pdfDoc, AFMFileName, dataFileName));
+    } else {
+        // Unlike TrueType definitions, Type1 definitions copy what they need, the streams are freed right away
+        HPDF_Stream metricsStream = __haruppNewSharedStream(pdfDoc, metrics, metrics->data(), metrics->size());
+        HPDF_Stream dataStream = (data == nullptr)? nullptr: __haruppNewSharedStream(pdfDoc, data, data->data(), data->size());
+        res = nullptr;
+        if (metricsStream != nullptr && (data == nullptr || dataStream != nullptr))
+            res = __haruppRegisterFontDef(pdfDoc, HPDF_Type1FontDef_Load(pdfDoc->mmgr, metricsStream, dataStream));
+        if (metricsStream != nullptr) HPDF_Stream_Free(metricsStream);
+        if (dataStream != nullptr) HPDF_Stream_Free(dataStream);
+        if (res == nullptr) HPDF_CheckError(&pdfDoc->error);
+        res = __haruppCheck(res);
+    }
+    if (res == nullptr) return std::string();
+    fontRegistry.emplace(std::move(key), res);
+    return res;
 }
 
 std::string Document::loadType1FontFromFile(const std::string& AFMFileName) {
@@ -377,30 +1595,224 @@ std::string Document::loadType1FontFromFile(const std::string& AFMFileName, cons
     return __loadType1FontFromFile(AFMFileName.c_str(), dataFileName.c_str());
 }
 
+std::string Document::__loadTrueTypeFontFromFile(const std::string& fileName, int index, bool embedding, bool mapped) {
+    std::string key = std::string("T") + std::to_string(index) + '\n' + fileName;
+    std::unordered_map<std::string, std::string>::const_iterator it = fontRegistry.find(key);
+    if (it != fontRegistry.end()) return it->second;
+
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::FONTS);
+    std::shared_ptr<const void> owner;
+    const unsigned char* data = nullptr;
+    std::size_t size = 0U;
+    if (mapped) {
+        std::shared_ptr<const __HaruppMappedFile> file = __haruppMapFile(fileName);
+        if (file != nullptr) {
+            data = file->data;
+            size = file->size;
+            owner = std::move(file);
+        }
+    }
+    if (owner == nullptr) {
+        std::shared_ptr<const std::vector<unsigned char>> bytes = FontCache::__acquire(fileName);
+        if (bytes != nullptr) {
+            data = bytes->data();
+            size = bytes->size();
+            owner = std::move(bytes);
+        }
+    }
+
+    const char* res;
+    if (owner == nullptr) {
+        // Let LibHaru report why the file cannot be read
+        res = (index < 0)? __haruppCheck(HPDF_LoadTTFontFromFile(pdfDoc, fileName.c_str(), embedding)):
+            __haruppCheck(HPDF_LoadTTFontFromFile2(pdfDoc, fileName.c_str(), (unsigned int) index, embedding));
+    } else {
+        res = __haruppLoadTrueTypeFont(pdfDoc, __haruppNewSharedStream(pdfDoc, std::move(owner), data, size), index, embedding);
+        if (res == nullptr) HPDF_CheckError(&pdfDoc->error);
+        res = __haruppCheck(res);
+    }
+    if (res == nullptr) return std::string();
+    fontRegistry.emplace(std::move(key), res);
+    return res;
+}
+
 std::string Document::loadTrueTypeFontFromFile(const std::string& fileName, bool embedding) {
-    const char* res = HPDF_LoadTTFontFromFile(pdfDoc, fileName.c_str(), embedding);
-    return (res == nullptr)? std::string(): res;
+    return __loadTrueTypeFontFromFile(fileName, -1, embedding, false);
 }
 
 std::string Document::loadTrueTypeFontFromFile(const std::string& fileName, unsigned int index, bool embedding) {
-    const char* res = HPDF_LoadTTFontFromFile2(pdfDoc, fileName.c_str(), index, embedding);
+    return __loadTrueTypeFontFromFile(fileName, (int) index, embedding, false);
+}
+
+std::string Document::loadTrueTypeFontFromMappedFile(const std::string& fileName, bool embedding) {
+    return __loadTrueTypeFontFromFile(fileName, -1, embedding, true);
+}
+
+std::string Document::loadTrueTypeFontFromMappedFile(const std::string& fileName, unsigned int index, bool embedding) {
+    return __loadTrueTypeFontFromFile(fileName, (int) index, embedding, true);
+}
+
+std::string Document::__loadTrueTypeFontFromMemory(const unsigned char* data, std::size_t size, int index, bool embedding) {
+    // Same bytes are recognized by their digest, like files by their name
+    std::string key = std::string("M") + std::to_string(index) + '\n' + __haruppDigestBytes(data, size);
+    std::unordered_map<std::string, std::string>::const_iterator it = fontRegistry.find(key);
+    if (it != fontRegistry.end()) return it->second;
+
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::FONTS);
+    const char* res = __haruppLoadTrueTypeFont(pdfDoc, __haruppNewSharedStream(pdfDoc, nullptr, data, size), index, embedding);
+    if (res == nullptr) HPDF_CheckError(&pdfDoc->error);
+    res = __haruppCheck(res);
+    if (res == nullptr) return std::string();
+    fontRegistry.emplace(std::move(key), res);
+    return res;
+}
+
+std::string Document::loadTrueTypeFontFromMemory(const unsigned char* data, std::size_t size, bool embedding) {
+    return __loadTrueTypeFontFromMemory(data, size, -1, embedding);
+}
+
+std::string Document::loadTrueTypeFontFromMemory(const unsigned char* data, std::size_t size, unsigned int index, bool embedding) {
+    return __loadTrueTypeFontFromMemory(data, size, (int) index, embedding);
+}
+
+std::string Document::loadType1FontFromMemory(const unsigned char* AFMData, std::size_t AFMSize, const unsigned char* data, std::size_t dataSize) {
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::FONTS);
+
+    // Type1 definitions copy what they need, the streams are freed right away
+    HPDF_Stream metricsStream = __haruppNewSharedStream(pdfDoc, nullptr, AFMData, AFMSize);
+    HPDF_Stream dataStream = (data == nullptr)? nullptr: __haruppNewSharedStream(pdfDoc, nullptr, data, dataSize);
+    const char* res = nullptr;
+    if (metricsStream != nullptr && (data == nullptr || dataStream != nullptr))
+        res = __haruppRegisterFontDef(pdfDoc, HPDF_Type1FontDef_Load(pdfDoc->mmgr, metricsStream, dataStream));
+    if (metricsStream != nullptr) HPDF_Stream_Free(metricsStream);
+    if (dataStream != nullptr) HPDF_Stream_Free(dataStream);
+    if (res == nullptr) HPDF_CheckError(&pdfDoc->error);
+    res = __haruppCheck(res);
     return (res == nullptr)? std::string(): res;
 }
 
 void Document::useJPFonts() {
-    HPDF_UseJPFonts(pdfDoc);
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::FONTS);
+    __haruppCheck(HPDF_UseJPFonts(pdfDoc));
 }
 
 void Document::useKRFonts() {
-    HPDF_UseKRFonts(pdfDoc);
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::FONTS);
+    __haruppCheck(HPDF_UseKRFonts(pdfDoc));
 }
 
 void Document::useCNSFonts() {
-    HPDF_UseCNSFonts(pdfDoc);
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::FONTS);
+    __haruppCheck(HPDF_UseCNSFonts(pdfDoc));
 }
 
 void Document::useCNTFonts() {
-    HPDF_UseCNTFonts(pdfDoc);
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::FONTS);
+    __haruppCheck(HPDF_UseCNTFonts(pdfDoc));
+}
+
+void Document::setFontSubsetting(bool enabled) noexcept {
+    fontSubsetting = enabled;
+}
+
+bool Document::isFontSubsettingEnabled() const noexcept {
+    return fontSubsetting;
+}
+
+void Document::setContentStreamOptimization(bool enabled) noexcept {
+    contentStreamOptimization = enabled;
+}
+
+bool Document::isContentStreamOptimizationEnabled() const noexcept {
+    return contentStreamOptimization;
+}
+
+void Document::__optimizeContentStreams() {
+    // Open text objects and saved states are kept, so that drawing can go on after saving
+    if (pdfDoc == nullptr || !contentStreamOptimization) return;
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::PAGES);
+    // Contents already encoded by ::finalizePage are kept as they are
+    for (HPDF_Page page: pageIndex) if (encodedPages.count(page) == 0U) __optimizePageContents(pdfDoc, page);
+    for (HPDF_Page canvas: formCanvases) if (encodedPages.count(canvas) == 0U) __optimizePageContents(pdfDoc, canvas);
+}
+
+void Document::__subsetFonts() {
+    if (pdfDoc == nullptr || !fontSubsetting || pdfDoc->font_mgr == nullptr) return;
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::FONTS);
+
+    // Several fonts may share an embedded font file, e.g. a TrueType font used with two encodings
+    struct __HaruppEmbeddedFont {
+        HPDF_Dict fontFile;
+        HPDF_FontDef fontdef;
+        std::vector<HPDF_Dict> glyphMaps;
+        bool identityMap;
+    };
+    std::vector<__HaruppEmbeddedFont> embeddedFonts;
+    for (HPDF_UINT i = 0U; i < pdfDoc->font_mgr->count; ++i) {
+        HPDF_Font font = (HPDF_Font) HPDF_List_ItemAt(pdfDoc->font_mgr, i);
+        HPDF_FontAttr attr = (HPDF_FontAttr) font->attr;
+        if (attr->type != HPDF_FONT_TRUETYPE && attr->type != HPDF_FONT_TYPE0_TT) continue;
+        HPDF_Font target = (attr->type == HPDF_FONT_TYPE0_TT)? attr->descendant_font: font;
+        if (target == nullptr) continue;
+        HPDF_FontAttr targetAttr = (HPDF_FontAttr) target->attr;
+        HPDF_FontDef fontdef = targetAttr->fontdef;
+        if (fontdef == nullptr || fontdef->type != HPDF_FONTDEF_TYPE_TRUETYPE || !((HPDF_TTFontDefAttr) fontdef->attr)->embedding) continue;
+
+        // LibHaru creates the descriptor and the font file when first writing the font, and reuses them afterwards
+        if (fontdef->descriptor == nullptr && target->before_write_fn != nullptr) {
+            HPDF_STATUS res = target->before_write_fn(target);
+            if (res != HPDF_OK) HPDF_CheckError(&pdfDoc->error);
+            if (__haruppCheck(res) != HPDF_OK) return;
+        }
+        if (fontdef->descriptor == nullptr) continue;
+        HPDF_Dict fontFile = (HPDF_Dict) HPDF_Dict_GetItem(fontdef->descriptor, "FontFile2", HPDF_OCLASS_DICT);
+        if (fontFile == nullptr || fontFile->stream == nullptr) continue;
+
+        std::vector<__HaruppEmbeddedFont>::iterator it = std::find_if(embeddedFonts.begin(), embeddedFonts.end(),
+            [fontFile](const __HaruppEmbeddedFont& embeddedFont) { return embeddedFont.fontFile == fontFile; });
+        if (it == embeddedFonts.end()) it = embeddedFonts.insert(embeddedFonts.end(), {fontFile, fontdef, {}, false});
+        if (attr->type == HPDF_FONT_TYPE0_TT) {
+            if (targetAttr->map_stream != nullptr) it->glyphMaps.push_back(targetAttr->map_stream);
+            else it->identityMap = true;
+        }
+    }
+
+    for (__HaruppEmbeddedFont& embeddedFont: embeddedFonts) {
+        std::unordered_map<HPDF_Dict, std::vector<int>>::iterator subset = fontSubsets.find(embeddedFont.fontFile);
+        if (subset == fontSubsets.end()) {
+            // Glyph indices used as character codes cannot be renumbered
+            if (embeddedFont.identityMap) continue;
+
+            // LibHaru flags the glyphs it measures, which covers the glyphs drawn and their composite parts
+            HPDF_TTFontDefAttr defAttr = (HPDF_TTFontDefAttr) embeddedFont.fontdef->attr;
+            std::vector<bool> used(defAttr->num_glyphs, false);
+            if (defAttr->glyph_tbl.flgs != nullptr)
+                for (HPDF_UINT16 glyph = 0U; glyph < defAttr->num_glyphs; ++glyph) used[glyph] = defAttr->glyph_tbl.flgs[glyph] != 0U;
+
+            // Fonts that cannot be parsed keep the file written by LibHaru
+            std::vector<unsigned char> data = __haruppReadMemStream(embeddedFont.fontFile->stream);
+            std::vector<unsigned char> bytes;
+            std::vector<int> glyphMap;
+            if (!__haruppSubsetTrueType(data.data(), data.size(), used, bytes, glyphMap)) continue;
+            if (__haruppRewriteMemStream(pdfDoc, embeddedFont.fontFile->stream, bytes) != HPDF_OK) return;
+            if (__haruppCheck(HPDF_Dict_AddNumber(embeddedFont.fontFile, "Length1", (HPDF_INT32) bytes.size())) != HPDF_OK) return;
+            subset = fontSubsets.emplace(embeddedFont.fontFile, std::move(glyphMap)).first;
+        }
+
+        // CIDToGIDMap streams hold a big-endian glyph index per CID, dropped glyphs become .notdef
+        const std::vector<int>& glyphMap = subset->second;
+        for (HPDF_Dict glyphMapStream: embeddedFont.glyphMaps) {
+            if (glyphMapStream->stream == nullptr || !remappedGlyphMaps.insert(glyphMapStream).second) continue;
+            std::vector<unsigned char> data = __haruppReadMemStream(glyphMapStream->stream);
+            for (std::size_t i = 0U; i + 1U < data.size(); i += 2U) {
+                std::size_t glyph = ((std::size_t) data[i] << 8) | data[i + 1U];
+                int newGlyph = (glyph < glyphMap.size() && glyphMap[glyph] > 0)? glyphMap[glyph]: 0;
+                data[i] = (unsigned char) (newGlyph >> 8);
+                data[i + 1U] = (unsigned char) newGlyph;
+            }
+            if (__haruppRewriteMemStream(pdfDoc, glyphMapStream->stream, data) != HPDF_OK) return;
+        }
+    }
 }
 
 
@@ -419,7 +1831,8 @@ void Document::__autoImportEncoding(MultiByteEncoding encoding) {
 }
 
 Encoder Document::__getEncoder(const char* name) {
-    return Encoder(HPDF_GetEncoder(pdfDoc, name));
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::OTHER);
+    return Encoder(__haruppCheck(HPDF_GetEncoder(pdfDoc, name)));
 }
 
 Encoder Document::getEncoder(SingleByteEncoding encoding) {
@@ -436,11 +1849,12 @@ Encoder Document::getEncoder(const std::string& encodingName) {
 }
 
 Encoder Document::getCurrentEncoder() const {
-    return Encoder(HPDF_GetCurrentEncoder(pdfDoc));
+    return Encoder(__haruppCheck(HPDF_GetCurrentEncoder(pdfDoc)));
 }
 
 void Document::__setCurrentEncoder(const char* name) {
-    HPDF_SetCurrentEncoder(pdfDoc, name);
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::OTHER);
+    __haruppCheck(HPDF_SetCurrentEncoder(pdfDoc, name));
 }
 
 void Document::setCurrentEncoder(SingleByteEncoding encoding) {
@@ -456,36 +1870,41 @@ void Document::setCurrentEncoder(const std::string& encodingName) {
 }
 
 void Document::useJPEncodings() {
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::OTHER);
     if (!__getImportValue(__HARUPP_JP_ENCODING_INDEX)) {
-        HPDF_UseJPEncodings(pdfDoc);
+        __haruppCheck(HPDF_UseJPEncodings(pdfDoc));
         __setImportValue(__HARUPP_JP_ENCODING_INDEX, true);
     }
 }
 
 void Document::useKREncodings() {
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::OTHER);
     if (!__getImportValue(__HARUPP_KR_ENCODING_INDEX)) {
-        HPDF_UseKREncodings(pdfDoc);
+        __haruppCheck(HPDF_UseKREncodings(pdfDoc));
         __setImportValue(__HARUPP_KR_ENCODING_INDEX, true);
     }
 }
 
 void Document::useCNSEncodings() {
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::OTHER);
     if (!__getImportValue(__HARUPP_CNS_ENCODING_INDEX)) {
-        HPDF_UseCNSEncodings(pdfDoc);
+        __haruppCheck(HPDF_UseCNSEncodings(pdfDoc));
         __setImportValue(__HARUPP_CNS_ENCODING_INDEX, true);
     }
 }
 
 void Document::useCNTEncodings() {
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::OTHER);
     if (!__getImportValue(__HARUPP_CNT_ENCODING_INDEX)) {
-        HPDF_UseCNTEncodings(pdfDoc);
+        __haruppCheck(HPDF_UseCNTEncodings(pdfDoc));
         __setImportValue(__HARUPP_CNT_ENCODING_INDEX, true);
     }
 }
 
 void Document::useUTFEncodings() {
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::OTHER);
     if (!__getImportValue(__HARUPP_UTF_ENCODING_INDEX)) {
-        HPDF_UseUTFEncodings(pdfDoc);
+        __haruppCheck(HPDF_UseUTFEncodings(pdfDoc));
         __setImportValue(__HARUPP_UTF_ENCODING_INDEX, true);
     }
 }
@@ -506,7 +1925,8 @@ void Document::disableAutoEncodingImports() {
 /******************** OUTLINE CREATION ********************/
 
 Outline Document::__createOutline(const std::string& title, const Outline* parent, const Encoder* encoder) const {
-    return Outline(HPDF_CreateOutline(pdfDoc, parent? parent->__innerContent: nullptr, title.c_str(), encoder? encoder->__innerContent: nullptr));
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::OTHER);
+    return Outline(__haruppCheck(HPDF_CreateOutline(pdfDoc, parent? parent->__content(): nullptr, title.c_str(), encoder? encoder->__innerContent: nullptr)), generation);
 }
 
 Outline Document::createOutline(const std::string& title) const {
@@ -528,48 +1948,364 @@ Outline Document::createOutline(const std::string& title, const Outline& parent,
 
 /******************** IMAGES LOADING ********************/
 
+HPDF_Image Document::__findImage(const std::string& key) const {
+    if (key.empty()) return nullptr;
+    std::unordered_map<std::string, HPDF_Image>::const_iterator it = imageRegistry.find(key);
+    return (it == imageRegistry.end())? nullptr: it->second;
+}
+
+Image Document::__registerImage(std::string&& key, HPDF_Image image) {
+    if (!key.empty() && image != nullptr) imageRegistry.emplace(std::move(key), image);
+    return Image(image, generation);
+}
+
+void Document::setImageDeduplication(bool enabled) noexcept {
+    imageDeduplication = enabled;
+}
+
+bool Document::isImageDeduplicationEnabled() const noexcept {
+    return imageDeduplication;
+}
+
 Image Document::loadPNGImageFromFile(const std::string& fileName) {
-    return Image(HPDF_LoadPngImageFromFile(pdfDoc, fileName.c_str()));
+    std::string key = __haruppFileImageKey(imageDeduplication, 'P', fileName);
+    if (HPDF_Image image = __findImage(key)) return Image(image, generation);
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::IMAGES);
+    return __registerImage(std::move(key), __haruppCheck(HPDF_LoadPngImageFromFile(pdfDoc, fileName.c_str())));
+}
+
+Image Document::loadPNGImageFromFile(const std::string& fileName, const ImageDownsampling& downsampling) {
+    if (downsampling.isEmpty()) return loadPNGImageFromFile(fileName);
+    std::string key = __haruppFileImageKey(imageDeduplication, 'P', fileName, __haruppDownsamplingKey(downsampling));
+    if (HPDF_Image image = __findImage(key)) return Image(image, generation);
+    std::vector<unsigned char> bytes;
+    if (!__haruppReadFile(fileName, bytes)) {
+        __haruppRaiseError(pdfDoc, HPDF_FILE_OPEN_ERROR, (HPDF_STATUS) errno);
+        return Image(nullptr, generation);
+    }
+    return __loadDownsampledPNGImage(bytes.data(), bytes.size(), downsampling, std::move(key));
 }
 
 Image Document::loadPartialPNGImageFromFile(const std::string& fileName) {
-    return Image(HPDF_LoadPngImageFromFile2(pdfDoc, fileName.c_str()));
+    std::string key = __haruppFileImageKey(imageDeduplication, 'p', fileName);
+    if (HPDF_Image image = __findImage(key)) return Image(image, generation);
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::IMAGES);
+    return __registerImage(std::move(key), __haruppCheck(HPDF_LoadPngImageFromFile2(pdfDoc, fileName.c_str())));
 }
 
 Image Document::loadJPEGImageFromFile(const std::string& fileName) {
-    return Image(HPDF_LoadJpegImageFromFile(pdfDoc, fileName.c_str()));
+    std::string key = __haruppFileImageKey(imageDeduplication, 'J', fileName);
+    if (HPDF_Image image = __findImage(key)) return Image(image, generation);
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::IMAGES);
+    return __registerImage(std::move(key), __haruppCheck(HPDF_LoadJpegImageFromFile(pdfDoc, fileName.c_str())));
 }
 
 Image Document::loadRawImageFromFile(
     const std::string& fileName, unsigned int width,
     unsigned int height, ColorSpace colorSpace
 ) {
-    return Image(HPDF_LoadRawImageFromFile(pdfDoc, fileName.c_str(), width, height, (HPDF_ColorSpace) colorSpace));
+    std::string parameters = std::to_string(width) + 'x' + std::to_string(height) + ':' + std::to_string((int) colorSpace);
+    std::string key = __haruppFileImageKey(imageDeduplication, 'R', fileName, parameters);
+    if (HPDF_Image image = __findImage(key)) return Image(image, generation);
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::IMAGES);
+    return __registerImage(std::move(key), __haruppCheck(HPDF_LoadRawImageFromFile(pdfDoc, fileName.c_str(), width, height, (HPDF_ColorSpace) colorSpace)));
 }
 
 Image Document::loadRawImageFromMemory(
     const std::vector<unsigned char>& bytes, unsigned int width,
     unsigned int height, ColorSpace colorSpace,
-    unsigned int bitsPerComponent
+    unsigned int bitsPerComponent, const ImageDownsampling& downsampling
 ) {
     if (bitsPerComponent != 1U && bitsPerComponent != 2U && bitsPerComponent != 4U && bitsPerComponent != 8U)
         throw InvalidBitsPerComponentException();
-    return Image(HPDF_LoadRawImageFromMem(pdfDoc, bytes.data(), width, height, (HPDF_ColorSpace) colorSpace, bitsPerComponent));
+    std::string parameters = std::to_string(width) + 'x' + std::to_string(height) + ':' + std::to_string((int) colorSpace) + ':' + std::to_string(bitsPerComponent);
+    if (__haruppReducesImage(width, height, bitsPerComponent, downsampling)) {
+        if (bytes.size() < __haruppRawImageSize(width, height, colorSpace, bitsPerComponent)) throw InvalidImageException();
+        std::string key = __haruppMemoryImageKey(imageDeduplication, 'R', bytes.data(), bytes.size(), parameters + __haruppDownsamplingKey(downsampling));
+        return __loadDownsampledRawImage(bytes.data(), width, height, colorSpace, downsampling, std::move(key));
+    }
+    std::string key = __haruppMemoryImageKey(imageDeduplication, 'R', bytes.data(), bytes.size(), parameters);
+    if (HPDF_Image image = __findImage(key)) return Image(image, generation);
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::IMAGES);
+    return __registerImage(std::move(key), __haruppCheck(HPDF_LoadRawImageFromMem(pdfDoc, bytes.data(), width, height, (HPDF_ColorSpace) colorSpace, bitsPerComponent)));
+}
+
+Image Document::__loadRawImage(
+    std::shared_ptr<const void> owner, const unsigned char* data, std::size_t size, unsigned int width,
+    unsigned int height, ColorSpace colorSpace, unsigned int bitsPerComponent, std::string&& key
+) {
+    if (HPDF_Image image = __findImage(key)) return Image(image, generation);
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::IMAGES);
+
+    // Same dictionary as LibHaru's raw images, but the stream reads the bytes in place when the document is saved
+    HPDF_Image image = __haruppCheck(HPDF_DictStream_New(pdfDoc->mmgr, pdfDoc->xref));
+    if (image == nullptr) return Image(nullptr, generation);
+    HPDF_Stream stream = __haruppNewSharedStream(pdfDoc, std::move(owner), data, size);
+    if (stream == nullptr) {
+        HPDF_CheckError(&pdfDoc->error);
+        __haruppCheck(stream);
+        return Image(nullptr, generation);
+    }
+    HPDF_Stream_Free(image->stream);
+    image->stream = stream;
+    if (pdfDoc->compression_mode & HPDF_COMP_IMAGE) image->filter = HPDF_STREAM_FILTER_FLATE_DECODE;
+
+    image->header.obj_class |= HPDF_OSUBCLASS_XOBJECT;
+    const char* colorSpaceName = (colorSpace == ColorSpace::DEVICE_GRAY)? "DeviceGray": (colorSpace == ColorSpace::DEVICE_RGB)? "DeviceRGB": "DeviceCMYK";
+    __haruppCheck(HPDF_Dict_AddName(image, "Type", "XObject"));
+    __haruppCheck(HPDF_Dict_AddName(image, "Subtype", "Image"));
+    __haruppCheck(HPDF_Dict_AddName(image, "ColorSpace", colorSpaceName));
+    __haruppCheck(HPDF_Dict_AddNumber(image, "Width", (HPDF_INT32) width));
+    __haruppCheck(HPDF_Dict_AddNumber(image, "Height", (HPDF_INT32) height));
+    __haruppCheck(HPDF_Dict_AddNumber(image, "BitsPerComponent", (HPDF_INT32) bitsPerComponent));
+    return __registerImage(std::move(key), image);
+}
+
+Image Document::__loadDownsampledRawImage(
+    const unsigned char* data, unsigned int width, unsigned int height,
+    ColorSpace colorSpace, const ImageDownsampling& downsampling, std::string&& key
+) {
+    if (HPDF_Image image = __findImage(key)) return Image(image, generation);
+    unsigned int channels = (colorSpace == ColorSpace::DEVICE_GRAY)? 1U: (colorSpace == ColorSpace::DEVICE_RGB)? 3U: 4U;
+    unsigned int targetWidth = width, targetHeight = height;
+    downsampling.computeTargetSize(targetWidth, targetHeight);
+    std::shared_ptr<const std::vector<unsigned char>> owner = std::make_shared<const std::vector<unsigned char>>(
+        __haruppResample(data, width, height, channels, targetWidth, targetHeight, downsampling.getFilter())
+    );
+    const unsigned char* resampled = owner->data();
+    std::size_t size = owner->size();
+    return __loadRawImage(std::move(owner), resampled, size, targetWidth, targetHeight, colorSpace, 8U, std::move(key));
+}
+
+Image Document::loadRawImageFromMemory(
+    std::vector<unsigned char>&& bytes, unsigned int width,
+    unsigned int height, ColorSpace colorSpace,
+    unsigned int bitsPerComponent, const ImageDownsampling& downsampling
+) {
+    std::shared_ptr<const std::vector<unsigned char>> owner = std::make_shared<const std::vector<unsigned char>>(std::move(bytes));
+    std::size_t size = __haruppRawImageSize(width, height, colorSpace, bitsPerComponent);
+    if (owner->size() < size) throw InvalidImageException();
+    std::string parameters = std::to_string(width) + 'x' + std::to_string(height) + ':' + std::to_string((int) colorSpace) + ':' + std::to_string(bitsPerComponent);
+    if (__haruppReducesImage(width, height, bitsPerComponent, downsampling)) {
+        std::string key = __haruppMemoryImageKey(imageDeduplication, 'R', owner->data(), owner->size(), parameters + __haruppDownsamplingKey(downsampling));
+        return __loadDownsampledRawImage(owner->data(), width, height, colorSpace, downsampling, std::move(key));
+    }
+    std::string key = __haruppMemoryImageKey(imageDeduplication, 'R', owner->data(), owner->size(), parameters);
+    const unsigned char* data = owner->data();
+    return __loadRawImage(std::move(owner), data, size, width, height, colorSpace, bitsPerComponent, std::move(key));
+}
+
+Image Document::loadRawImageFromMemory(
+    const unsigned char* data, std::size_t size, unsigned int width,
+    unsigned int height, ColorSpace colorSpace, unsigned int bitsPerComponent,
+    BufferOwnership ownership, const ImageDownsampling& downsampling
+) {
+    // Adopted bytes are owned right away, so that they are deleted whatever happens next
+    std::shared_ptr<const void> owner;
+    if (ownership == BufferOwnership::ADOPT) owner = std::shared_ptr<const unsigned char>(data, std::default_delete<const unsigned char[]>());
+    std::size_t imageSize = __haruppRawImageSize(width, height, colorSpace, bitsPerComponent);
+    if (data == nullptr || size < imageSize) throw InvalidImageException();
+    std::string parameters = std::to_string(width) + 'x' + std::to_string(height) + ':' + std::to_string((int) colorSpace) + ':' + std::to_string(bitsPerComponent);
+    if (__haruppReducesImage(width, height, bitsPerComponent, downsampling)) {
+        std::string key = __haruppMemoryImageKey(imageDeduplication, 'R', data, size, parameters + __haruppDownsamplingKey(downsampling));
+        return __loadDownsampledRawImage(data, width, height, colorSpace, downsampling, std::move(key));
+    }
+    std::string key = __haruppMemoryImageKey(imageDeduplication, 'R', data, size, parameters);
+    if (ownership == BufferOwnership::COPY && __findImage(key) == nullptr) {
+        std::shared_ptr<const std::vector<unsigned char>> bytes = std::make_shared<const std::vector<unsigned char>>(data, data + imageSize);
+        data = bytes->data();
+        owner = std::move(bytes);
+    }
+    return __loadRawImage(std::move(owner), data, imageSize, width, height, colorSpace, bitsPerComponent, std::move(key));
+}
+
+Image Document::loadRawImageFromMappedFile(
+    const std::string& fileName, unsigned int width,
+    unsigned int height, ColorSpace colorSpace,
+    const ImageDownsampling& downsampling
+) {
+    std::size_t size = __haruppRawImageSize(width, height, colorSpace, 8U);
+    bool reduced = __haruppReducesImage(width, height, 8U, downsampling);
+    std::shared_ptr<const __HaruppMappedFile> file = __haruppMapFile(fileName);
+    if (file == nullptr) {
+        std::vector<unsigned char> bytes;
+        if (!reduced || !__haruppReadFile(fileName, bytes)) return loadRawImageFromFile(fileName, width, height, colorSpace);
+        return loadRawImageFromMemory(std::move(bytes), width, height, colorSpace, 8U, downsampling);
+    }
+    if (file->size < size) throw InvalidImageException();
+    std::string parameters = std::to_string(width) + 'x' + std::to_string(height) + ':' + std::to_string((int) colorSpace);
+    if (reduced) {
+        std::string key = __haruppFileImageKey(imageDeduplication, 'R', fileName, parameters + __haruppDownsamplingKey(downsampling));
+        return __loadDownsampledRawImage(file->data, width, height, colorSpace, downsampling, std::move(key));
+    }
+    std::string key = __haruppFileImageKey(imageDeduplication, 'R', fileName, parameters);
+    const unsigned char* data = file->data;
+    return __loadRawImage(std::move(file), data, size, width, height, colorSpace, 8U, std::move(key));
+}
+
+PendingImage Document::__loadImageAsync(const std::string& fileName, ThreadPool& pool, bool png, const ImageDownsampling& downsampling) {
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::IMAGES);
+
+    // Placeholder filled in once the image is decoded, it can be drawn in the meantime
+    HPDF_Image image = __haruppNewImage(pdfDoc);
+    if (image == nullptr) return PendingImage();
+
+    std::shared_ptr<__HaruppImageJob> job = std::make_shared<__HaruppImageJob>();
+    job->pdfDoc = pdfDoc;
+    job->memoryContext = memoryContext.get();
+    job->dict = image;
+    pendingImages.push_back(job);
+
+    // The worker only touches the job, never the document
+    pool.submit([job, fileName, png, downsampling]() {
+        unsigned long errorNo = 0U;
+        unsigned long detailNo = 0U;
+        try {
+            std::vector<unsigned char> bytes;
+            if (!__haruppReadFile(fileName, bytes)) {
+                errorNo = HPDF_FILE_OPEN_ERROR;
+                detailNo = (unsigned long) errno;
+            } else if (png) {
+                if (!__haruppDecodePNG(bytes.data(), bytes.size(), job->image, downsampling)) errorNo = HPDF_INVALID_PNG_IMAGE;
+            } else if (!__haruppDecodeJPEG(std::move(bytes), job->image)) errorNo = HPDF_UNSUPPORTED_JPEG_FORMAT;
+        } catch (...) {
+            errorNo = HPDF_FAILD_TO_ALLOC_MEM;
+        }
+
+        std::lock_guard<std::mutex> lock(job->mutex);
+        job->errorNo = errorNo;
+        job->detailNo = detailNo;
+        job->done = true;
+        job->finished.notify_all();
+    });
+    return PendingImage(std::move(job), Image(image, generation));
+}
+
+PendingImage Document::loadPNGImageFromFileAsync(const std::string& fileName, ThreadPool& pool, const ImageDownsampling& downsampling) {
+    return __loadImageAsync(fileName, pool, true, downsampling);
+}
+
+PendingImage Document::loadJPEGImageFromFileAsync(const std::string& fileName, ThreadPool& pool) {
+    return __loadImageAsync(fileName, pool, false, ImageDownsampling());
+}
+
+void Document::__resolveImage(__HaruppImageJob& job) {
+    {
+        std::unique_lock<std::mutex> lock(job.mutex);
+        job.finished.wait(lock, [&job] { return job.done; });
+    }
+    if (job.resolved || job.pdfDoc == nullptr) return;
+
+    HPDF_Doc pdfDoc = job.pdfDoc;
+    HPDF_Image image = job.dict;
+    __HaruppMemoryScope scope(job.memoryContext, MemoryCategory::IMAGES);
+    if (job.errorNo != 0U) {
+        // The placeholder may already be drawn on pages, it must still be a valid image when the document is saved
+        __haruppWriteBlankImage(image);
+        __haruppRaiseError(pdfDoc, (HPDF_STATUS) job.errorNo, (HPDF_STATUS) job.detailNo);
+        return;
+    }
+
+    __haruppWriteDecodedImage(pdfDoc, image, job.image);
+    job.resolved = true;
+}
+
+void Document::__resolveImages() {
+    // Jobs leave the list before being resolved, so that a failing one is not met again by the next save
+    while (!pendingImages.empty()) {
+        std::shared_ptr<__HaruppImageJob> job = std::move(pendingImages.back());
+        pendingImages.pop_back();
+        __resolveImage(*job);
+    }
 }
 
 Image Document::loadPNGImageFromMemory(const std::vector<unsigned char>& bytes) {
-    return Image(HPDF_LoadPngImageFromMem(pdfDoc, bytes.data(), bytes.size()));
+    std::string key = __haruppMemoryImageKey(imageDeduplication, 'P', bytes.data(), bytes.size());
+    if (HPDF_Image image = __findImage(key)) return Image(image, generation);
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::IMAGES);
+    return __registerImage(std::move(key), __haruppCheck(HPDF_LoadPngImageFromMem(pdfDoc, bytes.data(), bytes.size())));
+}
+
+Image Document::loadPNGImageFromMemory(const std::vector<unsigned char>& bytes, const ImageDownsampling& downsampling) {
+    if (downsampling.isEmpty()) return loadPNGImageFromMemory(bytes);
+    std::string key = __haruppMemoryImageKey(imageDeduplication, 'P', bytes.data(), bytes.size(), __haruppDownsamplingKey(downsampling));
+    if (HPDF_Image image = __findImage(key)) return Image(image, generation);
+    return __loadDownsampledPNGImage(bytes.data(), bytes.size(), downsampling, std::move(key));
+}
+
+Image Document::__loadDownsampledPNGImage(
+    const unsigned char* data, std::size_t size, const ImageDownsampling& downsampling, std::string&& key
+) {
+    // Decoded here rather than by LibHaru, whose PNG loader writes the pixels straight into the image stream
+    __HaruppDecodedImage decoded;
+    if (!__haruppDecodePNG(data, size, decoded, downsampling)) {
+        __haruppRaiseError(pdfDoc, HPDF_INVALID_PNG_IMAGE, 0);
+        return Image(nullptr, generation);
+    }
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::IMAGES);
+    HPDF_Image image = __haruppNewImage(pdfDoc);
+    if (image == nullptr) return Image(nullptr, generation);
+    __haruppWriteDecodedImage(pdfDoc, image, decoded);
+    return __registerImage(std::move(key), image);
 }
 
 Image Document::loadJPEGImageFromMemory(const std::vector<unsigned char>& bytes) {
-    return Image(HPDF_LoadJpegImageFromMem(pdfDoc, bytes.data(), bytes.size()));
+    std::string key = __haruppMemoryImageKey(imageDeduplication, 'J', bytes.data(), bytes.size());
+    if (HPDF_Image image = __findImage(key)) return Image(image, generation);
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::IMAGES);
+    return __registerImage(std::move(key), __haruppCheck(HPDF_LoadJpegImageFromMem(pdfDoc, bytes.data(), bytes.size())));
+}
+
+
+/******************** FORM XOBJECTS ********************/
+
+FormXObject Document::createFormXObject(const Box& boundingBox, const TransposeMatrix& matrix) {
+    if (boundingBox.getRight() <= boundingBox.getLeft() || boundingBox.getTop() <= boundingBox.getBottom())
+        throw InvalidParameterException();
+
+    // A page outside of the page tree records the drawing, its contents stream then becomes the form itself
+    __HaruppMemoryScope scope(memoryContext, MemoryCategory::PAGES);
+    HPDF_Page canvas = __haruppCheck(HPDF_Page_New(pdfDoc->mmgr, pdfDoc->xref));
+    if (canvas == nullptr) return FormXObject(nullptr, nullptr, boundingBox, matrix, generation);
+    HPDF_Dict form = ((HPDF_PageAttr) canvas->attr)->contents;
+    if (pdfDoc->compression_mode & HPDF_COMP_TEXT) form->filter = HPDF_STREAM_FILTER_FLATE_DECODE;
+
+    // Resources are filled through the canvas and written with the form, so both point to the same indirect dictionary
+    HPDF_Dict resources = __haruppCheck(HPDF_Dict_New(pdfDoc->mmgr));
+    HPDF_Array matrixArray = __haruppCheck(HPDF_Array_New(pdfDoc->mmgr));
+    if (resources == nullptr || matrixArray == nullptr) return FormXObject(nullptr, nullptr, boundingBox, matrix, generation);
+    __haruppCheck(HPDF_Xref_Add(pdfDoc->xref, resources));
+    __haruppCheck(HPDF_Dict_Add(canvas, "Resources", resources));
+    __haruppCheck(HPDF_Dict_Add(form, "Resources", resources));
+
+    // The canvas is written as a bare dictionary, so that readers never mistake it for a page
+    __haruppCheck(HPDF_Dict_RemoveElement(canvas, "Type"));
+    __haruppCheck(HPDF_Dict_RemoveElement(canvas, "Contents"));
+    __haruppCheck(HPDF_Page_SetBoundary(canvas, HPDF_PAGE_MEDIABOX, boundingBox.getLeft(), boundingBox.getBottom(), boundingBox.getRight(), boundingBox.getTop()));
+
+    HPDF_Box box = {boundingBox.getLeft(), boundingBox.getBottom(), boundingBox.getRight(), boundingBox.getTop()};
+    __haruppCheck(HPDF_Array_AddReal(matrixArray, matrix.getA()));
+    __haruppCheck(HPDF_Array_AddReal(matrixArray, matrix.getB()));
+    __haruppCheck(HPDF_Array_AddReal(matrixArray, matrix.getC()));
+    __haruppCheck(HPDF_Array_AddReal(matrixArray, matrix.getD()));
+    __haruppCheck(HPDF_Array_AddReal(matrixArray, matrix.getX()));
+    __haruppCheck(HPDF_Array_AddReal(matrixArray, matrix.getY()));
+    __haruppCheck(HPDF_Dict_AddName(form, "Type", "XObject"));
+    __haruppCheck(HPDF_Dict_AddName(form, "Subtype", "Form"));
+    __haruppCheck(HPDF_Dict_Add(form, "BBox", __haruppCheck(HPDF_Box_Array_New(pdfDoc->mmgr, box))));
+    __haruppCheck(HPDF_Dict_Add(form, "Matrix", matrixArray));
+
+    // Page::executeContentStream only accepts XObjects
+    form->header.obj_class |= HPDF_OSUBCLASS_XOBJECT;
+    formCanvases.push_back(canvas);
+    return FormXObject(form, canvas, boundingBox, matrix, generation, __getPageState(canvas, true));
 }
 
 
 /******************** OTHER FUNCTIONS ********************/
 
 void Document::setAttribute(StringAttribute parameter, const std::string& value) {
-    HPDF_SetInfoAttr(pdfDoc, (HPDF_InfoType) parameter, value.c_str());
+    __haruppCheck(HPDF_SetInfoAttr(pdfDoc, (HPDF_InfoType) parameter, value.c_str()));
 }
 
 void Document::setAttribute(DateTimeAttribute parameter, const DateTime& value) {
@@ -585,11 +2321,11 @@ void Document::setAttribute(DateTimeAttribute parameter, const DateTime& value)
     date.ind = (char) value.getUTCIndicator();
     date.off_hour = value.getOffHour();
     date.off_minutes = value.getOffMinutes();
-    HPDF_SetInfoDateAttr(pdfDoc, (HPDF_InfoType) parameter, date);
+    __haruppCheck(HPDF_SetInfoDateAttr(pdfDoc, (HPDF_InfoType) parameter, date));
 }
 
 std::optional<std::string> __getInfoAttribute(HPDF_Doc pdfDoc, int parameter) {
-    const char* value = HPDF_GetInfoAttr(pdfDoc, (HPDF_InfoType) parameter);
+    const char* value = __haruppCheck(HPDF_GetInfoAttr(pdfDoc, (HPDF_InfoType) parameter));
     if (value == nullptr) return {};
     return value;
 }
@@ -624,35 +2360,32 @@ std::optional<DateTime> Document::getInfoAttribute(enums::DateTimeAttribute para
 }
 
 void __setPassword(HPDF_Doc pdfDoc, const char* ownerPassword, const char* userPassword) {
-    HPDF_SetPassword(pdfDoc, ownerPassword, userPassword);
+    __haruppCheck(HPDF_SetPassword(pdfDoc, ownerPassword, userPassword));
 }
 
 void Document::setPassword(const std::string& ownerPassword) {
+    if (streamingOutput != nullptr) throw InvalidStreamingStateException();
     __setPassword(pdfDoc, ownerPassword.c_str(), nullptr);
 }
 
 void Document::setPassword(const std::string& ownerPassword, const std::string& userPassword) {
+    if (streamingOutput != nullptr) throw InvalidStreamingStateException();
     __setPassword(pdfDoc, ownerPassword.c_str(), userPassword.c_str());
 }
 
 void Document::setPermissions(const Permissions& permissions) {
-    HPDF_SetPermission(pdfDoc, permissions.value);
+    __haruppCheck(HPDF_SetPermission(pdfDoc, permissions.value));
 }
 
 void Document::setR2EncryptMode() {
-    HPDF_SetEncryptionMode(pdfDoc, HPDF_ENCRYPT_R2, 5U);
+    __haruppCheck(HPDF_SetEncryptionMode(pdfDoc, HPDF_ENCRYPT_R2, 5U));
 }
 
 void Document::setR3EncryptMode(unsigned int keyLength) {
     if (keyLength == 0U) throw InvalidR3EncryptionKeyLengthException(); // Disallow 0U value for clarity
-    HPDF_SetEncryptionMode(pdfDoc, HPDF_ENCRYPT_R3, keyLength);
+    __haruppCheck(HPDF_SetEncryptionMode(pdfDoc, HPDF_ENCRYPT_R3, keyLength));
 }
 
 void Document::setCompressionMode(const CompressionMode& mode) {
-    HPDF_SetCompressionMode(pdfDoc, mode.value);
-}
-
-void Document::operator=(const Document& newDoc) {
-    close();
-    pdfDoc = newDoc.pdfDoc;
+    __haruppCheck(HPDF_SetCompressionMode(pdfDoc, mode.value));
 }
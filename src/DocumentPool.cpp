@@ -0,0 +1,151 @@
+#include "../include/DocumentPool.hpp"
+#include "../include/Exception.hpp"
+#include "errno.h"
+#include "fstream"
+#include "iterator"
+using namespace pdf;
+using namespace pdf::excepts;
+
+
+/****************************** HELPERS ******************************/
+static std::vector<unsigned char> __readFile(const std::string& fileName) {
+    std::ifstream file(fileName, std::ios::binary);
+    if (!file) throw FileOpeningException(errno);
+    return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+
+/******************** POOLED DOCUMENT ********************/
+
+PooledDocument::PooledDocument(DocumentPool* pool, std::unique_ptr<Document> document, std::vector<std::pair<std::string, Image>> images) noexcept:
+    pool(pool), document(std::move(document)), images(std::move(images)) {}
+
+PooledDocument::~PooledDocument() {
+    release();
+}
+
+PooledDocument::PooledDocument(PooledDocument&& other) noexcept:
+    pool(other.pool), document(std::move(other.document)), images(std::move(other.images)) {
+    other.pool = nullptr;
+}
+
+PooledDocument& PooledDocument::operator=(PooledDocument&& other) {
+    if (this != &other) {
+        release();
+        pool = other.pool;
+        document = std::move(other.document);
+        images = std::move(other.images);
+        other.pool = nullptr;
+    }
+    return *this;
+}
+
+Document& PooledDocument::getDocument() const noexcept {
+    return *document;
+}
+
+Document* PooledDocument::operator->() const noexcept {
+    return document.get();
+}
+
+std::optional<Image> PooledDocument::getImage(const std::string& key) const {
+    for (const std::pair<std::string, Image>& image: images)
+        if (image.first == key) return image.second;
+    return std::nullopt;
+}
+
+void PooledDocument::release() {
+    images.clear();
+    if (pool != nullptr && document != nullptr) pool->__recycle(std::move(document));
+    document.reset();
+    pool = nullptr;
+}
+
+bool PooledDocument::isEmpty() const noexcept {
+    return document == nullptr;
+}
+
+
+/******************** DOCUMENT POOL ********************/
+
+DocumentPool::DocumentPool(Initializer onCreate, Initializer onAcquire, std::size_t maxIdleDocuments):
+    onCreate(std::move(onCreate)), onAcquire(std::move(onAcquire)), maxIdleDocuments(maxIdleDocuments) {}
+
+void DocumentPool::addFont(const std::string& fontName, const std::string& encodingName) {
+    std::lock_guard<std::mutex> lock(mutex);
+    fonts.emplace_back(fontName, encodingName);
+}
+
+void DocumentPool::addPNGImage(const std::string& key, const std::string& fileName) {
+    std::vector<unsigned char> bytes = __readFile(fileName);
+    std::lock_guard<std::mutex> lock(mutex);
+    imageSources.push_back(std::make_shared<const ImageSource>(ImageSource{key, std::move(bytes), true}));
+}
+
+void DocumentPool::addJPEGImage(const std::string& key, const std::string& fileName) {
+    std::vector<unsigned char> bytes = __readFile(fileName);
+    std::lock_guard<std::mutex> lock(mutex);
+    imageSources.push_back(std::make_shared<const ImageSource>(ImageSource{key, std::move(bytes), false}));
+}
+
+PooledDocument DocumentPool::acquire() {
+    std::unique_ptr<Document> document;
+    std::vector<std::pair<std::string, std::string>> fonts;
+    std::vector<std::shared_ptr<const ImageSource>> imageSources;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!idleDocuments.empty()) {
+            document = std::move(idleDocuments.back());
+            idleDocuments.pop_back();
+        }
+        fonts = this->fonts;
+        imageSources = this->imageSources;
+    }
+
+    // Only new documents go through the expensive setup
+    if (document == nullptr) {
+        document = std::make_unique<Document>();
+        document->open();
+        if (onCreate) onCreate(*document);
+    }
+    if (onAcquire) onAcquire(*document);
+
+    // Font definitions and encodings are already there, getting the fonts is cheap
+    for (const std::pair<std::string, std::string>& font: fonts)
+        document->getFont(font.first, font.second);
+
+    std::vector<std::pair<std::string, Image>> images;
+    images.reserve(imageSources.size());
+    for (const std::shared_ptr<const ImageSource>& source: imageSources) {
+        if (source->isPNG) images.emplace_back(source->key, document->loadPNGImageFromMemory(source->bytes));
+        else images.emplace_back(source->key, document->loadJPEGImageFromMemory(source->bytes));
+    }
+    return PooledDocument(this, std::move(document), std::move(images));
+}
+
+void DocumentPool::__recycle(std::unique_ptr<Document> document) noexcept {
+    // A document in an unknown state is not worth keeping
+    if (!document->isOpen() || document->isStreaming()) return;
+    try {
+        document->resetErrorCode();
+        document->newDocument();
+    } catch (...) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (idleDocuments.size() < maxIdleDocuments) idleDocuments.push_back(std::move(document));
+}
+
+std::size_t DocumentPool::getIdleCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return idleDocuments.size();
+}
+
+void DocumentPool::clear() {
+    std::vector<std::unique_ptr<Document>> documents;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        documents.swap(idleDocuments);
+    }
+}
@@ -1,4 +1,5 @@
 #include "../include/Encoder.hpp"
+#include "ErrorHandler.hpp"
 #include "hpdf.h"
 using namespace pdf;
 
@@ -10,7 +11,7 @@ bool Encoder::isEmpty() const noexcept {
 }
 
 enums::EncoderType Encoder::getType() const {
-    switch (HPDF_Encoder_GetType(__innerContent)) {
+    switch (__haruppCheck(HPDF_Encoder_GetType(__innerContent))) {
         case HPDF_ENCODER_TYPE_SINGLE_BYTE: return enums::EncoderType::SINGLE_BYTE;
         case HPDF_ENCODER_TYPE_DOUBLE_BYTE: return enums::EncoderType::DOUBLE_BYTE;
         case HPDF_ENCODER_TYPE_UNINITIALIZED: return enums::EncoderType::UNINITIALIZED;
@@ -19,7 +20,7 @@ enums::EncoderType Encoder::getType() const {
 }
 
 enums::ByteType Encoder::getByteType(const std::string& text, unsigned int index) const {
-    switch (HPDF_Encoder_GetByteType(__innerContent, text.c_str(), index)) {
+    switch (__haruppCheck(HPDF_Encoder_GetByteType(__innerContent, text.c_str(), index))) {
         case HPDF_BYTE_TYPE_SINGLE: return enums::ByteType::SINGLE;
         case HPDF_BYTE_TYPE_LEAD: return enums::ByteType::LEAD;
         case HPDF_BYTE_TYPE_TRAIL: return enums::ByteType::TRAIL;
@@ -28,11 +29,11 @@ enums::ByteType Encoder::getByteType(const std::string& text, unsigned int index
 }
 
 unsigned short Encoder::getUnicode(unsigned short code) const {
-    return HPDF_Encoder_GetUnicode(__innerContent, code);
+    return __haruppCheck(HPDF_Encoder_GetUnicode(__innerContent, code));
 }
 
 enums::WritingMode Encoder::getWritingMode() const {
-    switch (HPDF_Encoder_GetWritingMode(__innerContent)) {
+    switch (__haruppCheck(HPDF_Encoder_GetWritingMode(__innerContent))) {
         case HPDF_WMODE_HORIZONTAL: return enums::WritingMode::HORIZONTAL;
         case HPDF_WMODE_VERTICAL: return enums::WritingMode::VERTICAL;
         default: return enums::WritingMode::HORIZONTAL;
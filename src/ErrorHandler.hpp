@@ -0,0 +1,37 @@
+#ifndef __HARUPP_ERRORHANDLER_HPP__
+#define __HARUPP_ERRORHANDLER_HPP__
+#include "../include/ErrorPolicy.hpp"
+
+// Internal header: error plumbing shared by the wrapper sources, not part of the public API.
+
+// First error reported by LibHaru during the current call, checked once the call has returned. It is shared by every
+// document of the thread: each LibHaru call able to report an error must be checked right away, so that nothing is left
+// pending for a later call. Errors raised by the wrapper itself and documents being opened clear it beforehand.
+struct __HaruppPendingError {
+    unsigned long errorNo = 0U;
+    unsigned long detailNo = 0U;
+    unsigned long quota = 0U;
+};
+
+inline thread_local __HaruppPendingError __haruppPendingError;
+
+// Error handler given to LibHaru, it never throws
+void __haruppErrorHandler(unsigned long errorNo, unsigned long detailNo, void* userData);
+
+// Clears the pending error and throws the matching exception
+[[noreturn]] void __haruppRaisePendingError();
+
+inline void __haruppClearError() noexcept {
+    __haruppPendingError = __HaruppPendingError();
+}
+
+// Wraps every LibHaru call: checks the pending error once the call has returned
+template<typename T>
+inline T __haruppCheck(T value) {
+#if __HARUPP_ERROR_POLICY == __HARUPP_ERROR_POLICY_THROW
+    if (__haruppPendingError.errorNo != 0U) __haruppRaisePendingError();
+#endif
+    return value;
+}
+
+#endif // __HARUPP_ERRORHANDLER_HPP__
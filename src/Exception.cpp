@@ -142,6 +142,16 @@ MemoryAllocationFailedException::MemoryAllocationFailedException() noexcept: Exc
     0x1015
 ) {}
 
+MemoryAllocationFailedException::MemoryAllocationFailedException(const char* className, const char* errorMessage, unsigned long errorCode, unsigned long detailCode) noexcept:
+    Exception(className, errorMessage, errorCode, detailCode) {}
+
+MemoryQuotaExceededException::MemoryQuotaExceededException(unsigned long quota) noexcept: MemoryAllocationFailedException(
+    "MemoryQuotaExceededException",
+    "The document memory quota has been exceeded.",
+    0x1015,
+    quota
+) {}
+
 FileIOException::FileIOException(unsigned long detailCode) noexcept: FileException(
     "FileIOException",
     "File processing failed.",
@@ -406,6 +416,24 @@ InvalidPageLayoutException::InvalidPageLayoutException() noexcept: PageException
     0x1069
 ) {}
 
+InvalidStreamingStateException::InvalidStreamingStateException() noexcept: DocumentException(
+    "InvalidStreamingStateException",
+    "The document streaming state does not allow this operation.",
+    0x2001
+) {}
+
+MemoryAccountingUnavailableException::MemoryAccountingUnavailableException() noexcept: DocumentException(
+    "MemoryAccountingUnavailableException",
+    "Memory accounting is not available for this document.",
+    0x2002
+) {}
+
+ExpiredHandleException::ExpiredHandleException() noexcept: DocumentException(
+    "ExpiredHandleException",
+    "The object belongs to a document that has been closed or revoked.",
+    0x2003
+) {}
+
 UndefinedException::UndefinedException(unsigned long errorCode, unsigned long detailCode) noexcept: Exception(
     "UndefinedException",
     "Error code is not valid.",
@@ -1,22 +1,23 @@
 #include "../include/Font.hpp"
+#include "ErrorHandler.hpp"
 #include "hpdf.h"
 using namespace pdf;
 
 
-Font::Font(_HPDF_Dict_Rec* content) noexcept: ContentStream(content) {}
+Font::Font(_HPDF_Dict_Rec* content, const std::atomic<unsigned int>* generation) noexcept: ContentStream(content, generation) {}
 
 std::string Font::getName() const {
-    const char* value = HPDF_Font_GetFontName(__innerContent);
+    const char* value = __haruppCheck(HPDF_Font_GetFontName(__content()));
     return (value == nullptr)? std::string(): value;
 }
 
 std::string Font::getEncodingName() const {
-    const char* value = HPDF_Font_GetEncodingName(__innerContent);
+    const char* value = __haruppCheck(HPDF_Font_GetEncodingName(__content()));
     return (value == nullptr)? std::string(): value;
 }
 
 int Font::getUnicodeWidth(unsigned short character) const {
-    return HPDF_Font_GetUnicodeWidth(__innerContent, character);
+    return __haruppCheck(HPDF_Font_GetUnicodeWidth(__content(), character));
 }
 
 float Font::getActualWidth(unsigned short character, float fontSize) const {
@@ -24,28 +25,28 @@ float Font::getActualWidth(unsigned short character, float fontSize) const {
 }
 
 int Font::getVerticalAscent() const {
-    return HPDF_Font_GetAscent(__innerContent);
+    return __haruppCheck(HPDF_Font_GetAscent(__content()));
 }
 
 int Font::getVerticalDescent() const {
-    return HPDF_Font_GetDescent(__innerContent);
+    return __haruppCheck(HPDF_Font_GetDescent(__content()));
 }
 
 unsigned int Font::getDistanceToLower() const {
-    return HPDF_Font_GetXHeight(__innerContent);
+    return __haruppCheck(HPDF_Font_GetXHeight(__content()));
 }
 
 unsigned int Font::getDistanceToUpper() const {
-    return HPDF_Font_GetCapHeight(__innerContent);
+    return __haruppCheck(HPDF_Font_GetCapHeight(__content()));
 }
 
 Box Font::getBoundingBox() const {
-    HPDF_Box box = HPDF_Font_GetBBox(__innerContent);
+    HPDF_Box box = __haruppCheck(HPDF_Font_GetBBox(__content()));
     return Box(box.left, box.bottom, box.right, box.top);
 }
 
 TextWidth Font::__getTextWidth(const unsigned char* bytes, unsigned int length) const {
-    HPDF_TextWidth textWidth = HPDF_Font_TextWidth(__innerContent, bytes, length);
+    HPDF_TextWidth textWidth = __haruppCheck(HPDF_Font_TextWidth(__content(), bytes, length));
     return TextWidth(textWidth.numchars, textWidth.width, textWidth.numspace);
 }
 
@@ -64,13 +65,13 @@ std::pair<unsigned int, float> Font::__measureText(
     bool wordwrap
 ) const {
     float realWidth;
-    unsigned int value = HPDF_Font_MeasureText(
-        __innerContent,
+    unsigned int value = __haruppCheck(HPDF_Font_MeasureText(
+        __content(),
         text, len,
         width, fontSize,
         charSpace, wordSpace,
         wordwrap, &realWidth
-    );
+    ));
     return {value, realWidth};
 }
 
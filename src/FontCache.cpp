@@ -0,0 +1,74 @@
+#include "../include/FontCache.hpp"
+#include "../include/Exception.hpp"
+#include "errno.h"
+#include "filesystem"
+#include "fstream"
+#include "mutex"
+#include "unordered_map"
+using namespace pdf;
+
+
+/****************************** HELPERS ******************************/
+struct __HaruppFontFile {
+    std::shared_ptr<const std::vector<unsigned char>> bytes;
+    std::filesystem::file_time_type time;
+};
+
+static std::mutex __haruppFontCacheMutex;
+static std::unordered_map<std::string, __HaruppFontFile> __haruppFontCache;
+
+static std::shared_ptr<const std::vector<unsigned char>> __haruppReadFontFile(const std::string& fileName, std::uintmax_t size) {
+    std::ifstream file(fileName, std::ios::binary);
+    if (!file) return nullptr;
+    std::shared_ptr<std::vector<unsigned char>> bytes = std::make_shared<std::vector<unsigned char>>((std::size_t) size);
+    if (!file.read((char*) bytes->data(), (std::streamsize) size)) return nullptr;
+    return bytes;
+}
+
+
+/******************** FONT CACHE ********************/
+
+std::shared_ptr<const std::vector<unsigned char>> FontCache::__acquire(const std::string& fileName) {
+    std::error_code error;
+    std::filesystem::file_time_type time = std::filesystem::last_write_time(fileName, error);
+    if (error) return nullptr;
+    std::uintmax_t size = std::filesystem::file_size(fileName, error);
+    if (error) return nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(__haruppFontCacheMutex);
+        std::unordered_map<std::string, __HaruppFontFile>::const_iterator it = __haruppFontCache.find(fileName);
+        if (it != __haruppFontCache.end() && it->second.time == time && it->second.bytes->size() == size) return it->second.bytes;
+    }
+
+    // Read outside the lock, documents using a previous version of the file keep their own reference
+    std::shared_ptr<const std::vector<unsigned char>> bytes = __haruppReadFontFile(fileName, size);
+    if (bytes == nullptr) return nullptr;
+    std::lock_guard<std::mutex> lock(__haruppFontCacheMutex);
+    __haruppFontCache[fileName] = {bytes, time};
+    return bytes;
+}
+
+void FontCache::preload(const std::string& fileName) {
+    if (__acquire(fileName) == nullptr) throw excepts::FileOpeningException(errno);
+}
+
+std::size_t FontCache::getEntryCount() {
+    std::lock_guard<std::mutex> lock(__haruppFontCacheMutex);
+    return __haruppFontCache.size();
+}
+
+std::size_t FontCache::getSize() {
+    std::lock_guard<std::mutex> lock(__haruppFontCacheMutex);
+    std::size_t size = 0U;
+    for (const std::pair<const std::string, __HaruppFontFile>& entry: __haruppFontCache) size += entry.second.bytes->size();
+    return size;
+}
+
+void FontCache::trim() {
+    std::lock_guard<std::mutex> lock(__haruppFontCacheMutex);
+    for (std::unordered_map<std::string, __HaruppFontFile>::iterator it = __haruppFontCache.begin(); it != __haruppFontCache.end();) {
+        if (it->second.bytes.use_count() == 1) it = __haruppFontCache.erase(it);
+        else ++it;
+    }
+}
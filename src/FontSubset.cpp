@@ -0,0 +1,451 @@
+#include "FontSubset.hpp"
+#include "algorithm"
+#include "cstdint"
+#include "cstring"
+#include "utility"
+
+
+/****************************** HELPERS ******************************/
+// TrueType data is big-endian
+static std::uint16_t __haruppReadU16(const unsigned char* p) noexcept {
+    return (std::uint16_t) ((p[0] << 8) | p[1]);
+}
+
+static std::int16_t __haruppReadS16(const unsigned char* p) noexcept {
+    return (std::int16_t) __haruppReadU16(p);
+}
+
+static std::uint32_t __haruppReadU32(const unsigned char* p) noexcept {
+    return ((std::uint32_t) p[0] << 24) | ((std::uint32_t) p[1] << 16) | ((std::uint32_t) p[2] << 8) | (std::uint32_t) p[3];
+}
+
+static void __haruppWriteU16(unsigned char* p, std::uint16_t value) noexcept {
+    p[0] = (unsigned char) (value >> 8);
+    p[1] = (unsigned char) value;
+}
+
+static void __haruppWriteU32(unsigned char* p, std::uint32_t value) noexcept {
+    p[0] = (unsigned char) (value >> 24);
+    p[1] = (unsigned char) (value >> 16);
+    p[2] = (unsigned char) (value >> 8);
+    p[3] = (unsigned char) value;
+}
+
+static void __haruppPushU16(std::vector<unsigned char>& out, std::uint16_t value) {
+    out.push_back((unsigned char) (value >> 8));
+    out.push_back((unsigned char) value);
+}
+
+static void __haruppPushU32(std::vector<unsigned char>& out, std::uint32_t value) {
+    __haruppPushU16(out, (std::uint16_t) (value >> 16));
+    __haruppPushU16(out, (std::uint16_t) value);
+}
+
+static constexpr std::uint32_t __haruppTag(const char (&tag)[5]) noexcept {
+    return ((std::uint32_t) (unsigned char) tag[0] << 24) | ((std::uint32_t) (unsigned char) tag[1] << 16) |
+        ((std::uint32_t) (unsigned char) tag[2] << 8) | (std::uint32_t) (unsigned char) tag[3];
+}
+
+static std::uint32_t __haruppChecksum(const unsigned char* data, std::size_t length) noexcept {
+    std::uint32_t sum = 0U;
+    std::size_t i = 0U;
+    for (; i + 4U <= length; i += 4U) sum += __haruppReadU32(data + i);
+    if (i < length) {
+        unsigned char tail[4] = {0U, 0U, 0U, 0U};
+        std::memcpy(tail, data + i, length - i);
+        sum += __haruppReadU32(tail);
+    }
+    return sum;
+}
+
+struct __HaruppTable {
+    std::uint32_t tag;
+    const unsigned char* data;
+    std::uint32_t length;
+};
+
+struct __HaruppOutTable {
+    std::uint32_t tag;
+    std::vector<unsigned char> data;
+};
+
+// Composite glyph flags
+#define __HARUPP_ARG_1_AND_2_ARE_WORDS      0x0001
+#define __HARUPP_WE_HAVE_A_SCALE            0x0008
+#define __HARUPP_MORE_COMPONENTS            0x0020
+#define __HARUPP_WE_HAVE_AN_X_AND_Y_SCALE   0x0040
+#define __HARUPP_WE_HAVE_A_TWO_BY_TWO       0x0080
+
+// Calls `visit` with the offset of every component glyph index of a composite glyph, returns `false` if it is malformed
+template<typename Visitor>
+static bool __haruppForEachComponent(const unsigned char* glyph, std::size_t length, Visitor&& visit) {
+    if (length < 10U || __haruppReadS16(glyph) >= 0) return true;
+    std::size_t offset = 10U;
+    while (true) {
+        if (offset + 4U > length) return false;
+        std::uint16_t flags = __haruppReadU16(glyph + offset);
+        visit(offset + 2U);
+        offset += (flags & __HARUPP_ARG_1_AND_2_ARE_WORDS)? 8U: 6U;
+        if (flags & __HARUPP_WE_HAVE_A_SCALE) offset += 2U;
+        else if (flags & __HARUPP_WE_HAVE_AN_X_AND_Y_SCALE) offset += 4U;
+        else if (flags & __HARUPP_WE_HAVE_A_TWO_BY_TWO) offset += 8U;
+        if (!(flags & __HARUPP_MORE_COMPONENTS)) return offset <= length;
+    }
+}
+
+// Reads the code to glyph pairs of a format 4 or 12 cmap subtable
+static bool __haruppReadCmap(const unsigned char* table, std::size_t length, std::uint16_t glyphCount,
+    std::vector<std::pair<std::uint32_t, std::uint16_t>>& pairs) {
+    if (length < 4U) return false;
+    std::uint16_t format = __haruppReadU16(table);
+
+    if (format == 4U) {
+        if (length < 14U) return false;
+        std::size_t segCountX2 = __haruppReadU16(table + 6);
+        if (16U + 4U * segCountX2 > length) return false;
+        const unsigned char* endCodes = table + 14;
+        const unsigned char* startCodes = table + 16 + segCountX2;
+        const unsigned char* idDeltas = table + 16 + 2U * segCountX2;
+        const unsigned char* idRangeOffsets = table + 16 + 3U * segCountX2;
+        for (std::size_t s = 0U; s < segCountX2 / 2U; ++s) {
+            std::uint32_t start = __haruppReadU16(startCodes + 2U * s);
+            std::uint32_t end = __haruppReadU16(endCodes + 2U * s);
+            std::uint16_t delta = __haruppReadU16(idDeltas + 2U * s);
+            std::uint16_t rangeOffset = __haruppReadU16(idRangeOffsets + 2U * s);
+            for (std::uint32_t code = start; code <= end && code != 0xFFFFU; ++code) {
+                std::uint16_t glyph;
+                if (rangeOffset == 0U) glyph = (std::uint16_t) (code + delta);
+                else {
+                    std::size_t address = (std::size_t) (idRangeOffsets + 2U * s - table) + rangeOffset + 2U * (code - start);
+                    if (address + 2U > length) return false;
+                    glyph = __haruppReadU16(table + address);
+                    if (glyph != 0U) glyph = (std::uint16_t) (glyph + delta);
+                }
+                if (glyph != 0U && glyph < glyphCount) pairs.emplace_back(code, glyph);
+            }
+        }
+        return true;
+    }
+
+    if (format == 12U) {
+        if (length < 16U) return false;
+        std::uint32_t groupCount = __haruppReadU32(table + 12);
+        if (16U + 12U * (std::size_t) groupCount > length) return false;
+        for (std::uint32_t g = 0U; g < groupCount; ++g) {
+            const unsigned char* group = table + 16 + 12U * g;
+            std::uint32_t start = __haruppReadU32(group);
+            std::uint32_t end = __haruppReadU32(group + 4);
+            std::uint32_t firstGlyph = __haruppReadU32(group + 8);
+            if (firstGlyph >= glyphCount || end < start) continue;
+            end = std::min<std::uint32_t>(end, start + (glyphCount - 1U - firstGlyph));
+            for (std::uint32_t code = start; code <= end; ++code) {
+                std::uint32_t glyph = firstGlyph + (code - start);
+                if (glyph != 0U) pairs.emplace_back(code, (std::uint16_t) glyph);
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+// Writes a format 4 subtable, merging runs of consecutive codes mapped to consecutive glyphs
+static bool __haruppWriteCmap4(const std::vector<std::pair<std::uint32_t, std::uint16_t>>& pairs, std::vector<unsigned char>& out) {
+    std::vector<std::pair<std::uint16_t, std::uint16_t>> segments;
+    std::vector<std::uint16_t> deltas;
+    for (const std::pair<std::uint32_t, std::uint16_t>& pair: pairs) {
+        if (pair.first >= 0xFFFFU) break;
+        std::uint16_t delta = (std::uint16_t) (pair.second - pair.first);
+        if (!segments.empty() && segments.back().second + 1U == pair.first && deltas.back() == delta) segments.back().second = (std::uint16_t) pair.first;
+        else {
+            segments.emplace_back((std::uint16_t) pair.first, (std::uint16_t) pair.first);
+            deltas.push_back(delta);
+        }
+    }
+    segments.emplace_back(0xFFFFU, 0xFFFFU);
+    deltas.push_back(1U);
+
+    std::size_t segCount = segments.size();
+    std::size_t length = 16U + 8U * segCount;
+    if (length > 0xFFFFU) return false;
+    std::uint16_t searchRange = 2U;
+    std::uint16_t entrySelector = 0U;
+    while (searchRange * 2U <= 2U * segCount) {
+        searchRange *= 2U;
+        ++entrySelector;
+    }
+
+    __haruppPushU16(out, 4U);
+    __haruppPushU16(out, (std::uint16_t) length);
+    __haruppPushU16(out, 0U);
+    __haruppPushU16(out, (std::uint16_t) (2U * segCount));
+    __haruppPushU16(out, searchRange);
+    __haruppPushU16(out, entrySelector);
+    __haruppPushU16(out, (std::uint16_t) (2U * segCount - searchRange));
+    for (const std::pair<std::uint16_t, std::uint16_t>& segment: segments) __haruppPushU16(out, segment.second);
+    __haruppPushU16(out, 0U);
+    for (const std::pair<std::uint16_t, std::uint16_t>& segment: segments) __haruppPushU16(out, segment.first);
+    for (std::uint16_t delta: deltas) __haruppPushU16(out, delta);
+    for (std::size_t i = 0U; i < segCount; ++i) __haruppPushU16(out, 0U);
+    return true;
+}
+
+static void __haruppWriteCmap12(const std::vector<std::pair<std::uint32_t, std::uint16_t>>& pairs, std::vector<unsigned char>& out) {
+    std::vector<std::uint32_t> groups;
+    for (const std::pair<std::uint32_t, std::uint16_t>& pair: pairs) {
+        std::size_t last = groups.size();
+        if (last > 0U && groups[last - 2U] + 1U == pair.first && groups[last - 1U] + (pair.first - groups[last - 3U]) == pair.second)
+            groups[last - 2U] = pair.first;
+        else {
+            groups.push_back(pair.first);
+            groups.push_back(pair.first);
+            groups.push_back(pair.second);
+        }
+    }
+
+    __haruppPushU16(out, 12U);
+    __haruppPushU16(out, 0U);
+    __haruppPushU32(out, (std::uint32_t) (16U + 4U * groups.size()));
+    __haruppPushU32(out, 0U);
+    __haruppPushU32(out, (std::uint32_t) (groups.size() / 3U));
+    for (std::uint32_t value: groups) __haruppPushU32(out, value);
+}
+
+static bool __haruppBuildCmap(const __HaruppTable& cmap, std::uint16_t glyphCount, const std::vector<int>& glyphMap, std::vector<unsigned char>& out) {
+    if (cmap.length < 4U) return false;
+    std::uint16_t subtableCount = __haruppReadU16(cmap.data + 2);
+    if (4U + 8U * (std::size_t) subtableCount > cmap.length) return false;
+
+    // Full Unicode first, then BMP Unicode, then symbol fonts
+    const unsigned char* best = nullptr;
+    int bestRank = 0;
+    bool symbolic = false;
+    for (std::uint16_t i = 0U; i < subtableCount; ++i) {
+        const unsigned char* record = cmap.data + 4 + 8U * i;
+        std::uint16_t platform = __haruppReadU16(record);
+        std::uint16_t encoding = __haruppReadU16(record + 2);
+        std::uint32_t offset = __haruppReadU32(record + 4);
+        if (offset + 4U > cmap.length) continue;
+        std::uint16_t format = __haruppReadU16(cmap.data + offset);
+        int rank = 0;
+        if (platform == 3U && encoding == 10U && format == 12U) rank = 5;
+        else if (platform == 0U && format == 12U) rank = 4;
+        else if (platform == 3U && encoding == 1U && format == 4U) rank = 3;
+        else if (platform == 0U && format == 4U) rank = 2;
+        else if (platform == 3U && encoding == 0U && format == 4U) rank = 1;
+        if (rank > bestRank) {
+            best = cmap.data + offset;
+            bestRank = rank;
+            symbolic = (rank == 1);
+        }
+    }
+    if (best == nullptr) return false;
+
+    std::vector<std::pair<std::uint32_t, std::uint16_t>> pairs;
+    if (!__haruppReadCmap(best, cmap.length - (std::size_t) (best - cmap.data), glyphCount, pairs)) return false;
+
+    // Keep the codes of the remaining glyphs only
+    std::vector<std::pair<std::uint32_t, std::uint16_t>> kept;
+    kept.reserve(pairs.size());
+    for (const std::pair<std::uint32_t, std::uint16_t>& pair: pairs)
+        if (glyphMap[pair.second] > 0) kept.emplace_back(pair.first, (std::uint16_t) glyphMap[pair.second]);
+    std::sort(kept.begin(), kept.end());
+    kept.erase(std::unique(kept.begin(), kept.end(), [](const std::pair<std::uint32_t, std::uint16_t>& a, const std::pair<std::uint32_t, std::uint16_t>& b) {
+        return a.first == b.first;
+    }), kept.end());
+    bool needsFull = !kept.empty() && kept.back().first > 0xFFFFU;
+
+    std::vector<unsigned char> format4;
+    if (!__haruppWriteCmap4(kept, format4)) return false;
+    std::vector<unsigned char> format12;
+    if (needsFull) __haruppWriteCmap12(kept, format12);
+
+    __haruppPushU16(out, 0U);
+    __haruppPushU16(out, needsFull? 2U: 1U);
+    std::uint32_t offset = needsFull? 20U: 12U;
+    __haruppPushU16(out, 3U);
+    __haruppPushU16(out, symbolic? 0U: 1U);
+    __haruppPushU32(out, offset);
+    if (needsFull) {
+        __haruppPushU16(out, 3U);
+        __haruppPushU16(out, 10U);
+        __haruppPushU32(out, offset + (std::uint32_t) format4.size());
+    }
+    out.insert(out.end(), format4.begin(), format4.end());
+    out.insert(out.end(), format12.begin(), format12.end());
+    return true;
+}
+
+
+/******************** SUBSETTING ********************/
+
+bool __haruppSubsetTrueType(
+    const unsigned char* font, std::size_t size, const std::vector<bool>& used,
+    std::vector<unsigned char>& subset, std::vector<int>& glyphMap
+) {
+    // Table directory
+    if (font == nullptr || size < 12U) return false;
+    std::uint16_t tableCount = __haruppReadU16(font + 4);
+    if (12U + 16U * (std::size_t) tableCount > size) return false;
+    std::vector<__HaruppTable> tables;
+    for (std::uint16_t i = 0U; i < tableCount; ++i) {
+        const unsigned char* record = font + 12 + 16U * i;
+        std::uint32_t offset = __haruppReadU32(record + 8);
+        std::uint32_t length = __haruppReadU32(record + 12);
+        if ((std::size_t) offset + length > size) return false;
+        tables.push_back({__haruppReadU32(record), font + offset, length});
+    }
+    auto find = [&tables](std::uint32_t tag) -> const __HaruppTable* {
+        for (const __HaruppTable& table: tables) if (table.tag == tag) return &table;
+        return nullptr;
+    };
+    const __HaruppTable* head = find(__haruppTag("head"));
+    const __HaruppTable* hhea = find(__haruppTag("hhea"));
+    const __HaruppTable* maxp = find(__haruppTag("maxp"));
+    const __HaruppTable* loca = find(__haruppTag("loca"));
+    const __HaruppTable* glyf = find(__haruppTag("glyf"));
+    const __HaruppTable* hmtx = find(__haruppTag("hmtx"));
+    const __HaruppTable* cmap = find(__haruppTag("cmap"));
+    if (!head || !hhea || !maxp || !loca || !glyf || !hmtx || !cmap) return false;
+    if (head->length < 54U || hhea->length < 36U || maxp->length < 6U) return false;
+
+    bool longOffsets = __haruppReadS16(head->data + 50) != 0;
+    std::uint16_t glyphCount = __haruppReadU16(maxp->data + 4);
+    std::uint16_t metricCount = __haruppReadU16(hhea->data + 34);
+    if (glyphCount == 0U || metricCount == 0U || metricCount > glyphCount) return false;
+    if ((std::size_t) (glyphCount + 1U) * (longOffsets? 4U: 2U) > loca->length) return false;
+    if (4U * (std::size_t) metricCount + 2U * (std::size_t) (glyphCount - metricCount) > hmtx->length) return false;
+
+    auto glyphOffset = [&](std::size_t glyph) -> std::size_t {
+        return longOffsets? __haruppReadU32(loca->data + 4U * glyph): 2U * (std::size_t) __haruppReadU16(loca->data + 2U * glyph);
+    };
+    for (std::size_t i = 0U; i < glyphCount; ++i)
+        if (glyphOffset(i) > glyphOffset(i + 1U) || glyphOffset(i + 1U) > glyf->length) return false;
+
+    // Kept glyphs: .notdef, used glyphs, and the components of kept composite glyphs
+    std::vector<bool> keep(glyphCount, false);
+    std::vector<std::uint16_t> pending;
+    keep[0] = true;
+    pending.push_back(0U);
+    for (std::size_t i = 1U; i < glyphCount && i < used.size(); ++i) {
+        if (!used[i]) continue;
+        keep[i] = true;
+        pending.push_back((std::uint16_t) i);
+    }
+    while (!pending.empty()) {
+        std::uint16_t glyph = pending.back();
+        pending.pop_back();
+        const unsigned char* data = glyf->data + glyphOffset(glyph);
+        bool valid = __haruppForEachComponent(data, glyphOffset(glyph + 1U) - glyphOffset(glyph), [&](std::size_t offset) {
+            std::uint16_t component = __haruppReadU16(data + offset);
+            if (component < glyphCount && !keep[component]) {
+                keep[component] = true;
+                pending.push_back(component);
+            }
+        });
+        if (!valid) return false;
+    }
+
+    std::vector<int> newMap(glyphCount, -1);
+    std::vector<std::uint16_t> oldGlyphs;
+    for (std::uint16_t i = 0U; i < glyphCount; ++i) {
+        if (!keep[i]) continue;
+        newMap[i] = (int) oldGlyphs.size();
+        oldGlyphs.push_back(i);
+    }
+    std::uint16_t newCount = (std::uint16_t) oldGlyphs.size();
+
+    // glyf and loca, with long offsets and renumbered components
+    std::vector<unsigned char> newGlyf;
+    std::vector<unsigned char> newLoca;
+    newLoca.reserve(4U * (newCount + 1U));
+    for (std::uint16_t glyph: oldGlyphs) {
+        __haruppPushU32(newLoca, (std::uint32_t) newGlyf.size());
+        std::size_t start = newGlyf.size();
+        std::size_t length = glyphOffset(glyph + 1U) - glyphOffset(glyph);
+        newGlyf.insert(newGlyf.end(), glyf->data + glyphOffset(glyph), glyf->data + glyphOffset(glyph) + length);
+        __haruppForEachComponent(glyf->data + glyphOffset(glyph), length, [&](std::size_t offset) {
+            std::uint16_t component = __haruppReadU16(newGlyf.data() + start + offset);
+            __haruppWriteU16(newGlyf.data() + start + offset, (std::uint16_t) ((component < glyphCount)? newMap[component]: 0));
+        });
+        while (newGlyf.size() % 4U != 0U) newGlyf.push_back(0U);
+    }
+    __haruppPushU32(newLoca, (std::uint32_t) newGlyf.size());
+
+    // hmtx, one full metric per glyph
+    std::vector<unsigned char> newHmtx;
+    newHmtx.reserve(4U * newCount);
+    std::uint16_t lastAdvance = __haruppReadU16(hmtx->data + 4U * (metricCount - 1U));
+    for (std::uint16_t glyph: oldGlyphs) {
+        if (glyph < metricCount) {
+            __haruppPushU16(newHmtx, __haruppReadU16(hmtx->data + 4U * glyph));
+            __haruppPushU16(newHmtx, __haruppReadU16(hmtx->data + 4U * glyph + 2U));
+        } else {
+            __haruppPushU16(newHmtx, lastAdvance);
+            __haruppPushU16(newHmtx, __haruppReadU16(hmtx->data + 4U * metricCount + 2U * (glyph - metricCount)));
+        }
+    }
+
+    std::vector<unsigned char> newCmap;
+    if (!__haruppBuildCmap(*cmap, glyphCount, newMap, newCmap)) return false;
+
+    // Assemble the tables, sorted by tag. Glyph names, kerning and layout tables refer to old glyph indices, so they go
+    std::vector<__HaruppOutTable> out;
+    for (const __HaruppTable& table: tables) {
+        std::vector<unsigned char> data;
+        if (table.tag == __haruppTag("glyf")) data = std::move(newGlyf);
+        else if (table.tag == __haruppTag("loca")) data = std::move(newLoca);
+        else if (table.tag == __haruppTag("hmtx")) data = std::move(newHmtx);
+        else if (table.tag == __haruppTag("cmap")) data = std::move(newCmap);
+        else if (table.tag == __haruppTag("head")) {
+            data.assign(table.data, table.data + table.length);
+            __haruppWriteU32(data.data() + 8, 0U);
+            __haruppWriteU16(data.data() + 50, 1U);
+        } else if (table.tag == __haruppTag("hhea")) {
+            data.assign(table.data, table.data + table.length);
+            __haruppWriteU16(data.data() + 34, newCount);
+        } else if (table.tag == __haruppTag("maxp")) {
+            data.assign(table.data, table.data + table.length);
+            __haruppWriteU16(data.data() + 4, newCount);
+        } else if (table.tag == __haruppTag("post")) {
+            if (table.length < 32U) continue;
+            data.assign(table.data, table.data + 32);
+            __haruppWriteU32(data.data(), 0x00030000U);
+        } else if (table.tag == __haruppTag("OS/2") || table.tag == __haruppTag("name") || table.tag == __haruppTag("cvt ")
+            || table.tag == __haruppTag("fpgm") || table.tag == __haruppTag("prep")) {
+            data.assign(table.data, table.data + table.length);
+        } else continue;
+        out.push_back({table.tag, std::move(data)});
+    }
+    std::sort(out.begin(), out.end(), [](const __HaruppOutTable& a, const __HaruppOutTable& b) { return a.tag < b.tag; });
+
+    std::uint16_t outCount = (std::uint16_t) out.size();
+    std::uint16_t entrySelector = 0U;
+    while ((2U << entrySelector) <= outCount) ++entrySelector;
+    std::uint16_t searchRange = (std::uint16_t) (16U << entrySelector);
+
+    std::vector<unsigned char> result;
+    __haruppPushU32(result, 0x00010000U);
+    __haruppPushU16(result, outCount);
+    __haruppPushU16(result, searchRange);
+    __haruppPushU16(result, entrySelector);
+    __haruppPushU16(result, (std::uint16_t) (16U * outCount - searchRange));
+    std::size_t offset = 12U + 16U * (std::size_t) outCount;
+    std::size_t headOffset = 0U;
+    for (const __HaruppOutTable& table: out) {
+        __haruppPushU32(result, table.tag);
+        __haruppPushU32(result, __haruppChecksum(table.data.data(), table.data.size()));
+        __haruppPushU32(result, (std::uint32_t) offset);
+        __haruppPushU32(result, (std::uint32_t) table.data.size());
+        if (table.tag == __haruppTag("head")) headOffset = offset;
+        offset += (table.data.size() + 3U) & ~(std::size_t) 3U;
+    }
+    for (const __HaruppOutTable& table: out) {
+        result.insert(result.end(), table.data.begin(), table.data.end());
+        while (result.size() % 4U != 0U) result.push_back(0U);
+    }
+    __haruppWriteU32(result.data() + headOffset + 8U, 0xB1B0AFBAU - __haruppChecksum(result.data(), result.size()));
+
+    subset = std::move(result);
+    glyphMap = std::move(newMap);
+    return true;
+}
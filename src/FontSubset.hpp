@@ -0,0 +1,17 @@
+#ifndef __HARUPP_FONTSUBSET_HPP__
+#define __HARUPP_FONTSUBSET_HPP__
+#include "cstddef"
+#include "vector"
+
+// Internal header: TrueType subsetting used when saving documents, not part of the public API.
+
+// Builds a TrueType font holding only the glyphs flagged in `used`, the glyphs they are made of and `.notdef`, renumbered
+// in their original order. The glyph, loca, hmtx, maxp, cmap and post tables are rebuilt, hinting and naming tables are
+// kept and every other table is dropped. `glyphMap` receives the new index of every original glyph, or `-1` if it was
+// dropped. Returns `false`, leaving both outputs untouched, if the font cannot be subset.
+bool __haruppSubsetTrueType(
+    const unsigned char* font, std::size_t size, const std::vector<bool>& used,
+    std::vector<unsigned char>& subset, std::vector<int>& glyphMap
+);
+
+#endif // __HARUPP_FONTSUBSET_HPP__
@@ -0,0 +1,22 @@
+#include "../include/FormXObject.hpp"
+#include "../include/Page.hpp"
+using namespace pdf;
+
+
+FormXObject::FormXObject(_HPDF_Dict_Rec* content, _HPDF_Dict_Rec* canvas, const Box& boundingBox, const TransposeMatrix& matrix,
+    const std::atomic<unsigned int>* generation, __HaruppPageState* canvasState) noexcept:
+    ContentStream(content, generation), canvas(canvas), canvasState(canvasState), boundingBox(boundingBox), matrix(matrix) {}
+
+Page FormXObject::getCanvas() const {
+    // Checks the generation, the canvas lives as long as the form
+    __content();
+    return Page(canvas, __generation, canvasState);
+}
+
+Box FormXObject::getBoundingBox() const noexcept {
+    return boundingBox;
+}
+
+TransposeMatrix FormXObject::getMatrix() const noexcept {
+    return matrix;
+}
@@ -0,0 +1,41 @@
+#include "GraphicsState.hpp"
+
+
+void __HaruppGState::load(HPDF_GState gState) noexcept {
+    lineWidth = gState->line_width;
+    lineCap = gState->line_cap;
+    lineJoin = gState->line_join;
+    miterLimit = gState->miter_limit;
+    charSpace = gState->char_space;
+    wordSpace = gState->word_space;
+    horizontalScaling = gState->h_scalling;
+    textLeading = gState->text_leading;
+    textRise = gState->text_rise;
+    renderingMode = gState->rendering_mode;
+    font = gState->font;
+    fontSize = gState->font_size;
+    fillColorSpace = gState->cs_fill;
+    strokeColorSpace = gState->cs_stroke;
+    rgbFill = gState->rgb_fill;
+    rgbStroke = gState->rgb_stroke;
+    cmykFill = gState->cmyk_fill;
+    cmykStroke = gState->cmyk_stroke;
+    grayFill = gState->gray_fill;
+    grayStroke = gState->gray_stroke;
+}
+
+__HaruppPageState* __haruppGetPageState(__HaruppGraphicsStates& states, HPDF_Page page, bool inherited) {
+    if (page == nullptr) return nullptr;
+    std::unordered_map<HPDF_Page, __HaruppPageState>::iterator found = states.pages.find(page);
+    if (found != states.pages.end()) return &found->second;
+
+    HPDF_PageAttr attr = (HPDF_PageAttr) page->attr;
+    __HaruppGState current;
+    current.load(attr->gstate);
+    // Only a blank page is known to be in the initial state
+    if (!inherited && HPDF_Stream_Size(attr->stream) == 0U) current.known = __HaruppGState::ALL;
+
+    __HaruppPageState& state = states.pages[page];
+    state.stack.assign((attr->gstate->depth > 0U)? attr->gstate->depth: 1U, current);
+    return &state;
+}
@@ -0,0 +1,71 @@
+#ifndef __HARUPP_GRAPHICSSTATE_HPP__
+#define __HARUPP_GRAPHICSSTATE_HPP__
+#include "hpdf.h"
+#include "unordered_map"
+#include "vector"
+
+// Internal header: graphics state mirror shared by Document and Page, not part of the public API.
+
+// Graphics state parameters mirrored by the wrapper, so that getters do not go through LibHaru and setters can skip
+// operators that would not change anything. Default values are the ones of a new page.
+struct __HaruppGState {
+    // Flags of `known`, one per group of parameters set by a single operator
+    static constexpr unsigned int LINE_WIDTH = 1U << 0U;
+    static constexpr unsigned int LINE_CAP = 1U << 1U;
+    static constexpr unsigned int LINE_JOIN = 1U << 2U;
+    static constexpr unsigned int MITER_LIMIT = 1U << 3U;
+    static constexpr unsigned int CHAR_SPACE = 1U << 4U;
+    static constexpr unsigned int WORD_SPACE = 1U << 5U;
+    static constexpr unsigned int HORIZONTAL_SCALING = 1U << 6U;
+    static constexpr unsigned int TEXT_LEADING = 1U << 7U;
+    static constexpr unsigned int TEXT_RISE = 1U << 8U;
+    static constexpr unsigned int RENDERING_MODE = 1U << 9U;
+    static constexpr unsigned int FONT = 1U << 10U;
+    static constexpr unsigned int FILL_COLOR = 1U << 11U;
+    static constexpr unsigned int STROKE_COLOR = 1U << 12U;
+    static constexpr unsigned int ALL = (1U << 13U) - 1U;
+
+    float lineWidth = 1.f;
+    HPDF_LineCap lineCap = HPDF_BUTT_END;
+    HPDF_LineJoin lineJoin = HPDF_MITER_JOIN;
+    float miterLimit = 10.f;
+    float charSpace = 0.f;
+    float wordSpace = 0.f;
+    float horizontalScaling = 100.f;
+    float textLeading = 0.f;
+    float textRise = 0.f;
+    HPDF_TextRenderingMode renderingMode = HPDF_FILL;
+    HPDF_Font font = nullptr;
+    float fontSize = 0.f;
+    HPDF_ColorSpace fillColorSpace = HPDF_CS_DEVICE_GRAY;
+    HPDF_ColorSpace strokeColorSpace = HPDF_CS_DEVICE_GRAY;
+    HPDF_RGBColor rgbFill = {0.f, 0.f, 0.f};
+    HPDF_RGBColor rgbStroke = {0.f, 0.f, 0.f};
+    HPDF_CMYKColor cmykFill = {0.f, 0.f, 0.f, 0.f};
+    HPDF_CMYKColor cmykStroke = {0.f, 0.f, 0.f, 0.f};
+    float grayFill = 0.f;
+    float grayStroke = 0.f;
+
+    // Parameters whose value is known to be the one in effect at the end of the content stream
+    unsigned int known = 0U;
+
+    // Copies the parameters tracked by LibHaru, leaving `known` untouched
+    void load(HPDF_GState gState) noexcept;
+};
+
+// Graphics state stack of a page or a form canvas, following Page::gSave and Page::gRestore
+struct __HaruppPageState {
+    std::vector<__HaruppGState> stack;
+    unsigned long elidedOperators = 0UL;
+};
+
+// Graphics state stacks of the pages and canvases of a document. Elements never move, so handles keep pointers to them.
+struct __HaruppGraphicsStates {
+    std::unordered_map<HPDF_Page, __HaruppPageState> pages;
+};
+
+// Gets the state of `page`, created from the LibHaru state the first time. Parameters of form canvases start unknown,
+// since forms inherit the graphics state in effect where they are drawn.
+__HaruppPageState* __haruppGetPageState(__HaruppGraphicsStates& states, HPDF_Page page, bool inherited);
+
+#endif // __HARUPP_GRAPHICSSTATE_HPP__
@@ -1,31 +1,32 @@
 #include "../include/Image.hpp"
 #include "../include/Exception.hpp"
+#include "ErrorHandler.hpp"
 #include "hpdf.h"
 #include "string.h"
 using namespace pdf;
 
 
-Image::Image(_HPDF_Dict_Rec* content) noexcept: ContentStream(content) {}
+Image::Image(_HPDF_Dict_Rec* content, const std::atomic<unsigned int>* generation) noexcept: ContentStream(content, generation) {}
 
 Coor2D Image::getSize() const {
-    HPDF_Point point = HPDF_Image_GetSize(__innerContent);
+    HPDF_Point point = __haruppCheck(HPDF_Image_GetSize(__content()));
     return Coor2D(point.x, point.y);
 }
 
 unsigned int Image::getWidth() const {
-    return HPDF_Image_GetWidth(__innerContent);
+    return __haruppCheck(HPDF_Image_GetWidth(__content()));
 }
 
 unsigned int Image::getHeight() const {
-    return HPDF_Image_GetHeight(__innerContent);
+    return __haruppCheck(HPDF_Image_GetHeight(__content()));
 }
 
 unsigned int Image::getBitsPerComponent() const {
-    return HPDF_Image_GetBitsPerComponent(__innerContent);
+    return __haruppCheck(HPDF_Image_GetBitsPerComponent(__content()));
 }
 
 enums::ColorSpace Image::getColorSpace() const {
-    const char* colorSpace = HPDF_Image_GetColorSpace(__innerContent);
+    const char* colorSpace = __haruppCheck(HPDF_Image_GetColorSpace(__content()));
     if (colorSpace == nullptr) throw excepts::InvalidColorSpaceException();
     if (strcmp(colorSpace, "DeviceGray") == 0) return enums::ColorSpace::DEVICE_GRAY;
     if (strcmp(colorSpace, "DeviceRGB") == 0) return enums::ColorSpace::DEVICE_RGB;
@@ -39,9 +40,9 @@ void Image::setColorMask(
     types::uint8 gmin, types::uint8 gmax,
     types::uint8 bmin, types::uint8 bmax
 ) {
-    HPDF_Image_SetColorMask(__innerContent, rmin, rmax, gmin, gmax, bmin, bmax);
+    __haruppCheck(HPDF_Image_SetColorMask(__content(), rmin, rmax, gmin, gmax, bmin, bmax));
 }
 
 void Image::setMaskImage(const Image& image) {
-    HPDF_Image_SetMaskImage(__innerContent, image.__innerContent);
+    __haruppCheck(HPDF_Image_SetMaskImage(__content(), image.__content()));
 }
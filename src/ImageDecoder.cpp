@@ -0,0 +1,266 @@
+#include "ImageDecoder.hpp"
+#include "ImageResampler.hpp"
+#include "algorithm"
+#include "cstdint"
+#include "cstdlib"
+#include "cstring"
+#include "zlib.h"
+using namespace pdf::enums;
+
+
+/****************************** HELPERS ******************************/
+static std::uint32_t __haruppReadBigEndian32(const unsigned char* p) noexcept {
+    return ((std::uint32_t) p[0] << 24) | ((std::uint32_t) p[1] << 16) | ((std::uint32_t) p[2] << 8) | (std::uint32_t) p[3];
+}
+
+static unsigned int __haruppReadBigEndian16(const unsigned char* p) noexcept {
+    return ((unsigned int) p[0] << 8) | (unsigned int) p[1];
+}
+
+// Adam7 passes: first column, first row, column step and row step
+static const unsigned int __haruppAdam7[7][4] = {
+    {0U, 0U, 8U, 8U}, {4U, 0U, 8U, 8U}, {0U, 4U, 4U, 8U}, {2U, 0U, 4U, 4U}, {0U, 2U, 2U, 4U}, {1U, 0U, 2U, 2U}, {0U, 1U, 1U, 2U}
+};
+static const unsigned int __haruppNoInterlace[1][4] = {{0U, 0U, 1U, 1U}};
+
+static bool __haruppInflate(const std::vector<unsigned char>& compressed, std::vector<unsigned char>& raw) {
+    z_stream zStream = {};
+    if (inflateInit(&zStream) != Z_OK) return false;
+    zStream.next_in = (Bytef*) compressed.data();
+    zStream.avail_in = (uInt) compressed.size();
+    zStream.next_out = raw.data();
+    zStream.avail_out = (uInt) raw.size();
+    int status = inflate(&zStream, Z_FINISH);
+    inflateEnd(&zStream);
+
+    // Some encoders append padding after the image data, what matters is that every row is there
+    return (status == Z_STREAM_END || status == Z_BUF_ERROR) && zStream.total_out == raw.size();
+}
+
+static bool __haruppDeflate(const std::vector<unsigned char>& raw, std::vector<unsigned char>& compressed) {
+    uLongf size = compressBound((uLong) raw.size());
+    compressed.resize(size);
+    if (compress2(compressed.data(), &size, raw.data(), (uLong) raw.size(), Z_DEFAULT_COMPRESSION) != Z_OK) return false;
+    compressed.resize(size);
+    return true;
+}
+
+static bool __haruppUnfilterRow(unsigned char* row, const unsigned char* previous, std::size_t length, std::size_t pixelBytes, unsigned char filter) noexcept {
+    for (std::size_t i = 0U; i < length; ++i) {
+        unsigned int left = (i >= pixelBytes)? row[i - pixelBytes]: 0U;
+        unsigned int up = (previous != nullptr)? previous[i]: 0U;
+        unsigned int upLeft = (previous != nullptr && i >= pixelBytes)? previous[i - pixelBytes]: 0U;
+        switch (filter) {
+            case 0U: break;
+            case 1U: row[i] = (unsigned char) (row[i] + left); break;
+            case 2U: row[i] = (unsigned char) (row[i] + up); break;
+            case 3U: row[i] = (unsigned char) (row[i] + ((left + up) >> 1)); break;
+            case 4U: {
+                int estimate = (int) left + (int) up - (int) upLeft;
+                int distanceLeft = std::abs(estimate - (int) left);
+                int distanceUp = std::abs(estimate - (int) up);
+                int distanceUpLeft = std::abs(estimate - (int) upLeft);
+                unsigned int predictor = (distanceLeft <= distanceUp && distanceLeft <= distanceUpLeft)? left: (distanceUp <= distanceUpLeft)? up: upLeft;
+                row[i] = (unsigned char) (row[i] + predictor);
+                break;
+            }
+            default: return false;
+        }
+    }
+    return true;
+}
+
+static unsigned int __haruppSample(const unsigned char* row, std::size_t index, unsigned int depth) noexcept {
+    if (depth == 8U) return row[index];
+    if (depth == 16U) return __haruppReadBigEndian16(row + 2U * index);
+    std::size_t bit = index * depth;
+    return (row[bit / 8U] >> (8U - depth - bit % 8U)) & ((1U << depth) - 1U);
+}
+
+
+/******************** PNG ********************/
+
+bool __haruppDecodePNG(const unsigned char* data, std::size_t size, __HaruppDecodedImage& image, const pdf::ImageDownsampling& downsampling) {
+    static const unsigned char signature[8] = {137U, 80U, 78U, 71U, 13U, 10U, 26U, 10U};
+    if (data == nullptr || size < 8U || std::memcmp(data, signature, 8U) != 0) return false;
+
+    // Chunks
+    unsigned int width = 0U, height = 0U, depth = 0U, colorType = 0U, interlace = 0U;
+    bool hasHeader = false;
+    std::vector<unsigned char> compressed;
+    std::vector<unsigned char> palette;
+    std::vector<unsigned char> transparency;
+    for (std::size_t offset = 8U; offset + 12U <= size;) {
+        std::uint32_t length = __haruppReadBigEndian32(data + offset);
+        if (length > size - offset - 12U) return false;
+        const unsigned char* type = data + offset + 4U;
+        const unsigned char* chunk = data + offset + 8U;
+        if (std::memcmp(type, "IHDR", 4U) == 0) {
+            if (length < 13U || chunk[10] != 0U || chunk[11] != 0U) return false;
+            width = __haruppReadBigEndian32(chunk);
+            height = __haruppReadBigEndian32(chunk + 4U);
+            depth = chunk[8];
+            colorType = chunk[9];
+            interlace = chunk[12];
+            hasHeader = true;
+        } else if (std::memcmp(type, "PLTE", 4U) == 0) palette.assign(chunk, chunk + length);
+        else if (std::memcmp(type, "tRNS", 4U) == 0) transparency.assign(chunk, chunk + length);
+        else if (std::memcmp(type, "IDAT", 4U) == 0) compressed.insert(compressed.end(), chunk, chunk + length);
+        else if (std::memcmp(type, "IEND", 4U) == 0) break;
+        offset += 12U + (std::size_t) length;
+    }
+
+    unsigned int channels;
+    switch (colorType) {
+        case 0U: channels = 1U; break;
+        case 2U: channels = 3U; break;
+        case 3U: channels = 1U; break;
+        case 4U: channels = 2U; break;
+        case 6U: channels = 4U; break;
+        default: return false;
+    }
+    bool validDepth = (depth == 8U) || (depth == 16U && colorType != 3U) || ((depth == 1U || depth == 2U || depth == 4U) && (colorType == 0U || colorType == 3U));
+    if (!hasHeader || !validDepth || interlace > 1U || width == 0U || height == 0U || compressed.empty()) return false;
+    if (width > 0x7FFFFFFFU || height > 0x7FFFFFFFU) return false;
+    if (colorType == 3U && (palette.empty() || palette.size() % 3U != 0U || palette.size() > 768U)) return false;
+
+    image.width = width;
+    image.height = height;
+    image.colorSpace = (colorType == 3U)? ColorSpace::INDEXED: (colorType == 2U || colorType == 6U)? ColorSpace::DEVICE_RGB: ColorSpace::DEVICE_GRAY;
+    if (colorType == 3U) image.palette = palette;
+    unsigned int targetWidth = width, targetHeight = height;
+    downsampling.computeTargetSize(targetWidth, targetHeight);
+    bool resample = targetWidth < width || targetHeight < height;
+
+    // PDF understands PNG predictors, so simple images keep their data as is
+    if (interlace == 0U && depth <= 8U && colorType != 4U && colorType != 6U && transparency.empty() && !resample) {
+        image.bitsPerComponent = depth;
+        image.predictorColors = channels;
+        image.data = std::move(compressed);
+        return true;
+    }
+
+    // Filtered data, pass after pass
+    const unsigned int (*passes)[4] = (interlace == 1U)? __haruppAdam7: __haruppNoInterlace;
+    unsigned int passCount = (interlace == 1U)? 7U: 1U;
+    std::size_t pixelBits = (std::size_t) channels * depth;
+    std::size_t pixelBytes = std::max<std::size_t>(1U, pixelBits / 8U);
+    std::size_t rawSize = 0U;
+    for (unsigned int p = 0U; p < passCount; ++p) {
+        std::size_t passWidth = (width > passes[p][0])? (width - passes[p][0] + passes[p][2] - 1U) / passes[p][2]: 0U;
+        std::size_t passHeight = (height > passes[p][1])? (height - passes[p][1] + passes[p][3] - 1U) / passes[p][3]: 0U;
+        if (passWidth > 0U) rawSize += passHeight * (1U + (passWidth * pixelBits + 7U) / 8U);
+    }
+    std::vector<unsigned char> raw(rawSize);
+    if (!__haruppInflate(compressed, raw)) return false;
+    compressed = std::vector<unsigned char>();
+
+    // 8 bits color samples and alpha
+    unsigned int colorChannels = (colorType == 2U || colorType == 6U)? 3U: 1U;
+    std::vector<unsigned char> color((std::size_t) width * height * colorChannels);
+    std::vector<unsigned char> alpha((std::size_t) width * height, 255U);
+    bool hasAlpha = false;
+    unsigned int maxValue = (1U << depth) - 1U;
+    unsigned char* row = raw.data();
+    for (unsigned int p = 0U; p < passCount; ++p) {
+        std::size_t passWidth = (width > passes[p][0])? (width - passes[p][0] + passes[p][2] - 1U) / passes[p][2]: 0U;
+        std::size_t passHeight = (height > passes[p][1])? (height - passes[p][1] + passes[p][3] - 1U) / passes[p][3]: 0U;
+        if (passWidth == 0U) continue;
+        std::size_t rowBytes = (passWidth * pixelBits + 7U) / 8U;
+        const unsigned char* previous = nullptr;
+        for (std::size_t y = 0U; y < passHeight; ++y, row += 1U + rowBytes) {
+            if (!__haruppUnfilterRow(row + 1U, previous, rowBytes, pixelBytes, row[0])) return false;
+            previous = row + 1U;
+            std::size_t imageY = passes[p][1] + y * passes[p][3];
+            for (std::size_t x = 0U; x < passWidth; ++x) {
+                std::size_t pixel = imageY * width + passes[p][0] + x * passes[p][2];
+                unsigned int samples[4];
+                for (unsigned int c = 0U; c < channels; ++c) samples[c] = __haruppSample(row + 1U, x * channels + c, depth);
+
+                for (unsigned int c = 0U; c < colorChannels; ++c) {
+                    unsigned int value = samples[c];
+                    if (colorType != 3U) value = (depth == 16U)? (value >> 8): (depth < 8U)? value * 255U / maxValue: value;
+                    color[pixel * colorChannels + c] = (unsigned char) value;
+                }
+
+                unsigned int opacity = 255U;
+                if (colorType == 4U || colorType == 6U) opacity = (depth == 16U)? (samples[channels - 1U] >> 8): samples[channels - 1U];
+                else if (colorType == 3U && samples[0] < transparency.size()) opacity = transparency[samples[0]];
+                else if (colorType == 0U && transparency.size() >= 2U && samples[0] == __haruppReadBigEndian16(transparency.data())) opacity = 0U;
+                else if (colorType == 2U && transparency.size() >= 6U && samples[0] == __haruppReadBigEndian16(transparency.data())
+                    && samples[1] == __haruppReadBigEndian16(transparency.data() + 2U) && samples[2] == __haruppReadBigEndian16(transparency.data() + 4U)) opacity = 0U;
+                alpha[pixel] = (unsigned char) opacity;
+                hasAlpha = hasAlpha || opacity != 255U;
+            }
+        }
+    }
+    raw = std::vector<unsigned char>();
+
+    // Palette indices cannot be interpolated, so downsampled indexed images become RGB
+    if (resample) {
+        if (colorType == 3U) {
+            std::vector<unsigned char> indices = std::move(color);
+            color.assign(indices.size() * 3U, 0U);
+            for (std::size_t i = 0U; i < indices.size(); ++i)
+                if (3U * (std::size_t) indices[i] + 2U < palette.size()) std::memcpy(color.data() + 3U * i, palette.data() + 3U * indices[i], 3U);
+            colorChannels = 3U;
+            image.colorSpace = ColorSpace::DEVICE_RGB;
+            image.palette.clear();
+        }
+        color = __haruppResample(color.data(), width, height, colorChannels, targetWidth, targetHeight, downsampling.getFilter());
+        if (hasAlpha) alpha = __haruppResample(alpha.data(), width, height, 1U, targetWidth, targetHeight, downsampling.getFilter());
+        image.width = targetWidth;
+        image.height = targetHeight;
+    }
+
+    image.bitsPerComponent = 8U;
+    if (!__haruppDeflate(color, image.data)) return false;
+    if (hasAlpha && !__haruppDeflate(alpha, image.alpha)) return false;
+    return true;
+}
+
+
+/******************** JPEG ********************/
+
+bool __haruppDecodeJPEG(std::vector<unsigned char>&& data, __HaruppDecodedImage& image) {
+    std::size_t size = data.size();
+    if (size < 4U || data[0] != 0xFFU || data[1] != 0xD8U) return false;
+
+    // Walk the markers up to the frame header
+    for (std::size_t offset = 2U; offset + 4U <= size;) {
+        if (data[offset] != 0xFFU) return false;
+        unsigned char marker = data[offset + 1U];
+        if (marker == 0xFFU) {
+            ++offset;
+            continue;
+        }
+        if (marker == 0x01U || (marker >= 0xD0U && marker <= 0xD7U)) {
+            offset += 2U;
+            continue;
+        }
+        if (marker == 0xD9U || marker == 0xDAU) return false;
+        std::size_t length = __haruppReadBigEndian16(data.data() + offset + 2U);
+        if (length < 2U || offset + 2U + length > size) return false;
+
+        bool frame = marker >= 0xC0U && marker <= 0xCFU && marker != 0xC4U && marker != 0xC8U && marker != 0xCCU;
+        if (frame) {
+            if (length < 8U) return false;
+            const unsigned char* header = data.data() + offset + 4U;
+            image.bitsPerComponent = header[0];
+            image.height = __haruppReadBigEndian16(header + 1U);
+            image.width = __haruppReadBigEndian16(header + 3U);
+            switch (header[5]) {
+                case 1U: image.colorSpace = ColorSpace::DEVICE_GRAY; break;
+                case 3U: image.colorSpace = ColorSpace::DEVICE_RGB; break;
+                case 4U: image.colorSpace = ColorSpace::DEVICE_CMYK; break;
+                default: return false;
+            }
+            if (image.width == 0U || image.height == 0U || image.bitsPerComponent != 8U) return false;
+            image.dct = true;
+            image.data = std::move(data);
+            return true;
+        }
+        offset += 2U + length;
+    }
+    return false;
+}
@@ -0,0 +1,62 @@
+#ifndef __HARUPP_IMAGEDECODER_HPP__
+#define __HARUPP_IMAGEDECODER_HPP__
+#include "../include/Enums.hpp"
+#include "../include/ImageDownsampling.hpp"
+#include "condition_variable"
+#include "cstddef"
+#include "mutex"
+#include "vector"
+
+struct _HPDF_Dict_Rec;
+struct _HPDF_Doc_Rec;
+struct __HaruppMemoryContext;
+
+// Internal header: image decoding run outside of LibHaru by asynchronous loads, not part of the public API.
+
+// Image ready to become an image dictionary, the stream data is already encoded
+struct __HaruppDecodedImage {
+    unsigned int width = 0U;
+    unsigned int height = 0U;
+    unsigned int bitsPerComponent = 8U;
+    // DEVICE_GRAY, DEVICE_RGB, DEVICE_CMYK or INDEXED
+    pdf::enums::ColorSpace colorSpace = pdf::enums::ColorSpace::DEVICE_RGB;
+    // RGB entries of indexed images
+    std::vector<unsigned char> palette;
+    // DCT data if `dct` is set, Flate data otherwise
+    std::vector<unsigned char> data;
+    bool dct = false;
+    // Number of colors of the PNG predictors kept in the Flate data, `0` if there are none
+    unsigned int predictorColors = 0U;
+    // Flate encoded 8 bits soft mask, empty for opaque images
+    std::vector<unsigned char> alpha;
+};
+
+// Image decoded by a ThreadPool worker, then written into its placeholder dictionary on the document thread
+struct __HaruppImageJob {
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool done = false;
+    // LibHaru error code and detail if the image could not be read or decoded
+    unsigned long errorNo = 0U;
+    unsigned long detailNo = 0U;
+    __HaruppDecodedImage image;
+
+    // Document side, `pdfDoc` is reset once the document is closed or recycled
+    _HPDF_Doc_Rec* pdfDoc = nullptr;
+    __HaruppMemoryContext* memoryContext = nullptr;
+    _HPDF_Dict_Rec* dict = nullptr;
+    bool resolved = false;
+};
+
+// Decodes a PNG file. Simple non-interlaced images keep their compressed data as is, the others are unfiltered,
+// de-interlaced, reduced to 8 bits, split from their alpha channel, downsampled if needed and compressed again.
+// Returns `false` if the data is not a valid PNG image.
+bool __haruppDecodePNG(
+    const unsigned char* data, std::size_t size, __HaruppDecodedImage& image,
+    const pdf::ImageDownsampling& downsampling = pdf::ImageDownsampling()
+);
+
+// Reads the header of a JPEG file, whose data is kept as is. Returns `false` if the data is not a supported JPEG image.
+bool __haruppDecodeJPEG(std::vector<unsigned char>&& data, __HaruppDecodedImage& image);
+
+#endif // __HARUPP_IMAGEDECODER_HPP__
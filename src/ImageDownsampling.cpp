@@ -0,0 +1,41 @@
+#include "../include/ImageDownsampling.hpp"
+#include "algorithm"
+#include "cmath"
+using namespace pdf;
+using namespace pdf::enums;
+
+
+ImageDownsampling::ImageDownsampling() noexcept {}
+
+ImageDownsampling::ImageDownsampling(float resolution, float width, float height, ResamplingFilter filter) noexcept:
+    resolution(resolution), width(width), height(height), filter(filter) {}
+
+float ImageDownsampling::getResolution() const noexcept {
+    return resolution;
+}
+
+float ImageDownsampling::getWidth() const noexcept {
+    return width;
+}
+
+float ImageDownsampling::getHeight() const noexcept {
+    return height;
+}
+
+ResamplingFilter ImageDownsampling::getFilter() const noexcept {
+    return filter;
+}
+
+void ImageDownsampling::computeTargetSize(unsigned int& width, unsigned int& height) const noexcept {
+    if (isEmpty()) return;
+
+    // Points are 1/72 inch, the pixel size is rounded up so that the effective resolution never falls below the target
+    double targetWidth = std::ceil(std::fabs((double) this->width) * resolution / 72.0);
+    double targetHeight = std::ceil(std::fabs((double) this->height) * resolution / 72.0);
+    if (targetWidth < (double) width) width = (unsigned int) std::max(1.0, targetWidth);
+    if (targetHeight < (double) height) height = (unsigned int) std::max(1.0, targetHeight);
+}
+
+bool ImageDownsampling::isEmpty() const noexcept {
+    return !(resolution > 0.f) || width == 0.f || height == 0.f;
+}
@@ -0,0 +1,115 @@
+#include "ImageResampler.hpp"
+#include "algorithm"
+#include "cmath"
+#include "cstddef"
+using namespace pdf::enums;
+
+
+/****************************** HELPERS ******************************/
+// Weights of every target pixel, padded to the same number of taps
+struct __HaruppKernel {
+    std::size_t taps = 0U;
+    std::vector<std::size_t> first;
+    std::vector<float> weights;
+};
+
+static double __haruppFilterSupport(ResamplingFilter filter) noexcept {
+    switch (filter) {
+        case ResamplingFilter::BOX: return 0.5;
+        case ResamplingFilter::BILINEAR: return 1.0;
+        default: return 3.0;
+    }
+}
+
+static double __haruppFilterWeight(ResamplingFilter filter, double x) noexcept {
+    static const double pi = 3.14159265358979323846;
+    x = std::fabs(x);
+    switch (filter) {
+        case ResamplingFilter::BOX: return (x <= 0.5)? 1.0: 0.0;
+        case ResamplingFilter::BILINEAR: return (x < 1.0)? 1.0 - x: 0.0;
+        default: {
+            if (x < 1e-9) return 1.0;
+            if (x >= 3.0) return 0.0;
+            return 3.0 * std::sin(pi * x) * std::sin(pi * x / 3.0) / (pi * pi * x * x);
+        }
+    }
+}
+
+static __HaruppKernel __haruppBuildKernel(std::size_t source, std::size_t target, ResamplingFilter filter) {
+    double scale = (double) source / (double) target;
+    double filterScale = std::max(scale, 1.0);
+    double support = __haruppFilterSupport(filter) * filterScale;
+
+    __HaruppKernel kernel;
+    kernel.taps = std::min(source, (std::size_t) std::ceil(2.0 * support) + 1U);
+    kernel.first.resize(target);
+    kernel.weights.assign(target * kernel.taps, 0.f);
+    std::vector<double> weights(kernel.taps);
+    for (std::size_t i = 0U; i < target; ++i) {
+        double center = ((double) i + 0.5) * scale;
+        std::size_t left = (std::size_t) std::max(0.0, std::floor(center - support));
+        std::size_t right = std::min(source, (std::size_t) std::ceil(center + support));
+        if (right - left > kernel.taps) right = left + kernel.taps;
+        left = std::min(left, source - kernel.taps);
+
+        // Taps are normalized so that flat areas keep their value
+        double sum = 0.0;
+        for (std::size_t k = 0U; k < kernel.taps; ++k) {
+            double x = ((double) (left + k) + 0.5 - center) / filterScale;
+            weights[k] = (left + k < right)? __haruppFilterWeight(filter, x): 0.0;
+            sum += weights[k];
+        }
+        kernel.first[i] = left;
+        if (sum == 0.0) {
+            std::size_t nearest = std::min(source - 1U, (std::size_t) center);
+            kernel.weights[i * kernel.taps + (nearest - left)] = 1.f;
+            continue;
+        }
+        for (std::size_t k = 0U; k < kernel.taps; ++k) kernel.weights[i * kernel.taps + k] = (float) (weights[k] / sum);
+    }
+    return kernel;
+}
+
+static unsigned char __haruppClampSample(float value) noexcept {
+    // Lanczos lobes overshoot around sharp edges
+    return (unsigned char) std::min(255.f, std::max(0.f, value + 0.5f));
+}
+
+
+/******************** RESAMPLING ********************/
+
+std::vector<unsigned char> __haruppResample(
+    const unsigned char* source, unsigned int sourceWidth, unsigned int sourceHeight, unsigned int channels,
+    unsigned int targetWidth, unsigned int targetHeight, ResamplingFilter filter
+) {
+    std::size_t sourceRow = (std::size_t) sourceWidth * channels;
+    std::size_t targetRow = (std::size_t) targetWidth * channels;
+    __HaruppKernel vertical = __haruppBuildKernel(sourceHeight, targetHeight, filter);
+    __HaruppKernel horizontal = __haruppBuildKernel(sourceWidth, targetWidth, filter);
+
+    // Rows are reduced first, whole rows at a time, which keeps the inner loop contiguous and vectorizable
+    std::vector<float> row(sourceRow);
+    std::vector<float> pixel(channels);
+    std::vector<unsigned char> target(targetRow * targetHeight);
+    for (std::size_t y = 0U; y < targetHeight; ++y) {
+        std::fill(row.begin(), row.end(), 0.f);
+        float* accumulator = row.data();
+        for (std::size_t k = 0U; k < vertical.taps; ++k) {
+            float weight = vertical.weights[y * vertical.taps + k];
+            if (weight == 0.f) continue;
+            const unsigned char* samples = source + (vertical.first[y] + k) * sourceRow;
+            for (std::size_t i = 0U; i < sourceRow; ++i) accumulator[i] += weight * (float) samples[i];
+        }
+
+        unsigned char* output = target.data() + y * targetRow;
+        for (std::size_t x = 0U; x < targetWidth; ++x) {
+            std::fill(pixel.begin(), pixel.end(), 0.f);
+            const float* samples = accumulator + horizontal.first[x] * channels;
+            const float* weights = horizontal.weights.data() + x * horizontal.taps;
+            for (std::size_t k = 0U; k < horizontal.taps; ++k)
+                for (std::size_t c = 0U; c < channels; ++c) pixel[c] += weights[k] * samples[k * channels + c];
+            for (std::size_t c = 0U; c < channels; ++c) output[x * channels + c] = __haruppClampSample(pixel[c]);
+        }
+    }
+    return target;
+}
@@ -0,0 +1,15 @@
+#ifndef __HARUPP_IMAGERESAMPLER_HPP__
+#define __HARUPP_IMAGERESAMPLER_HPP__
+#include "../include/Enums.hpp"
+#include "vector"
+
+// Internal header: image resampling used by downsampled image loads, not part of the public API.
+
+// Resamples 8 bits samples with `channels` interleaved channels and unpadded rows. The image is filtered vertically
+// then horizontally with a separable kernel widened by the reduction factor, so that every source pixel contributes.
+std::vector<unsigned char> __haruppResample(
+    const unsigned char* source, unsigned int sourceWidth, unsigned int sourceHeight, unsigned int channels,
+    unsigned int targetWidth, unsigned int targetHeight, pdf::enums::ResamplingFilter filter
+);
+
+#endif // __HARUPP_IMAGERESAMPLER_HPP__
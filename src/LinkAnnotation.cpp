@@ -1,14 +1,15 @@
 #include "../include/LinkAnnotation.hpp"
+#include "ErrorHandler.hpp"
 #include "hpdf.h"
 using namespace pdf;
 
 
-LinkAnnotation::LinkAnnotation(_HPDF_Dict_Rec* content) noexcept: Annotation(content) {}
+LinkAnnotation::LinkAnnotation(_HPDF_Dict_Rec* content, const std::atomic<unsigned int>* generation) noexcept: Annotation(content, generation) {}
 
 void LinkAnnotation::setHighlightMode(enums::AnnotationHighlightMode mode) {
-    HPDF_LinkAnnot_SetHighlightMode(__innerContent, (HPDF_AnnotHighlightMode) mode);
+    __haruppCheck(HPDF_LinkAnnot_SetHighlightMode(__content(), (HPDF_AnnotHighlightMode) mode));
 }
 
 void LinkAnnotation::setBorderStyle(float width, unsigned short dashOn, unsigned short dashOff) {
-    HPDF_LinkAnnot_SetBorderStyle(__innerContent, width, dashOn, dashOff);
+    __haruppCheck(HPDF_LinkAnnot_SetBorderStyle(__content(), width, dashOn, dashOff));
 }
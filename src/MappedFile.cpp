@@ -0,0 +1,82 @@
+#include "MappedFile.hpp"
+#include "errno.h"
+#include "fcntl.h"
+#include "mutex"
+#include "sys/mman.h"
+#include "sys/stat.h"
+#include "unistd.h"
+#include "unordered_map"
+
+
+/****************************** HELPERS ******************************/
+static std::mutex __haruppMappedFilesMutex;
+static std::unordered_map<std::string, std::weak_ptr<const __HaruppMappedFile>> __haruppMappedFiles;
+
+static std::shared_ptr<const __HaruppMappedFile> __haruppMapNewFile(const std::string& fileName, std::filesystem::file_time_type time) {
+    int fileDescriptor = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fileDescriptor < 0) return nullptr;
+    struct stat status;
+    if (::fstat(fileDescriptor, &status) != 0) {
+        int error = errno;
+        ::close(fileDescriptor);
+        errno = error;
+        return nullptr;
+    }
+    if (status.st_size <= 0) {
+        ::close(fileDescriptor);
+        errno = EINVAL;
+        return nullptr;
+    }
+
+    // The mapping outlives the descriptor
+    void* data = ::mmap(nullptr, (std::size_t) status.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    int error = errno;
+    ::close(fileDescriptor);
+    if (data == MAP_FAILED) {
+        errno = error;
+        return nullptr;
+    }
+    std::shared_ptr<__HaruppMappedFile> file = std::make_shared<__HaruppMappedFile>();
+    file->data = (const unsigned char*) data;
+    file->size = (std::size_t) status.st_size;
+    file->time = time;
+    return file;
+}
+
+
+/******************** MAPPED FILES ********************/
+
+__HaruppMappedFile::~__HaruppMappedFile() noexcept {
+    if (data != nullptr) ::munmap((void*) data, size);
+}
+
+std::shared_ptr<const __HaruppMappedFile> __haruppMapFile(const std::string& fileName) {
+    std::error_code error;
+    std::filesystem::file_time_type time = std::filesystem::last_write_time(fileName, error);
+    if (error) {
+        errno = error.value();
+        return nullptr;
+    }
+    std::uintmax_t size = std::filesystem::file_size(fileName, error);
+    if (error) {
+        errno = error.value();
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(__haruppMappedFilesMutex);
+    std::unordered_map<std::string, std::weak_ptr<const __HaruppMappedFile>>::iterator it = __haruppMappedFiles.find(fileName);
+    if (it != __haruppMappedFiles.end()) {
+        std::shared_ptr<const __HaruppMappedFile> file = it->second.lock();
+        if (file != nullptr && file->time == time && file->size == size) return file;
+    }
+
+    // Mapping is cheap, pages are only read when used
+    std::shared_ptr<const __HaruppMappedFile> file = __haruppMapNewFile(fileName, time);
+    if (file == nullptr) return nullptr;
+    for (it = __haruppMappedFiles.begin(); it != __haruppMappedFiles.end();) {
+        if (it->second.expired()) it = __haruppMappedFiles.erase(it);
+        else ++it;
+    }
+    __haruppMappedFiles[fileName] = file;
+    return file;
+}
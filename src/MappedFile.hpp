@@ -0,0 +1,26 @@
+#ifndef __HARUPP_MAPPEDFILE_HPP__
+#define __HARUPP_MAPPEDFILE_HPP__
+#include "cstddef"
+#include "filesystem"
+#include "memory"
+#include "string"
+
+// Internal header: read-only file mappings shared by the wrapper sources, not part of the public API.
+
+// Whole file mapped read-only, unmapped once the last reference is released
+struct __HaruppMappedFile {
+    const unsigned char* data = nullptr;
+    std::size_t size = 0U;
+    std::filesystem::file_time_type time;
+
+    __HaruppMappedFile() noexcept = default;
+    __HaruppMappedFile(const __HaruppMappedFile&) = delete;
+    __HaruppMappedFile& operator=(const __HaruppMappedFile&) = delete;
+    ~__HaruppMappedFile() noexcept;
+};
+
+// Maps a file, or returns the mapping already held by another user if the file has not changed since. Returns `nullptr`
+// with `errno` set if the file cannot be mapped (empty files included).
+std::shared_ptr<const __HaruppMappedFile> __haruppMapFile(const std::string& fileName);
+
+#endif // __HARUPP_MAPPEDFILE_HPP__
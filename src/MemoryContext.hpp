@@ -0,0 +1,48 @@
+#ifndef __HARUPP_MEMORYCONTEXT_HPP__
+#define __HARUPP_MEMORYCONTEXT_HPP__
+#include "../include/Allocator.hpp"
+#include "../include/Enums.hpp"
+#include "hpdf.h"
+#include "cstddef"
+#include "memory"
+
+// Internal header: memory accounting shared by Document and Page, not part of the public API.
+
+// Memory accounting state of a document, also used as the LibHaru error handler user data.
+// Allocations made outside of any __HaruppMemoryScope are accounted to OTHER.
+struct __HaruppMemoryContext {
+    pdf::Allocator* allocator = nullptr;
+    std::size_t quota = 0U;
+    bool quotaExceeded = false;
+    pdf::enums::MemoryCategory category = pdf::enums::MemoryCategory::OTHER;
+    std::size_t currentSize = 0U;
+    std::size_t peakSize = 0U;
+    std::size_t allocationCount = 0U;
+    std::size_t categorySizes[4] = {0U, 0U, 0U, 0U};
+};
+
+// Accounts the allocations made during its lifetime to a given category
+class __HaruppMemoryScope {
+    __HaruppMemoryContext* context;
+    pdf::enums::MemoryCategory previous = pdf::enums::MemoryCategory::OTHER;
+
+public:
+    __HaruppMemoryScope(const std::unique_ptr<__HaruppMemoryContext>& context, pdf::enums::MemoryCategory category) noexcept:
+        __HaruppMemoryScope(context.get(), category) {}
+
+    // Objects of an accounted document reach its context through their error handler user data
+    __HaruppMemoryScope(HPDF_Dict object, pdf::enums::MemoryCategory category) noexcept:
+        __HaruppMemoryScope((object == nullptr || object->error == nullptr)? nullptr: (__HaruppMemoryContext*) object->error->user_data, category) {}
+
+    __HaruppMemoryScope(__HaruppMemoryContext* context, pdf::enums::MemoryCategory category) noexcept: context(context) {
+        if (this->context == nullptr) return;
+        previous = this->context->category;
+        this->context->category = category;
+    }
+
+    ~__HaruppMemoryScope() noexcept {
+        if (context != nullptr) context->category = previous;
+    }
+};
+
+#endif // __HARUPP_MEMORYCONTEXT_HPP__
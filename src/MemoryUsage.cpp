@@ -0,0 +1,31 @@
+#include "../include/MemoryUsage.hpp"
+using namespace pdf;
+
+
+MemoryUsage::MemoryUsage(std::size_t currentSize, std::size_t peakSize, std::size_t allocationCount, const std::size_t (&categorySizes)[4]) noexcept:
+    currentSize(currentSize), peakSize(peakSize), allocationCount(allocationCount),
+    categorySizes{categorySizes[0], categorySizes[1], categorySizes[2], categorySizes[3]} {}
+
+MemoryUsage::MemoryUsage() noexcept {}
+
+std::size_t MemoryUsage::getCurrentSize() const noexcept {
+    return currentSize;
+}
+
+std::size_t MemoryUsage::getPeakSize() const noexcept {
+    return peakSize;
+}
+
+std::size_t MemoryUsage::getAllocationCount() const noexcept {
+    return allocationCount;
+}
+
+std::size_t MemoryUsage::getCategorySize(enums::MemoryCategory category) const noexcept {
+    int index = static_cast<int>(category);
+    if (index < 0 || index > 3) return 0U;
+    return categorySizes[index];
+}
+
+bool MemoryUsage::isEmpty() const noexcept {
+    return allocationCount == 0U;
+}
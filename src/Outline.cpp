@@ -1,14 +1,15 @@
 #include "../include/Outline.hpp"
+#include "ErrorHandler.hpp"
 #include "hpdf.h"
 using namespace pdf;
 
 
-Outline::Outline(_HPDF_Dict_Rec* content) noexcept: ContentStream(content) {}
+Outline::Outline(_HPDF_Dict_Rec* content, const std::atomic<unsigned int>* generation) noexcept: ContentStream(content, generation) {}
 
 void Outline::setOpen(bool opened) {
-    HPDF_Outline_SetOpened(__innerContent, opened);
+    __haruppCheck(HPDF_Outline_SetOpened(__content(), opened));
 }
 
 void Outline::setDestination(const Destination& destination) {
-    HPDF_Outline_SetDestination(__innerContent, destination.__innerContent);
+    __haruppCheck(HPDF_Outline_SetDestination(__content(), destination.__innerContent));
 }
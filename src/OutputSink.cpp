@@ -0,0 +1,38 @@
+#include "../include/OutputSink.hpp"
+#include "../include/Exception.hpp"
+#include "errno.h"
+#include "unistd.h"
+using namespace pdf;
+
+
+OutputSink::~OutputSink() noexcept {}
+
+
+FileDescriptorSink::FileDescriptorSink(int fileDescriptor) noexcept: fileDescriptor(fileDescriptor) {}
+
+void FileDescriptorSink::write(const unsigned char* data, unsigned int size) {
+    while (size > 0U) {
+        ssize_t written = ::write(fileDescriptor, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            throw excepts::FileIOException(errno);
+        }
+        data += written;
+        size -= (unsigned int) written;
+    }
+}
+
+
+OStreamSink::OStreamSink(std::ostream& stream) noexcept: stream(stream) {}
+
+void OStreamSink::write(const unsigned char* data, unsigned int size) {
+    stream.write((const char*) data, size);
+    if (!stream) throw excepts::FileIOException(0U);
+}
+
+
+BufferSink::BufferSink(std::vector<unsigned char>& buffer) noexcept: buffer(buffer) {}
+
+void BufferSink::write(const unsigned char* data, unsigned int size) {
+    buffer.insert(buffer.end(), data, data + size);
+}
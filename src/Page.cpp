@@ -1,7 +1,13 @@
 #include "../include/Page.hpp"
 #include "../include/Exception.hpp"
 #include "../include/Constants.hpp"
+#include "ContentEncoder.hpp"
+#include "ErrorHandler.hpp"
+#include "GraphicsState.hpp"
+#include "MemoryContext.hpp"
 #include "hpdf.h"
+#include "initializer_list"
+#include "limits"
 using namespace pdf;
 using namespace pdf::enums;
 
@@ -30,6 +36,174 @@ static HPDF_Rect __toRect(const Box& box) {
 }
 
 
+static void __haruppWriteOperands(__HaruppContentEncoder& encoder, const float* operands, std::size_t count) {
+    for (std::size_t i = 0U; i < count; ++i) encoder.writeReal(operands[i]);
+}
+
+
+// Writes path operators (`m`, `l`, `c`, `v`, `y`, `h` and `r` for `re`) with a single graphics mode check. The encoder
+// is handed to the page stream whenever it holds a full block, the current and start points are updated at the end.
+static HPDF_STATUS __haruppWritePath(HPDF_Page page, const char* operators, std::size_t count, const float* operands) {
+    if (count == 0U) return HPDF_OK;
+    bool newPath = operators[0] == 'm' || operators[0] == 'r';
+    HPDF_STATUS status = HPDF_Page_CheckState(page, newPath? (HPDF_GMODE_PAGE_DESCRIPTION | HPDF_GMODE_PATH_OBJECT): HPDF_GMODE_PATH_OBJECT);
+    if (status != HPDF_OK) return status;
+
+    HPDF_PageAttr attr = (HPDF_PageAttr) page->attr;
+    __HaruppContentEncoder& encoder = __haruppContentEncoder();
+    HPDF_Point curPos = attr->cur_pos;
+    HPDF_Point strPos = attr->str_pos;
+    for (std::size_t i = 0U; i < count; ++i) {
+        switch (operators[i]) {
+            case 'm':
+                __haruppWriteOperands(encoder, operands, 2U);
+                encoder.writeOperator("m");
+                curPos = strPos = {operands[0], operands[1]};
+                operands += 2U;
+                break;
+            case 'l':
+                __haruppWriteOperands(encoder, operands, 2U);
+                encoder.writeOperator("l");
+                curPos = {operands[0], operands[1]};
+                operands += 2U;
+                break;
+            case 'c':
+                __haruppWriteOperands(encoder, operands, 6U);
+                encoder.writeOperator("c");
+                curPos = {operands[4], operands[5]};
+                operands += 6U;
+                break;
+            case 'v':
+            case 'y':
+                __haruppWriteOperands(encoder, operands, 4U);
+                encoder.writeOperator((operators[i] == 'v')? "v": "y");
+                curPos = {operands[2], operands[3]};
+                operands += 4U;
+                break;
+            case 'r':
+                __haruppWriteOperands(encoder, operands, 4U);
+                encoder.writeOperator("re");
+                curPos = strPos = {operands[0], operands[1]};
+                operands += 4U;
+                break;
+            default:
+                encoder.writeOperator("h");
+                curPos = strPos;
+                break;
+        }
+        if (encoder.isFull() && encoder.flush(attr->stream) != HPDF_OK) return HPDF_CheckError(page->error);
+    }
+    if (encoder.flush(attr->stream) != HPDF_OK) return HPDF_CheckError(page->error);
+
+    attr->cur_pos = curPos;
+    attr->str_pos = strPos;
+    attr->gmode = HPDF_GMODE_PATH_OBJECT;
+    return HPDF_OK;
+}
+
+
+// Ways of joining the points given to __haruppWritePoints
+enum class __HaruppPointPath {POLYLINE, POLYGON, SEGMENTS};
+
+// Writes points as a path, without building the operator list first
+static HPDF_STATUS __haruppWritePoints(HPDF_Page page, const Coor2D* points, std::size_t count, __HaruppPointPath kind) {
+    if (count == 0U) return HPDF_OK;
+    HPDF_STATUS status = HPDF_Page_CheckState(page, HPDF_GMODE_PAGE_DESCRIPTION | HPDF_GMODE_PATH_OBJECT);
+    if (status != HPDF_OK) return status;
+
+    HPDF_PageAttr attr = (HPDF_PageAttr) page->attr;
+    __HaruppContentEncoder& encoder = __haruppContentEncoder();
+    HPDF_Point strPos = attr->str_pos;
+    for (std::size_t i = 0U; i < count; ++i) {
+        bool startsSubpath = (kind == __HaruppPointPath::SEGMENTS)? i % 2U == 0U: i == 0U;
+        encoder.writeReal(points[i].getX());
+        encoder.writeReal(points[i].getY());
+        encoder.writeOperator(startsSubpath? "m": "l");
+        if (startsSubpath) strPos = {points[i].getX(), points[i].getY()};
+        if (encoder.isFull() && encoder.flush(attr->stream) != HPDF_OK) return HPDF_CheckError(page->error);
+    }
+    if (kind == __HaruppPointPath::POLYGON) encoder.writeOperator("h");
+    if (encoder.flush(attr->stream) != HPDF_OK) return HPDF_CheckError(page->error);
+
+    attr->str_pos = strPos;
+    if (kind == __HaruppPointPath::POLYGON) attr->cur_pos = strPos;
+    else attr->cur_pos = {points[count - 1U].getX(), points[count - 1U].getY()};
+    attr->gmode = HPDF_GMODE_PATH_OBJECT;
+    return HPDF_OK;
+}
+
+
+// Writes a path painting operator. Clipping operators keep the path for the painting operator that must follow.
+static HPDF_STATUS __haruppPaintPath(HPDF_Page page, const char* name, bool clipping) {
+    HPDF_STATUS status = HPDF_Page_CheckState(page, clipping? HPDF_GMODE_PATH_OBJECT: (HPDF_GMODE_PATH_OBJECT | HPDF_GMODE_CLIPPING_PATH));
+    if (status != HPDF_OK) return status;
+
+    HPDF_PageAttr attr = (HPDF_PageAttr) page->attr;
+    __HaruppContentEncoder& encoder = __haruppContentEncoder();
+    encoder.writeOperator(name);
+    if (encoder.flush(attr->stream) != HPDF_OK) return HPDF_CheckError(page->error);
+
+    if (clipping) attr->gmode = HPDF_GMODE_CLIPPING_PATH;
+    else {
+        attr->gmode = HPDF_GMODE_PAGE_DESCRIPTION;
+        attr->cur_pos = {0.f, 0.f};
+    }
+    return HPDF_OK;
+}
+
+
+// Writes a graphics state operator whose operands must be between `0` and `maximum`
+static HPDF_STATUS __haruppWriteState(HPDF_Page page, const char* name, std::initializer_list<float> operands, float maximum) {
+    HPDF_STATUS status = HPDF_Page_CheckState(page, HPDF_GMODE_PAGE_DESCRIPTION | HPDF_GMODE_TEXT_OBJECT);
+    if (status != HPDF_OK) return status;
+    for (float operand: operands) {
+        if (operand < 0.f || operand > maximum) return HPDF_RaiseError(page->error, HPDF_PAGE_OUT_OF_RANGE, 0U);
+    }
+
+    __HaruppContentEncoder& encoder = __haruppContentEncoder();
+    for (float operand: operands) encoder.writeReal(operand);
+    encoder.writeOperator(name);
+    if (encoder.flush(((HPDF_PageAttr) page->attr)->stream) != HPDF_OK) return HPDF_CheckError(page->error);
+    return HPDF_OK;
+}
+
+
+// Gets the mirrored graphics state of a page, after following the LibHaru graphics state depth (LibHaru also restores
+// states by itself when closing a page). Pages without mirror get a copy of the LibHaru state.
+static __HaruppGState& __haruppCurrentGState(HPDF_Page page, __HaruppPageState* state) {
+    if (state == nullptr) {
+        static thread_local __HaruppGState fallback;
+        fallback = __HaruppGState();
+        if (page != nullptr) fallback.load(((HPDF_PageAttr) page->attr)->gstate);
+        return fallback;
+    }
+
+    std::size_t depth = ((HPDF_PageAttr) page->attr)->gstate->depth;
+    while (state->stack.size() > depth && state->stack.size() > 1U) state->stack.pop_back();
+    while (state->stack.size() < depth) state->stack.push_back(state->stack.back());
+    return state->stack.back();
+}
+
+
+// Checks whether a graphics state operator can be skipped, because it would set a known parameter to its current value.
+// The graphics mode is still checked, so that skipped operators fail like written ones.
+static bool __haruppSkipState(HPDF_Page page, __HaruppPageState* state, unsigned int parameter, bool unchanged) {
+    if (state == nullptr || !unchanged || !(__haruppCurrentGState(page, state).known & parameter)) return false;
+    if (__haruppCheck(HPDF_Page_CheckState(page, HPDF_GMODE_PAGE_DESCRIPTION | HPDF_GMODE_TEXT_OBJECT)) == HPDF_OK)
+        ++state->elidedOperators;
+    return true;
+}
+
+
+// Copies the LibHaru graphics state to the mirror once an operator has been written
+static void __haruppSyncState(HPDF_Page page, __HaruppPageState* state, unsigned int known, unsigned int unknown = 0U) {
+    if (state == nullptr) return;
+    __HaruppGState& current = __haruppCurrentGState(page, state);
+    current.load(((HPDF_PageAttr) page->attr)->gstate);
+    current.known = (current.known | known) & ~unknown;
+}
+
+
 static ColorSpace convertToColorSpace(HPDF_ColorSpace colorSpace) {
     switch (colorSpace) {
         case HPDF_CS_DEVICE_GRAY: return ColorSpace::DEVICE_GRAY;
@@ -48,68 +222,79 @@ static ColorSpace convertToColorSpace(HPDF_ColorSpace colorSpace) {
 }
 
 
-Page::Page(_HPDF_Dict_Rec* content) noexcept: ContentStream(content) {}
+Page::Page(_HPDF_Dict_Rec* content, const std::atomic<unsigned int>* generation, __HaruppPageState* state) noexcept:
+    ContentStream(content, generation), __state(state) {}
 
 void Page::setWidth(float width) {
-    HPDF_Page_SetWidth(__innerContent, width);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(HPDF_Page_SetWidth(__content(), width));
 }
 
 void Page::setHeight(float height) {
-    HPDF_Page_SetHeight(__innerContent, height);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(HPDF_Page_SetHeight(__content(), height));
 }
 
 void Page::setBoundary(enums::PageBoundary pageBoundary, const Box& box) {
-    HPDF_Page_SetBoundary(__innerContent, (HPDF_PageBoundary) pageBoundary, box.getLeft(), box.getBottom(), box.getRight(), box.getTop());
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(HPDF_Page_SetBoundary(__content(), (HPDF_PageBoundary) pageBoundary, box.getLeft(), box.getBottom(), box.getRight(), box.getTop()));
 }
 
 void Page::setSize(PageSize size, PageOrientation orientation) {
-    HPDF_Page_SetSize(__innerContent, (HPDF_PageSizes) size, (HPDF_PageDirection) orientation);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(HPDF_Page_SetSize(__content(), (HPDF_PageSizes) size, (HPDF_PageDirection) orientation));
 }
 
 void Page::setRotation(PageRotation rotation) {
-    HPDF_Page_SetRotate(__innerContent, (unsigned short) rotation);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(HPDF_Page_SetRotate(__content(), (unsigned short) rotation));
 }
 
 float Page::getWidth() const {
-    return HPDF_Page_GetWidth(__innerContent);
+    return __haruppCheck(HPDF_Page_GetWidth(__content()));
 }
 
 float Page::getHeight() const {
-    return HPDF_Page_GetHeight(__innerContent);
+    return __haruppCheck(HPDF_Page_GetHeight(__content()));
 }
 
 Destination Page::createDestination() {
-    return Destination(HPDF_Page_CreateDestination(__innerContent));
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    return Destination(__haruppCheck(HPDF_Page_CreateDestination(__content())));
 }
 
 TextAnnotation Page::createTextAnnotation(const std::string& text, const Box& box, const Encoder& encoder) {
-    return TextAnnotation(HPDF_Page_CreateTextAnnot(__innerContent, __toRect(box), text.c_str(), encoder.__innerContent));
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    return TextAnnotation(__haruppCheck(HPDF_Page_CreateTextAnnot(__content(), __toRect(box), text.c_str(), encoder.__innerContent)), __generation);
 }
 
 TextAnnotation Page::createTextAnnotation(const std::string& text, const Box& box) {
-    return TextAnnotation(HPDF_Page_CreateTextAnnot(__innerContent, __toRect(box), text.c_str(), nullptr));
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    return TextAnnotation(__haruppCheck(HPDF_Page_CreateTextAnnot(__content(), __toRect(box), text.c_str(), nullptr)), __generation);
 }
 
 LinkAnnotation Page::createLinkAnnotation(const Destination& destination, const Box& box) {
-    return LinkAnnotation(HPDF_Page_CreateLinkAnnot(__innerContent, __toRect(box), destination.__innerContent));
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    return LinkAnnotation(__haruppCheck(HPDF_Page_CreateLinkAnnot(__content(), __toRect(box), destination.__innerContent)), __generation);
 }
 
 LinkAnnotation Page::createURILinkAnnotation(const std::string& uri, const Box& box) {
-    return LinkAnnotation(HPDF_Page_CreateURILinkAnnot(__innerContent, __toRect(box), uri.c_str()));
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    return LinkAnnotation(__haruppCheck(HPDF_Page_CreateURILinkAnnot(__content(), __toRect(box), uri.c_str())), __generation);
 }
 
 float Page::getTextWidth(const std::string& text) const {
-    return HPDF_Page_TextWidth(__innerContent, text.c_str());
+    return __haruppCheck(HPDF_Page_TextWidth(__content(), text.c_str()));
 }
 
 std::pair<unsigned int, float> Page::measureText(const std::string& text, float width, bool wordWrap) const {
     float realWidth;
-    unsigned int val = HPDF_Page_MeasureText(__innerContent, text.c_str(), width, wordWrap, &realWidth);
+    unsigned int val = __haruppCheck(HPDF_Page_MeasureText(__content(), text.c_str(), width, wordWrap, &realWidth));
     return {val, realWidth};
 }
 
 GraphicsMode Page::getGraphicsMode() const {
-    switch (HPDF_Page_GetGMode(__innerContent)) {
+    switch (HPDF_Page_GetGMode(__content())) {
         case HPDF_GMODE_PAGE_DESCRIPTION: return GraphicsMode::PAGE_DESCRIPTION;
         case HPDF_GMODE_PATH_OBJECT: return GraphicsMode::PATH_OBJECT;
         case HPDF_GMODE_TEXT_OBJECT: return GraphicsMode::TEXT_OBJECT;
@@ -122,34 +307,34 @@ GraphicsMode Page::getGraphicsMode() const {
 }
 
 Coor2D Page::getCurrentPos() const {
-    HPDF_Point point = HPDF_Page_GetCurrentPos(__innerContent);
+    HPDF_Point point = __haruppCheck(HPDF_Page_GetCurrentPos(__content()));
     return Coor2D(point.x, point.y);
 }
 
 Coor2D Page::getCurrentTextPos() const {
-    HPDF_Point point = HPDF_Page_GetCurrentTextPos(__innerContent);
+    HPDF_Point point = __haruppCheck(HPDF_Page_GetCurrentTextPos(__content()));
     return Coor2D(point.x, point.y);
 }
 
 Font Page::getCurrentFont() const {
-    return Font(HPDF_Page_GetCurrentFont(__innerContent));
+    return Font(__haruppCurrentGState(__content(), __state).font, __generation);
 }
 
 float Page::getCurrentFontSize() const {
-    return HPDF_Page_GetCurrentFontSize(__innerContent);
+    return __haruppCurrentGState(__content(), __state).fontSize;
 }
 
 TransposeMatrix Page::getTransposeMatrix() const {
-    HPDF_TransMatrix matrix = HPDF_Page_GetTransMatrix(__innerContent);
+    HPDF_TransMatrix matrix = __haruppCheck(HPDF_Page_GetTransMatrix(__content()));
     return TransposeMatrix(matrix.a, matrix.b, matrix.c, matrix.d, matrix.x, matrix.y);
 }
 
 float Page::getLineWidth() const {
-    return HPDF_Page_GetLineWidth(__innerContent);
+    return __haruppCurrentGState(__content(), __state).lineWidth;
 }
 
 LineCap Page::getLineCap() const {
-    switch (HPDF_Page_GetLineCap(__innerContent)) {
+    switch (__haruppCurrentGState(__content(), __state).lineCap) {
         case HPDF_BUTT_END: return LineCap::BUTT_END;
         case HPDF_ROUND_END: return LineCap::ROUND_END;
         case HPDF_PROJECTING_SQUARE_END: return LineCap::PROJECTING_SQUARE_END;
@@ -158,7 +343,7 @@ LineCap Page::getLineCap() const {
 }
 
 LineJoin Page::getLineJoin() const {
-    switch (HPDF_Page_GetLineJoin(__innerContent)) {
+    switch (__haruppCurrentGState(__content(), __state).lineJoin) {
         case HPDF_MITER_JOIN: return LineJoin::MITER_JOIN;
         case HPDF_ROUND_JOIN: return LineJoin::ROUND_JOIN;
         case HPDF_BEVEL_JOIN: return LineJoin::BEVEL_JOIN;
@@ -167,11 +352,11 @@ LineJoin Page::getLineJoin() const {
 }
 
 float Page::getMiterLimit() const {
-    return HPDF_Page_GetMiterLimit(__innerContent);
+    return __haruppCurrentGState(__content(), __state).miterLimit;
 }
 
 DashMode Page::getDash() const {
-    HPDF_DashMode mode = HPDF_Page_GetDash(__innerContent);
+    HPDF_DashMode mode = __haruppCheck(HPDF_Page_GetDash(__content()));
     DashMode dashMode;
     dashMode.points = __vectorFromValues(mode.num_ptn, mode.ptn);
     dashMode.phase = mode.phase;
@@ -179,31 +364,32 @@ DashMode Page::getDash() const {
 }
 
 float Page::getFlatness() const {
-    return HPDF_Page_GetFlat(__innerContent);
+    return __haruppCheck(HPDF_Page_GetFlat(__content()));
 }
 
 float Page::getCharSpace() const {
-    return HPDF_Page_GetCharSpace(__innerContent);
+    return __haruppCurrentGState(__content(), __state).charSpace;
 }
 
 float Page::getWordSpace() const {
-    return HPDF_Page_GetWordSpace(__innerContent);
+    return __haruppCurrentGState(__content(), __state).wordSpace;
 }
 
 float Page::getHorizontalScaling() const {
-    return HPDF_Page_GetHorizontalScalling(__innerContent);
+    return __haruppCurrentGState(__content(), __state).horizontalScaling;
 }
 
 float Page::getTextLeading() const {
-    return HPDF_Page_GetTextLeading(__innerContent);
+    return __haruppCurrentGState(__content(), __state).textLeading;
 }
 
 void Page::setZoom(float zoom) {
-    HPDF_Page_SetZoom(__innerContent, zoom);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(HPDF_Page_SetZoom(__content(), zoom));
 }
 
 TextRenderingMode Page::getTextRenderingMode() const {
-    switch (HPDF_Page_GetTextRenderingMode(__innerContent)) {
+    switch (__haruppCurrentGState(__content(), __state).renderingMode) {
         case HPDF_FILL: return TextRenderingMode::FILL;
         case HPDF_STROKE: return TextRenderingMode::STROKE;
         case HPDF_FILL_THEN_STROKE: return TextRenderingMode::FILL_THEN_STROKE;
@@ -217,299 +403,543 @@ TextRenderingMode Page::getTextRenderingMode() const {
 }
 
 float Page::getTextRise() const {
-    return HPDF_Page_GetTextRise(__innerContent);
+    return __haruppCurrentGState(__content(), __state).textRise;
 }
 
 RGBColor Page::getRGBFill() const {
-    HPDF_RGBColor color = HPDF_Page_GetRGBFill(__innerContent);
+    const __HaruppGState& current = __haruppCurrentGState(__content(), __state);
+    // Same as LibHaru, the color is only given in its own color space
+    if (current.fillColorSpace != HPDF_CS_DEVICE_RGB) return RGBColor(0.f, 0.f, 0.f);
+    HPDF_RGBColor color = current.rgbFill;
     return RGBColor(color.r, color.g, color.b);
 }
 
 RGBColor Page::getRGBStroke() const {
-    HPDF_RGBColor color = HPDF_Page_GetRGBStroke(__innerContent);
+    const __HaruppGState& current = __haruppCurrentGState(__content(), __state);
+    // Same as LibHaru, the color is only given in its own color space
+    if (current.strokeColorSpace != HPDF_CS_DEVICE_RGB) return RGBColor(0.f, 0.f, 0.f);
+    HPDF_RGBColor color = current.rgbStroke;
     return RGBColor(color.r, color.g, color.b);
 }
 
 CMYKColor Page::getCMYKFill() const {
-    HPDF_CMYKColor color = HPDF_Page_GetCMYKFill(__innerContent);
+    const __HaruppGState& current = __haruppCurrentGState(__content(), __state);
+    // Same as LibHaru, the color is only given in its own color space
+    if (current.fillColorSpace != HPDF_CS_DEVICE_CMYK) return CMYKColor(0.f, 0.f, 0.f, 0.f);
+    HPDF_CMYKColor color = current.cmykFill;
     return CMYKColor(color.c, color.m, color.y, color.k);
 }
 
 CMYKColor Page::getCMYKStroke() const {
-    HPDF_CMYKColor color = HPDF_Page_GetCMYKStroke(__innerContent);
+    const __HaruppGState& current = __haruppCurrentGState(__content(), __state);
+    // Same as LibHaru, the color is only given in its own color space
+    if (current.strokeColorSpace != HPDF_CS_DEVICE_CMYK) return CMYKColor(0.f, 0.f, 0.f, 0.f);
+    HPDF_CMYKColor color = current.cmykStroke;
     return CMYKColor(color.c, color.m, color.y, color.k);
 }
 
 float Page::getGrayFill() const {
-    return HPDF_Page_GetGrayFill(__innerContent);
+    const __HaruppGState& current = __haruppCurrentGState(__content(), __state);
+    return (current.fillColorSpace == HPDF_CS_DEVICE_GRAY)? current.grayFill: 0.f;
 }
 
 float Page::getGrayStroke() const {
-    return HPDF_Page_GetGrayStroke(__innerContent);
+    const __HaruppGState& current = __haruppCurrentGState(__content(), __state);
+    return (current.strokeColorSpace == HPDF_CS_DEVICE_GRAY)? current.grayStroke: 0.f;
 }
 
 ColorSpace Page::getStrokingColorSpace() const {
-    return convertToColorSpace(HPDF_Page_GetStrokingColorSpace(__innerContent));
+    return convertToColorSpace(__haruppCurrentGState(__content(), __state).strokeColorSpace);
 }
 
 ColorSpace Page::getFillingColorSpace() const {
-    return convertToColorSpace(HPDF_Page_GetFillingColorSpace(__innerContent));
+    return convertToColorSpace(__haruppCurrentGState(__content(), __state).fillColorSpace);
 }
 
 TransposeMatrix Page::getTextMatrix() const {
-    HPDF_TransMatrix matrix = HPDF_Page_GetTextMatrix(__innerContent);
+    HPDF_TransMatrix matrix = __haruppCheck(HPDF_Page_GetTextMatrix(__content()));
     return TransposeMatrix(matrix.a, matrix.b, matrix.c, matrix.d, matrix.x, matrix.y);
 }
 
 unsigned int Page::getGStateDepth() const {
-    return HPDF_Page_GetGStateDepth(__innerContent);
+    return HPDF_Page_GetGStateDepth(__content());
+}
+
+unsigned long Page::getElidedOperatorCount() const {
+    __content();
+    return (__state == nullptr)? 0UL: __state->elidedOperators;
 }
 
 void Page::setSlideShow(TransitionStyle type, float dispTime, float transTime) {
-    HPDF_Page_SetSlideShow(__innerContent, (HPDF_TransitionStyle) type, dispTime, transTime);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(HPDF_Page_SetSlideShow(__content(), (HPDF_TransitionStyle) type, dispTime, transTime));
 }
 
 void Page::newContentStream(const ContentStream& newStream) {
-    HPDF_Page_New_Content_Stream(__innerContent, &newStream.__innerContent);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(HPDF_Page_New_Content_Stream(__content(), &newStream.__innerContent));
 }
 
 void Page::insertSharedContentStream(const ContentStream& sharedStream) {
-    HPDF_Page_Insert_Shared_Content_Stream(__innerContent, sharedStream.__innerContent);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    HPDF_Page page = __content();
+    __haruppCheck(HPDF_Page_Insert_Shared_Content_Stream(page, sharedStream.__content()));
+    // The shared stream may set anything
+    __haruppSyncState(page, __state, 0U, __HaruppGState::ALL);
+}
+
+void Page::appendPath(const PathBuilder& path) {
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(__haruppWritePath(__content(), path.operators.data(), path.operators.size(), path.operands.data()));
 }
 
 void Page::arc(const Coor2D& coors, float radius, float ang1, float ang2) {
-    HPDF_Page_Arc(__innerContent, coors.getX(), coors.getY(), radius, ang1, ang2);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(HPDF_Page_Arc(__content(), coors.getX(), coors.getY(), radius, ang1, ang2));
 }
 
 void Page::beginText() {
-    HPDF_Page_BeginText(__innerContent);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(HPDF_Page_BeginText(__content()));
 }
 
 void Page::circle(const Coor2D& coors, float radius) {
-    HPDF_Page_Circle(__innerContent, coors.getX(), coors.getY(), radius);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(HPDF_Page_Circle(__content(), coors.getX(), coors.getY(), radius));
 }
 
 void Page::clip() {
-    HPDF_Page_Clip(__innerContent);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(__haruppPaintPath(__content(), "W", true));
 }
 
 void Page::closePath() {
-    HPDF_Page_ClosePath(__innerContent);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    const char op = 'h';
+    __haruppCheck(__haruppWritePath(__content(), &op, 1U, nullptr));
 }
 
 void Page::closePathStroke() {
-    HPDF_Page_ClosePathStroke(__innerContent);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(__haruppPaintPath(__content(), "s", false));
 }
 
 void Page::closePathEofillStroke() {
-    HPDF_Page_ClosePathEofillStroke(__innerContent);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(__haruppPaintPath(__content(), "b*", false));
 }
 
 void Page::closePathFillStroke() {
-    HPDF_Page_ClosePathFillStroke(__innerContent);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(__haruppPaintPath(__content(), "b", false));
 }
 
 void Page::concat(const TransposeMatrix& matrix) {
-    HPDF_Page_Concat(__innerContent, matrix.getA(), matrix.getB(), matrix.getC(), matrix.getD(), matrix.getX(), matrix.getY());
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(HPDF_Page_Concat(__content(), matrix.getA(), matrix.getB(), matrix.getC(), matrix.getD(), matrix.getX(), matrix.getY()));
 }
 
 void Page::curve(const Coor2D& first, const Coor2D& second, const Coor2D& third) {
-    HPDF_Page_CurveTo(__innerContent, first.getX(), first.getY(), second.getX(), second.getY(), third.getX(), third.getY());
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    const float operands[] = {first.getX(), first.getY(), second.getX(), second.getY(), third.getX(), third.getY()};
+    const char op = 'c';
+    __haruppCheck(__haruppWritePath(__content(), &op, 1U, operands));
 }
 
 void Page::curveFromCurrent(const Coor2D& second, const Coor2D& third) {
-    HPDF_Page_CurveTo2(__innerContent, second.getX(), second.getY(), third.getX(), third.getY());
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    const float operands[] = {second.getX(), second.getY(), third.getX(), third.getY()};
+    const char op = 'v';
+    __haruppCheck(__haruppWritePath(__content(), &op, 1U, operands));
 }
 
 void Page::curve(const Coor2D& first, const Coor2D& third) {
-    HPDF_Page_CurveTo3(__innerContent, first.getX(), first.getY(), third.getX(), third.getY());
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    const float operands[] = {first.getX(), first.getY(), third.getX(), third.getY()};
+    const char op = 'y';
+    __haruppCheck(__haruppWritePath(__content(), &op, 1U, operands));
 }
 
 void Page::drawImage(const Image& image, const Coor2D& coors, float width, float height) {
-    HPDF_Page_DrawImage(__innerContent, image.__innerContent, coors.getX(), coors.getY(), width, height);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(HPDF_Page_DrawImage(__content(), image.__content(), coors.getX(), coors.getY(), width, height));
+}
+
+void Page::drawFormXObject(const FormXObject& form, const Coor2D& coors, float xScale, float yScale) {
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    HPDF_Page page = __content();
+    __haruppCheck(HPDF_Page_GSave(page));
+    __haruppCheck(HPDF_Page_Concat(page, xScale, 0.f, 0.f, yScale, coors.getX(), coors.getY()));
+    __haruppCheck(HPDF_Page_ExecuteXObject(page, form.__content()));
+    __haruppCheck(HPDF_Page_GRestore(page));
 }
 
 void Page::ellipse(const Coor2D& coors, float xRadius, float yRadius) {
-    HPDF_Page_Ellipse(__innerContent, coors.getX(), coors.getY(), xRadius, yRadius);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(HPDF_Page_Ellipse(__content(), coors.getX(), coors.getY(), xRadius, yRadius));
 }
 
 void Page::endPath() {
-    HPDF_Page_EndPath(__innerContent);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(__haruppPaintPath(__content(), "n", false));
 }
 
 void Page::endText() {
-    HPDF_Page_EndText(__innerContent);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(HPDF_Page_EndText(__content()));
 }
 
 void Page::eoClip() {
-    HPDF_Page_Eoclip(__innerContent);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(__haruppPaintPath(__content(), "W*", true));
 }
 
 void Page::eoFill() {
-    HPDF_Page_Eofill(__innerContent);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(__haruppPaintPath(__content(), "f*", false));
 }
 
 void Page::eoFillStroke() {
-    HPDF_Page_EofillStroke(__innerContent);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(__haruppPaintPath(__content(), "B*", false));
 }
 
 void Page::executeContentStream(const ContentStream& stream) {
-    HPDF_Page_ExecuteXObject(__innerContent, stream.__innerContent);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(HPDF_Page_ExecuteXObject(__content(), stream.__content()));
 }
 
 void Page::fill() {
-    HPDF_Page_Fill(__innerContent);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(__haruppPaintPath(__content(), "f", false));
 }
 
 void Page::fillStroke() {
-    HPDF_Page_FillStroke(__innerContent);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(__haruppPaintPath(__content(), "B", false));
 }
 
 void Page::gRestore() {
-    HPDF_Page_GRestore(__innerContent);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    HPDF_Page page = __content();
+    __haruppCheck(HPDF_Page_GRestore(page));
+    // Pops the restored state from the mirror
+    __haruppCurrentGState(page, __state);
 }
 
 void Page::gSave() {
-    HPDF_Page_GSave(__innerContent);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    HPDF_Page page = __content();
+    __haruppCheck(HPDF_Page_GSave(page));
+    // Pushes a copy of the saved state on the mirror
+    __haruppCurrentGState(page, __state);
 }
 
 void Page::lineTo(const Coor2D& coors) {
-    HPDF_Page_LineTo(__innerContent, coors.getX(), coors.getY());
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    const float operands[] = {coors.getX(), coors.getY()};
+    const char op = 'l';
+    __haruppCheck(__haruppWritePath(__content(), &op, 1U, operands));
 }
 
 void Page::moveTextPos(const Coor2D& offset, bool invertTextLeading) {
-    if (invertTextLeading) HPDF_Page_MoveTextPos2(__innerContent, offset.getX(), offset.getY());
-    else HPDF_Page_MoveTextPos(__innerContent, offset.getX(), offset.getY());
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    if (invertTextLeading) __haruppCheck(HPDF_Page_MoveTextPos2(__content(), offset.getX(), offset.getY()));
+    else __haruppCheck(HPDF_Page_MoveTextPos(__content(), offset.getX(), offset.getY()));
 }
 
 void Page::moveTo(const Coor2D& coors) {
-    HPDF_Page_MoveTo(__innerContent, coors.getX(), coors.getY());
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    const float operands[] = {coors.getX(), coors.getY()};
+    const char op = 'm';
+    __haruppCheck(__haruppWritePath(__content(), &op, 1U, operands));
 }
 
 void Page::moveToNextLine() {
-    HPDF_Page_MoveToNextLine(__innerContent);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(HPDF_Page_MoveToNextLine(__content()));
 }
 
-void Page::rectangle(const Coor2D& lowerLeftCoors, float width, float height) {
-    HPDF_Page_Rectangle(__innerContent, lowerLeftCoors.getX(), lowerLeftCoors.getY(), width, height);
+void Page::multiLine(const Coor2D* points, std::size_t count) {
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    if (count % 2U != 0U) throw excepts::InvalidParameterException();
+    __haruppCheck(__haruppWritePoints(__content(), points, count, __HaruppPointPath::SEGMENTS));
 }
 
-void Page::setCharSpace(float value) {
-    HPDF_Page_SetCharSpace(__innerContent, value);
+void Page::multiLine(const std::vector<Coor2D>& points) {
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    multiLine(points.data(), points.size());
+}
+
+void Page::polygon(const Coor2D* points, std::size_t count) {
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(__haruppWritePoints(__content(), points, count, __HaruppPointPath::POLYGON));
 }
 
-void Page::setCMYKFill(const CMYKColor& color) {
-    HPDF_Page_SetCMYKFill(__innerContent, color.getC(), color.getM(), color.getY(), color.getK());
+void Page::polygon(const std::vector<Coor2D>& points) {
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    polygon(points.data(), points.size());
 }
 
-void Page::setCMYKStroke(const CMYKColor& color) {
-    HPDF_Page_SetCMYKStroke(__innerContent, color.getC(), color.getM(), color.getY(), color.getK());
+void Page::polyline(const Coor2D* points, std::size_t count) {
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(__haruppWritePoints(__content(), points, count, __HaruppPointPath::POLYLINE));
+}
+
+void Page::polyline(const std::vector<Coor2D>& points) {
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    polyline(points.data(), points.size());
+}
+
+void Page::rectangle(const Coor2D& lowerLeftCoors, float width, float height) {
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    const float operands[] = {lowerLeftCoors.getX(), lowerLeftCoors.getY(), width, height};
+    const char op = 'r';
+    __haruppCheck(__haruppWritePath(__content(), &op, 1U, operands));
+}
+
+void Page::setCharSpace(float value) {
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    HPDF_Page page = __content();
+    if (__haruppSkipState(page, __state, __HaruppGState::CHAR_SPACE, __haruppCurrentGState(page, __state).charSpace == value)) return;
+    __haruppCheck(HPDF_Page_SetCharSpace(page, value));
+    __haruppSyncState(page, __state, __HaruppGState::CHAR_SPACE);
+}
+
+void Page::setCMYKFill(const CMYKValue& color) {
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    HPDF_Page page = __content();
+    const __HaruppGState& current = __haruppCurrentGState(page, __state);
+    bool unchanged = current.fillColorSpace == HPDF_CS_DEVICE_CMYK && current.cmykFill.c == color.getC() && current.cmykFill.m == color.getM()
+        && current.cmykFill.y == color.getY() && current.cmykFill.k == color.getK();
+    if (__haruppSkipState(page, __state, __HaruppGState::FILL_COLOR, unchanged)) return;
+    if (__haruppCheck(__haruppWriteState(page, "k", {color.getC(), color.getM(), color.getY(), color.getK()}, 1.f)) != HPDF_OK) return;
+    HPDF_GState gState = ((HPDF_PageAttr) page->attr)->gstate;
+    gState->cmyk_fill = {color.getC(), color.getM(), color.getY(), color.getK()};
+    gState->cs_fill = HPDF_CS_DEVICE_CMYK;
+    __haruppSyncState(page, __state, __HaruppGState::FILL_COLOR);
+}
+
+void Page::setCMYKStroke(const CMYKValue& color) {
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    HPDF_Page page = __content();
+    const __HaruppGState& current = __haruppCurrentGState(page, __state);
+    bool unchanged = current.strokeColorSpace == HPDF_CS_DEVICE_CMYK && current.cmykStroke.c == color.getC() && current.cmykStroke.m == color.getM()
+        && current.cmykStroke.y == color.getY() && current.cmykStroke.k == color.getK();
+    if (__haruppSkipState(page, __state, __HaruppGState::STROKE_COLOR, unchanged)) return;
+    if (__haruppCheck(__haruppWriteState(page, "K", {color.getC(), color.getM(), color.getY(), color.getK()}, 1.f)) != HPDF_OK) return;
+    HPDF_GState gState = ((HPDF_PageAttr) page->attr)->gstate;
+    gState->cmyk_stroke = {color.getC(), color.getM(), color.getY(), color.getK()};
+    gState->cs_stroke = HPDF_CS_DEVICE_CMYK;
+    __haruppSyncState(page, __state, __HaruppGState::STROKE_COLOR);
 }
 
 void Page::setDash(const DashMode& mode) {
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
     std::vector<float> points = mode.getPoints();
-    HPDF_Page_SetDash(__innerContent, points.data(), points.size(), mode.getPhase());
+    __haruppCheck(HPDF_Page_SetDash(__content(), points.data(), points.size(), mode.getPhase()));
 }
 
 void Page::setExternGState(const ContentStream& stream) {
-    HPDF_Page_SetExtGState(__innerContent, stream.__innerContent);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    HPDF_Page page = __content();
+    __haruppCheck(HPDF_Page_SetExtGState(page, stream.__content()));
+    // An extended graphics state may hold line and font parameters
+    unsigned int unknown = __HaruppGState::LINE_WIDTH | __HaruppGState::LINE_CAP | __HaruppGState::LINE_JOIN | __HaruppGState::MITER_LIMIT | __HaruppGState::FONT;
+    __haruppSyncState(page, __state, 0U, unknown);
 }
 
 void Page::setFontAndSize(const Font& font, float size) {
-    HPDF_Page_SetFontAndSize(__innerContent, font.__innerContent, size);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    HPDF_Page page = __content();
+    HPDF_Font fontContent = font.__content();
+    const __HaruppGState& current = __haruppCurrentGState(page, __state);
+    bool unchanged = fontContent != nullptr && current.font == fontContent && current.fontSize == size;
+    if (__haruppSkipState(page, __state, __HaruppGState::FONT, unchanged)) return;
+    __haruppCheck(HPDF_Page_SetFontAndSize(page, fontContent, size));
+    __haruppSyncState(page, __state, __HaruppGState::FONT);
 }
 
 void Page::setGrayFill(float gray) {
-    HPDF_Page_SetGrayFill(__innerContent, gray);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    HPDF_Page page = __content();
+    const __HaruppGState& current = __haruppCurrentGState(page, __state);
+    bool unchanged = current.fillColorSpace == HPDF_CS_DEVICE_GRAY && current.grayFill == gray;
+    if (__haruppSkipState(page, __state, __HaruppGState::FILL_COLOR, unchanged)) return;
+    if (__haruppCheck(__haruppWriteState(page, "g", {gray}, 1.f)) != HPDF_OK) return;
+    HPDF_GState gState = ((HPDF_PageAttr) page->attr)->gstate;
+    gState->gray_fill = gray;
+    gState->cs_fill = HPDF_CS_DEVICE_GRAY;
+    __haruppSyncState(page, __state, __HaruppGState::FILL_COLOR);
 }
 
 void Page::setGrayStroke(float gray) {
-    HPDF_Page_SetGrayStroke(__innerContent, gray);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    HPDF_Page page = __content();
+    const __HaruppGState& current = __haruppCurrentGState(page, __state);
+    bool unchanged = current.strokeColorSpace == HPDF_CS_DEVICE_GRAY && current.grayStroke == gray;
+    if (__haruppSkipState(page, __state, __HaruppGState::STROKE_COLOR, unchanged)) return;
+    if (__haruppCheck(__haruppWriteState(page, "G", {gray}, 1.f)) != HPDF_OK) return;
+    HPDF_GState gState = ((HPDF_PageAttr) page->attr)->gstate;
+    gState->gray_stroke = gray;
+    gState->cs_stroke = HPDF_CS_DEVICE_GRAY;
+    __haruppSyncState(page, __state, __HaruppGState::STROKE_COLOR);
 }
 
 void Page::setHorizontalScaling(float value) {
-    HPDF_Page_SetHorizontalScalling(__innerContent, value);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    HPDF_Page page = __content();
+    if (__haruppSkipState(page, __state, __HaruppGState::HORIZONTAL_SCALING, __haruppCurrentGState(page, __state).horizontalScaling == value)) return;
+    __haruppCheck(HPDF_Page_SetHorizontalScalling(page, value));
+    __haruppSyncState(page, __state, __HaruppGState::HORIZONTAL_SCALING);
 }
 
 void Page::setLineCap(LineCap lineCap) {
-    HPDF_Page_SetLineCap(__innerContent, (HPDF_LineCap) lineCap);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    HPDF_Page page = __content();
+    if (__haruppSkipState(page, __state, __HaruppGState::LINE_CAP, __haruppCurrentGState(page, __state).lineCap == (HPDF_LineCap) lineCap)) return;
+    __haruppCheck(HPDF_Page_SetLineCap(page, (HPDF_LineCap) lineCap));
+    __haruppSyncState(page, __state, __HaruppGState::LINE_CAP);
 }
 
 void Page::setLineJoin(LineJoin lineJoin) {
-    HPDF_Page_SetLineJoin(__innerContent, (HPDF_LineJoin) lineJoin);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    HPDF_Page page = __content();
+    if (__haruppSkipState(page, __state, __HaruppGState::LINE_JOIN, __haruppCurrentGState(page, __state).lineJoin == (HPDF_LineJoin) lineJoin)) return;
+    __haruppCheck(HPDF_Page_SetLineJoin(page, (HPDF_LineJoin) lineJoin));
+    __haruppSyncState(page, __state, __HaruppGState::LINE_JOIN);
 }
 
 void Page::setLineWidth(float lineWidth) {
-    HPDF_Page_SetLineWidth(__innerContent, lineWidth);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    HPDF_Page page = __content();
+    if (__haruppSkipState(page, __state, __HaruppGState::LINE_WIDTH, __haruppCurrentGState(page, __state).lineWidth == lineWidth)) return;
+    if (__haruppCheck(__haruppWriteState(page, "w", {lineWidth}, std::numeric_limits<float>::infinity())) != HPDF_OK) return;
+    ((HPDF_PageAttr) page->attr)->gstate->line_width = lineWidth;
+    __haruppSyncState(page, __state, __HaruppGState::LINE_WIDTH);
 }
 
 void Page::setMiterLimit(float miterLimit) {
-    HPDF_Page_SetMiterLimit(__innerContent, miterLimit);
-}
-
-void Page::setRGBFill(const RGBColor& color) {
-    HPDF_Page_SetRGBFill(__innerContent, color.getR(), color.getG(), color.getB());
-}
-
-void Page::setRGBStroke(const RGBColor& color) {
-    HPDF_Page_SetRGBStroke(__innerContent, color.getR(), color.getG(), color.getB());
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    HPDF_Page page = __content();
+    if (__haruppSkipState(page, __state, __HaruppGState::MITER_LIMIT, __haruppCurrentGState(page, __state).miterLimit == miterLimit)) return;
+    __haruppCheck(HPDF_Page_SetMiterLimit(page, miterLimit));
+    __haruppSyncState(page, __state, __HaruppGState::MITER_LIMIT);
+}
+
+void Page::setRGBFill(const RGBValue& color) {
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    HPDF_Page page = __content();
+    const __HaruppGState& current = __haruppCurrentGState(page, __state);
+    bool unchanged = current.fillColorSpace == HPDF_CS_DEVICE_RGB && current.rgbFill.r == color.getR() && current.rgbFill.g == color.getG()
+        && current.rgbFill.b == color.getB();
+    if (__haruppSkipState(page, __state, __HaruppGState::FILL_COLOR, unchanged)) return;
+    if (__haruppCheck(__haruppWriteState(page, "rg", {color.getR(), color.getG(), color.getB()}, 1.f)) != HPDF_OK) return;
+    HPDF_GState gState = ((HPDF_PageAttr) page->attr)->gstate;
+    gState->rgb_fill = {color.getR(), color.getG(), color.getB()};
+    gState->cs_fill = HPDF_CS_DEVICE_RGB;
+    __haruppSyncState(page, __state, __HaruppGState::FILL_COLOR);
+}
+
+void Page::setRGBStroke(const RGBValue& color) {
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    HPDF_Page page = __content();
+    const __HaruppGState& current = __haruppCurrentGState(page, __state);
+    bool unchanged = current.strokeColorSpace == HPDF_CS_DEVICE_RGB && current.rgbStroke.r == color.getR() && current.rgbStroke.g == color.getG()
+        && current.rgbStroke.b == color.getB();
+    if (__haruppSkipState(page, __state, __HaruppGState::STROKE_COLOR, unchanged)) return;
+    if (__haruppCheck(__haruppWriteState(page, "RG", {color.getR(), color.getG(), color.getB()}, 1.f)) != HPDF_OK) return;
+    HPDF_GState gState = ((HPDF_PageAttr) page->attr)->gstate;
+    gState->rgb_stroke = {color.getR(), color.getG(), color.getB()};
+    gState->cs_stroke = HPDF_CS_DEVICE_RGB;
+    __haruppSyncState(page, __state, __HaruppGState::STROKE_COLOR);
 }
 
 void Page::setTextLeading(float value) {
-    HPDF_Page_SetTextLeading(__innerContent, value);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    HPDF_Page page = __content();
+    if (__haruppSkipState(page, __state, __HaruppGState::TEXT_LEADING, __haruppCurrentGState(page, __state).textLeading == value)) return;
+    __haruppCheck(HPDF_Page_SetTextLeading(page, value));
+    __haruppSyncState(page, __state, __HaruppGState::TEXT_LEADING);
 }
 
 void Page::setTextMatrix(const TransposeMatrix& matrix) {
-    HPDF_Page_SetTextMatrix(__innerContent, matrix.getA(), matrix.getB(), matrix.getC(), matrix.getD(), matrix.getX(), matrix.getY());
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(HPDF_Page_SetTextMatrix(__content(), matrix.getA(), matrix.getB(), matrix.getC(), matrix.getD(), matrix.getX(), matrix.getY()));
 }
 
 void Page::setTextRenderingMode(TextRenderingMode mode) {
-    HPDF_Page_SetTextRenderingMode(__innerContent, (HPDF_TextRenderingMode) mode);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    HPDF_Page page = __content();
+    if (__haruppSkipState(page, __state, __HaruppGState::RENDERING_MODE, __haruppCurrentGState(page, __state).renderingMode == (HPDF_TextRenderingMode) mode)) return;
+    __haruppCheck(HPDF_Page_SetTextRenderingMode(page, (HPDF_TextRenderingMode) mode));
+    __haruppSyncState(page, __state, __HaruppGState::RENDERING_MODE);
 }
 
 void Page::setTextRise(float value) {
-    HPDF_Page_SetTextRise(__innerContent, value);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    HPDF_Page page = __content();
+    if (__haruppSkipState(page, __state, __HaruppGState::TEXT_RISE, __haruppCurrentGState(page, __state).textRise == value)) return;
+    __haruppCheck(HPDF_Page_SetTextRise(page, value));
+    __haruppSyncState(page, __state, __HaruppGState::TEXT_RISE);
 }
 
 void Page::setWordSpace(float value) {
-    HPDF_Page_SetWordSpace(__innerContent, value);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    HPDF_Page page = __content();
+    if (__haruppSkipState(page, __state, __HaruppGState::WORD_SPACE, __haruppCurrentGState(page, __state).wordSpace == value)) return;
+    __haruppCheck(HPDF_Page_SetWordSpace(page, value));
+    __haruppSyncState(page, __state, __HaruppGState::WORD_SPACE);
 }
 
 void Page::showText(const std::string& text) {
-    HPDF_Page_ShowText(__innerContent, text.c_str());
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(HPDF_Page_ShowText(__content(), text.c_str()));
 }
 
 void Page::showTextNewLine(const std::string& text) {
-    HPDF_Page_ShowTextNextLine(__innerContent, text.c_str());
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(HPDF_Page_ShowTextNextLine(__content(), text.c_str()));
 }
 
 void Page::showTextNewLine(float wordSpace, float charSpace, const std::string& text) {
-    HPDF_Page_ShowTextNextLineEx(__innerContent, wordSpace, charSpace, text.c_str());
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    HPDF_Page page = __content();
+    __haruppCheck(HPDF_Page_ShowTextNextLineEx(page, wordSpace, charSpace, text.c_str()));
+    __haruppSyncState(page, __state, __HaruppGState::WORD_SPACE | __HaruppGState::CHAR_SPACE);
 }
 
 void Page::stroke() {
-    HPDF_Page_Stroke(__innerContent);
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(__haruppPaintPath(__content(), "S", false));
 }
 
 void Page::textOut(const std::string& text, const Coor2D& position) {
-    HPDF_Page_TextOut(__innerContent, position.getX(), position.getY(), text.c_str());
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    __haruppCheck(HPDF_Page_TextOut(__content(), position.getX(), position.getY(), text.c_str()));
 }
 
 void Page::textOut(const std::string& text) {
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
     textOut(text, getCurrentTextPos());
 }
 
 std::pair<unsigned int, bool> Page::textRect(const Box& box, const std::string& text, TextAlignment alignment) {
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
+    HPDF_Page page = __content();
     unsigned int length;
-    unsigned long status = HPDF_Page_TextRect(
-        __innerContent, box.getLeft(), box.getTop(), box.getRight(), box.getBottom(),
+    unsigned long status = __haruppCheck(HPDF_Page_TextRect(
+        page, box.getLeft(), box.getTop(), box.getRight(), box.getBottom(),
         text.c_str(), (HPDF_TextAlignment) alignment, &length
-    );
+    ));
+    // Justified text changes the spacing behind the mirror's back
+    __haruppSyncState(page, __state, 0U, __HaruppGState::WORD_SPACE | __HaruppGState::CHAR_SPACE);
 
     return {length, (status != HPDF_PAGE_INSUFFICIENT_SPACE)};
 }
 
 void Page::writeText(const std::string& text, const Coor2D& position) {
+    __HaruppMemoryScope scope(__content(), MemoryCategory::PAGES);
     beginText();
     textOut(text, position);
     endText();
@@ -0,0 +1,53 @@
+#include "../include/PageSpec.hpp"
+using namespace pdf;
+using namespace pdf::enums;
+
+
+PageSpec::PageSpec() noexcept {}
+
+PageSpec::PageSpec(PageSize size, PageOrientation orientation, PageRotation rotation) noexcept:
+    size(size), orientation(orientation), predefinedSize(true), rotation(rotation) {}
+
+PageSpec::PageSpec(float width, float height, PageRotation rotation) noexcept: width(width), height(height), rotation(rotation) {}
+
+void PageSpec::setBoundary(PageBoundary pageBoundary, const Box& box) noexcept {
+    boundaries[(int) pageBoundary] = box;
+}
+
+void PageSpec::setRotation(PageRotation rotation) noexcept {
+    this->rotation = rotation;
+}
+
+Box PageSpec::getBoundary(PageBoundary pageBoundary) const noexcept {
+    return boundaries[(int) pageBoundary];
+}
+
+PageRotation PageSpec::getRotation() const noexcept {
+    return rotation;
+}
+
+bool PageSpec::hasPredefinedSize() const noexcept {
+    return predefinedSize;
+}
+
+PageSize PageSpec::getSize() const noexcept {
+    return size;
+}
+
+PageOrientation PageSpec::getOrientation() const noexcept {
+    return orientation;
+}
+
+float PageSpec::getWidth() const noexcept {
+    return width;
+}
+
+float PageSpec::getHeight() const noexcept {
+    return height;
+}
+
+bool PageSpec::isEmpty() const noexcept {
+    if (predefinedSize || width != 0.f || height != 0.f || rotation != PageRotation::NONE) return false;
+    for (const Box& box: boundaries) if (!box.isEmpty()) return false;
+    return true;
+}
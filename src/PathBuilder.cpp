@@ -0,0 +1,66 @@
+#include "../include/PathBuilder.hpp"
+using namespace pdf;
+
+
+PathBuilder::PathBuilder() noexcept {}
+
+PathBuilder& PathBuilder::moveTo(const Coor2D& coors) {
+    operators.push_back('m');
+    operands.insert(operands.end(), {coors.getX(), coors.getY()});
+    return *this;
+}
+
+PathBuilder& PathBuilder::lineTo(const Coor2D& coors) {
+    operators.push_back('l');
+    operands.insert(operands.end(), {coors.getX(), coors.getY()});
+    return *this;
+}
+
+PathBuilder& PathBuilder::curveTo(const Coor2D& first, const Coor2D& second, const Coor2D& third) {
+    operators.push_back('c');
+    operands.insert(operands.end(), {first.getX(), first.getY(), second.getX(), second.getY(), third.getX(), third.getY()});
+    return *this;
+}
+
+PathBuilder& PathBuilder::closePath() {
+    operators.push_back('h');
+    return *this;
+}
+
+PathBuilder& PathBuilder::rectangle(const Coor2D& lowerLeftCoors, float width, float height) {
+    operators.push_back('r');
+    operands.insert(operands.end(), {lowerLeftCoors.getX(), lowerLeftCoors.getY(), width, height});
+    return *this;
+}
+
+PathBuilder& PathBuilder::polyline(const Coor2D* points, std::size_t count) {
+    if (count == 0U) return *this;
+    operators.reserve(operators.size() + count);
+    operands.reserve(operands.size() + 2U * count);
+    moveTo(points[0]);
+    for (std::size_t i = 1U; i < count; ++i) lineTo(points[i]);
+    return *this;
+}
+
+PathBuilder& PathBuilder::polygon(const Coor2D* points, std::size_t count) {
+    if (count == 0U) return *this;
+    return polyline(points, count).closePath();
+}
+
+void PathBuilder::reserve(std::size_t operatorCount) {
+    operators.reserve(operatorCount);
+    operands.reserve(2U * operatorCount);
+}
+
+void PathBuilder::clear() noexcept {
+    operators.clear();
+    operands.clear();
+}
+
+std::size_t PathBuilder::getOperatorCount() const noexcept {
+    return operators.size();
+}
+
+bool PathBuilder::isEmpty() const noexcept {
+    return operators.empty();
+}
@@ -0,0 +1,34 @@
+#include "../include/PendingImage.hpp"
+#include "../include/Document.hpp"
+#include "ImageDecoder.hpp"
+using namespace pdf;
+
+
+PendingImage::PendingImage() noexcept: image(nullptr) {}
+
+PendingImage::PendingImage(std::shared_ptr<__HaruppImageJob> job, const Image& image) noexcept: job(std::move(job)), image(image) {}
+
+bool PendingImage::isReady() const {
+    if (job == nullptr) return true;
+    std::lock_guard<std::mutex> lock(job->mutex);
+    return job->done;
+}
+
+void PendingImage::wait() const {
+    if (job == nullptr) return;
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->finished.wait(lock, [this] { return job->done; });
+}
+
+const Image& PendingImage::getImage() const noexcept {
+    return image;
+}
+
+Image PendingImage::get() {
+    if (job != nullptr) Document::__resolveImage(*job);
+    return image;
+}
+
+bool PendingImage::isEmpty() const noexcept {
+    return job == nullptr;
+}
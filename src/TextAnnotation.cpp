@@ -1,14 +1,15 @@
 #include "../include/TextAnnotation.hpp"
+#include "ErrorHandler.hpp"
 #include "hpdf.h"
 using namespace pdf;
 
 
-TextAnnotation::TextAnnotation(_HPDF_Dict_Rec* content) noexcept: Annotation(content) {}
+TextAnnotation::TextAnnotation(_HPDF_Dict_Rec* content, const std::atomic<unsigned int>* generation) noexcept: Annotation(content, generation) {}
 
 void TextAnnotation::setIcon(enums::AnnotationIcon icon) {
-    HPDF_TextAnnot_SetIcon(__innerContent, (HPDF_AnnotIcon) icon);
+    __haruppCheck(HPDF_TextAnnot_SetIcon(__content(), (HPDF_AnnotIcon) icon));
 }
 
 void TextAnnotation::setOpen(bool opened) {
-    HPDF_TextAnnot_SetOpened(__innerContent, opened);
+    __haruppCheck(HPDF_TextAnnot_SetOpened(__content(), opened));
 }
@@ -0,0 +1,144 @@
+#include "../include/ThreadPool.hpp"
+using namespace pdf;
+
+
+/****************************** HELPERS ******************************/
+static thread_local const ThreadPool* __currentPool = nullptr;
+static thread_local int __currentWorkerIndex = -1;
+
+
+/******************** CONSTRUCTORS & DESTRUCTOR ********************/
+
+ThreadPool::ThreadPool(unsigned int threadCount, std::size_t capacity): capacity(capacity) {
+    if (threadCount == 0U) threadCount = std::thread::hardware_concurrency();
+    if (threadCount == 0U) threadCount = 1U;
+
+    workers.reserve(threadCount);
+    for (unsigned int i = 0U; i < threadCount; ++i) workers.push_back(std::make_unique<Worker>());
+    threads.reserve(threadCount);
+    for (unsigned int i = 0U; i < threadCount; ++i) threads.emplace_back(&ThreadPool::__run, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (std::thread& thread: threads) thread.join();
+}
+
+
+/******************** TASKS ********************/
+
+void ThreadPool::__push(Task&& task) {
+    // Called with the pool mutex held, so that a worker checking for queued tasks cannot miss this one.
+    // Workers keep their own tasks, others are spread in turn
+    unsigned int index = (__currentPool == this)? (unsigned int) __currentWorkerIndex:
+        nextWorker.fetch_add(1U, std::memory_order_relaxed) % workers.size();
+    std::lock_guard<std::mutex> lock(workers[index]->mutex);
+    workers[index]->tasks.push_back(std::move(task));
+    queuedCount.fetch_add(1U, std::memory_order_relaxed);
+}
+
+bool ThreadPool::__pop(unsigned int index, Task& task) {
+    // Own queue first, newest task first for cache locality
+    {
+        Worker& worker = *workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.tasks.empty()) {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+            queuedCount.fetch_sub(1U, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    // Then steal the oldest task of another worker
+    for (std::size_t i = 1U; i < workers.size(); ++i) {
+        Worker& victim = *workers[(index + i) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queuedCount.fetch_sub(1U, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::__run(unsigned int index) {
+    __currentPool = this;
+    __currentWorkerIndex = (int) index;
+
+    Task task;
+    while (true) {
+        if (__pop(index, task)) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                --pendingCount;
+                ++activeCount;
+            }
+            spaceAvailable.notify_one();
+
+            // Not caught, so that a failing task terminates like a failing std::thread rather than going unnoticed
+            task();
+            task = nullptr;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            --activeCount;
+            if (pendingCount == 0U && activeCount == 0U) allDone.notify_all();
+            continue;
+        }
+
+        // Nothing to run or steal: sleep until a task is queued. Tasks are queued under the pool mutex, so a task
+        // counted here is in a queue and is looked for again rather than waited for
+        std::unique_lock<std::mutex> lock(mutex);
+        workAvailable.wait(lock, [this] { return queuedCount.load(std::memory_order_relaxed) > 0U || stopping; });
+        if (queuedCount.load(std::memory_order_relaxed) == 0U) break;
+    }
+
+    __currentPool = nullptr;
+    __currentWorkerIndex = -1;
+}
+
+void ThreadPool::submit(Task task) {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (capacity > 0U && __currentPool != this)
+            spaceAvailable.wait(lock, [this] { return pendingCount < capacity; });
+        ++pendingCount;
+        __push(std::move(task));
+    }
+    workAvailable.notify_one();
+}
+
+bool ThreadPool::trySubmit(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (capacity > 0U && pendingCount >= capacity) return false;
+        ++pendingCount;
+        __push(std::move(task));
+    }
+    workAvailable.notify_one();
+    return true;
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    allDone.wait(lock, [this] { return pendingCount == 0U && activeCount == 0U; });
+}
+
+unsigned int ThreadPool::getThreadCount() const noexcept {
+    return (unsigned int) threads.size();
+}
+
+std::size_t ThreadPool::getPendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pendingCount;
+}
+
+int ThreadPool::getCurrentWorkerIndex() noexcept {
+    return __currentWorkerIndex;
+}
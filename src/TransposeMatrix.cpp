@@ -1,4 +1,11 @@
 #include "../include/TransposeMatrix.hpp"
+#include "algorithm"
+#include "cmath"
+#if defined(__SSE2__) || defined(_M_X64)
+#include "emmintrin.h"
+#elif defined(__ARM_NEON)
+#include "arm_neon.h"
+#endif
 using namespace pdf;
 
 
@@ -34,3 +41,114 @@ float TransposeMatrix::getX() const noexcept {
 float TransposeMatrix::getY() const noexcept {
     return y;
 }
+
+TransposeMatrix TransposeMatrix::identity() noexcept {
+    return TransposeMatrix(1.f, 0.f, 0.f, 1.f, 0.f, 0.f);
+}
+
+TransposeMatrix TransposeMatrix::translation(float x, float y) noexcept {
+    return TransposeMatrix(1.f, 0.f, 0.f, 1.f, x, y);
+}
+
+TransposeMatrix TransposeMatrix::rotation(float angle) noexcept {
+    float cosine = std::cos(angle);
+    float sine = std::sin(angle);
+    return TransposeMatrix(cosine, sine, -sine, cosine, 0.f, 0.f);
+}
+
+TransposeMatrix TransposeMatrix::scaling(float x, float y) noexcept {
+    return TransposeMatrix(x, 0.f, 0.f, y, 0.f, 0.f);
+}
+
+TransposeMatrix TransposeMatrix::skewing(float alpha, float beta) noexcept {
+    return TransposeMatrix(1.f, std::tan(alpha), std::tan(beta), 1.f, 0.f, 0.f);
+}
+
+TransposeMatrix TransposeMatrix::operator*(const TransposeMatrix& other) const noexcept {
+    return TransposeMatrix(
+        a * other.a + b * other.c, a * other.b + b * other.d,
+        c * other.a + d * other.c, c * other.b + d * other.d,
+        x * other.a + y * other.c + other.x, x * other.b + y * other.d + other.y
+    );
+}
+
+TransposeMatrix& TransposeMatrix::operator*=(const TransposeMatrix& other) noexcept {
+    return *this = *this * other;
+}
+
+bool TransposeMatrix::operator==(const TransposeMatrix& other) const noexcept {
+    return a == other.a && b == other.b && c == other.c && d == other.d && x == other.x && y == other.y;
+}
+
+bool TransposeMatrix::operator!=(const TransposeMatrix& other) const noexcept {
+    return !operator==(other);
+}
+
+float TransposeMatrix::getDeterminant() const noexcept {
+    return a * d - b * c;
+}
+
+TransposeMatrix TransposeMatrix::inverse() const noexcept {
+    float determinant = getDeterminant();
+    if (determinant == 0.f || !std::isfinite(determinant)) return TransposeMatrix();
+    return TransposeMatrix(
+        d / determinant, -b / determinant, -c / determinant, a / determinant,
+        (c * y - d * x) / determinant, (b * x - a * y) / determinant
+    );
+}
+
+Coor2D TransposeMatrix::transform(const Coor2D& point) const noexcept {
+    return Coor2D(a * point.getX() + c * point.getY() + x, b * point.getX() + d * point.getY() + y);
+}
+
+Box TransposeMatrix::transform(const Box& box) const noexcept {
+    Coor2D corners[4] = {
+        transform(Coor2D(box.getLeft(), box.getBottom())), transform(Coor2D(box.getRight(), box.getBottom())),
+        transform(Coor2D(box.getLeft(), box.getTop())), transform(Coor2D(box.getRight(), box.getTop()))
+    };
+    float left = corners[0].getX(), right = corners[0].getX(), bottom = corners[0].getY(), top = corners[0].getY();
+    for (const Coor2D& corner: corners) {
+        left = std::min(left, corner.getX());
+        right = std::max(right, corner.getX());
+        bottom = std::min(bottom, corner.getY());
+        top = std::max(top, corner.getY());
+    }
+    return Box(left, bottom, right, top);
+}
+
+void TransposeMatrix::transform(const Coor2D* points, Coor2D* results, std::size_t count) const noexcept {
+    for (std::size_t i = 0U; i < count; ++i) results[i] = transform(points[i]);
+}
+
+void TransposeMatrix::transform(const float* points, float* results, std::size_t count) const noexcept {
+    // Each vector holds whole (x, y) pairs: the pair itself is scaled by (a, d), the swapped pair by (c, b)
+    std::size_t i = 0U;
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128 diagonal = _mm_setr_ps(a, d, a, d);
+    const __m128 antidiagonal = _mm_setr_ps(c, b, c, b);
+    const __m128 offset = _mm_setr_ps(x, y, x, y);
+    for (; i + 2U <= count; i += 2U) {
+        __m128 pair = _mm_loadu_ps(points + 2U * i);
+        __m128 swapped = _mm_shuffle_ps(pair, pair, _MM_SHUFFLE(2, 3, 0, 1));
+        __m128 result = _mm_add_ps(_mm_add_ps(_mm_mul_ps(pair, diagonal), _mm_mul_ps(swapped, antidiagonal)), offset);
+        _mm_storeu_ps(results + 2U * i, result);
+    }
+#elif defined(__ARM_NEON)
+    const float diagonalValues[4] = {a, d, a, d};
+    const float antidiagonalValues[4] = {c, b, c, b};
+    const float offsetValues[4] = {x, y, x, y};
+    const float32x4_t diagonal = vld1q_f32(diagonalValues);
+    const float32x4_t antidiagonal = vld1q_f32(antidiagonalValues);
+    const float32x4_t offset = vld1q_f32(offsetValues);
+    for (; i + 2U <= count; i += 2U) {
+        float32x4_t pair = vld1q_f32(points + 2U * i);
+        float32x4_t result = vmlaq_f32(vmlaq_f32(offset, pair, diagonal), vrev64q_f32(pair), antidiagonal);
+        vst1q_f32(results + 2U * i, result);
+    }
+#endif
+    for (; i < count; ++i) {
+        float px = points[2U * i], py = points[2U * i + 1U];
+        results[2U * i] = a * px + c * py + x;
+        results[2U * i + 1U] = b * px + d * py + y;
+    }
+}